@@ -0,0 +1,66 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "BenchmarkSupport.h"
+
+using namespace OnixSourcePlugin;
+
+std::shared_ptr<Onix1> OnixSourcePlugin::createBenchmarkContext (const std::string& driverName, int passthrough)
+{
+    auto context = std::make_shared<Onix1> (driverName);
+
+    context->setOption (ONIX_OPT_PASSTHROUGH, passthrough);
+    context->issueReset();
+
+    return context;
+}
+
+void OnixSourcePlugin::loadCalibrationFiles (Neuropixels1& probe)
+{
+    auto directory = File::getSpecialLocation (File::tempDirectory).getChildFile ("onix-decoder-benchmark");
+
+    if (directory.createDirectory().failed())
+        throw error_str ("Unable to create the calibration directory " + directory.getFullPathName().toStdString());
+
+    const auto serialNumber = std::to_string (probe.getProbeSerialNumber());
+
+    // NB: Same layout as the files provided with each probe; one line per ADC or electrode after the serial number
+    std::string adcText = serialNumber + "\n";
+    for (int i = 0; i < NeuropixelsV1Values::AdcCount; i++)
+        adcText += std::to_string (i) + ",16,16,0,0,0,0,0,512\n";
+
+    std::string gainText = serialNumber + "\n";
+    for (int i = 0; i < NeuropixelsV1Values::numberOfElectrodes; i++)
+        gainText += std::to_string (i) + ",1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1\n";
+
+    auto adcFile = directory.getChildFile (serialNumber + "_ADCCalibration.csv");
+    auto gainFile = directory.getChildFile (serialNumber + "_gainCalValues.csv");
+
+    if (! adcFile.replaceWithText (adcText) || ! gainFile.replaceWithText (gainText))
+        throw error_str ("Unable to write the calibration files for probe " + serialNumber);
+
+    probe.setAdcCalibrationFilePath (adcFile.getFullPathName().toStdString());
+    probe.setGainCalibrationFilePath (gainFile.getFullPathName().toStdString());
+
+    if (! probe.parseAdcCalibrationFile() || ! probe.parseGainCalibrationFile())
+        throw error_str ("Unable to load the calibration files for probe " + serialNumber);
+}
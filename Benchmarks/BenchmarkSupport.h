@@ -0,0 +1,41 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "../Source/Devices/Neuropixels1.h"
+
+namespace OnixSourcePlugin
+{
+/** Creates a context for the given driver, with passthrough enabled on the given ports, and resets it so that
+    the device table reflects the passthrough setting. ONIX_OPT_PASSTHROUGH uses bit 0 for port A, and bit 2 for port B. */
+std::shared_ptr<Onix1> createBenchmarkContext (const std::string& driverName, int passthrough);
+
+/**
+    Writes neutral calibration files for an emulated Neuropixels 1.0 probe and loads them. The emulated probes do not
+    have calibration files, but the decoder needs the ADC and gain corrections that are read from them.
+*/
+void loadCalibrationFiles (Neuropixels1& probe);
+} // namespace OnixSourcePlugin
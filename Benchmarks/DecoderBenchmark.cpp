@@ -0,0 +1,411 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+
+    Measures how long the processFrames method of each device takes to decode frames, without the GUI.
+
+    Devices are configured against the emulated hardware (see Drivers/EmulatorDriver.h), which also provides
+    the frames that are decoded. Frames are copied into the frame queue of a device in batches, and only the
+    call to processFrames is timed. Data buffers are cleared between batches, since nothing reads from them.
+
+    With --scaling, the full acquisition path is run in real time instead, with an increasing number of emulated
+    headstages behind one context (see ScalingBenchmark.h).
+
+    Decoders with vector kernels use the most capable instruction set the CPU supports, unless --isa caps it,
+    so that the kernels can be compared on one machine.
+
+    Usage: onix-decoder-benchmark [--seconds <s>] [--device <name>] [--isa <name>] [--csv]
+           onix-decoder-benchmark --scaling [--max-headstages <n>] [--config <name>] [--full] [--seconds <s>] [--isa <name>] [--csv]
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../Source/CpuFeatures.h"
+#include "../Source/Devices/DeviceList.h"
+#include "../Source/Devices/Neuropixels1e.h"
+#include "../Source/Drivers/EmulatorDriver.h"
+#include "BenchmarkSupport.h"
+#include "ScalingBenchmark.h"
+
+using namespace OnixSourcePlugin;
+
+namespace
+{
+/** Copy of a frame produced by the emulator */
+struct FrameTemplate
+{
+    uint64_t time;
+    oni_dev_idx_t deviceIndex;
+    std::vector<uint8_t> data;
+};
+
+struct BenchmarkCase
+{
+    std::string name;
+    std::shared_ptr<OnixDevice> device;
+    std::vector<FrameTemplate> frames;
+    OwnedArray<DataBuffer> buffers;
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    uint64_t samples = 0;
+    double seconds = 0.0;
+    double nominalFramesPerSecond = 0.0;
+};
+
+/** Frames kept per device; the emulator cycles through 64 payloads, so this covers every payload variant */
+constexpr size_t MaxTemplateFrames = 256;
+
+/** Emulated time after which template collection stops, so that slow devices do not hold up the benchmark */
+constexpr double MaxTemplateSeconds = 3.0;
+
+/** Largest number of frames queued before each call to processFrames */
+constexpr size_t MaxBatchFrames = 1024;
+
+/** Number of batches decoded before timing starts */
+constexpr int WarmupBatches = 16;
+
+/** Runs acquisition on the given context until each case has enough frames, and copies the frames of each case's device */
+void collectFrames (std::shared_ptr<Onix1> context, std::vector<BenchmarkCase*> cases)
+{
+    std::map<oni_dev_idx_t, BenchmarkCase*> casesByIndex;
+
+    for (auto benchmarkCase : cases)
+        casesByIndex[benchmarkCase->device->getDeviceIdx (true)] = benchmarkCase;
+
+    uint32_t clockHz = 0;
+    context->getOption (ONI_OPT_ACQCLKHZ, &clockHz);
+
+    context->setOption (ONI_OPT_RESETACQCOUNTER, 2);
+
+    auto isComplete = [&casesByIndex]
+    {
+        return std::all_of (casesByIndex.begin(), casesByIndex.end(), [] (const auto& entry)
+                            { return entry.second->frames.size() >= MaxTemplateFrames; });
+    };
+
+    while (! isComplete())
+    {
+        oni_frame_t* frame = context->readFrame();
+        if (frame == nullptr)
+            break;
+
+        auto it = casesByIndex.find (frame->dev_idx);
+
+        if (it != casesByIndex.end() && it->second->frames.size() < MaxTemplateFrames)
+            it->second->frames.push_back ({ frame->time, frame->dev_idx, std::vector<uint8_t> (frame->data, frame->data + frame->data_sz) });
+
+        const bool timedOut = frame->time > MaxTemplateSeconds * clockHz;
+
+        context->destroyFrame (frame);
+
+        if (timedOut)
+            break;
+    }
+
+    context->setOption (ONI_OPT_RUNNING, 0);
+}
+
+BenchmarkResult runCase (BenchmarkCase& benchmarkCase, double durationSeconds)
+{
+    auto& device = *benchmarkCase.device;
+
+    const size_t batchSize = std::min (MaxBatchFrames, device.getFrameQueueCapacity());
+
+    size_t nextFrame = 0;
+
+    auto decodeBatch = [&]
+    {
+        for (size_t i = 0; i < batchSize; i++)
+        {
+            const auto& source = benchmarkCase.frames[nextFrame++ % benchmarkCase.frames.size()];
+
+            auto frame = EmulatorDriver::createFrame (source.time, source.deviceIndex, (uint32_t) source.data.size());
+            std::memcpy (frame->data, source.data.data(), source.data.size());
+
+            device.addFrame (frame, LatencyProbe::now());
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        device.processFrames();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        for (auto buffer : benchmarkCase.buffers)
+            buffer->clear();
+
+        return std::chrono::duration<double> (elapsed).count();
+    };
+
+    for (int i = 0; i < WarmupBatches; i++)
+        decodeBatch();
+
+    BenchmarkResult result;
+
+    result.name = benchmarkCase.name;
+    result.nominalFramesPerSecond = device.getFramesPerSecond();
+
+    const auto framesBefore = device.getFramesReceived();
+    const auto bytesBefore = device.getBytesReceived();
+    const auto samplesBefore = device.getSamplesDecoded();
+
+    const auto end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration> (std::chrono::duration<double> (durationSeconds));
+
+    while (std::chrono::steady_clock::now() < end)
+        result.seconds += decodeBatch();
+
+    result.frames = device.getFramesReceived() - framesBefore;
+    result.bytes = device.getBytesReceived() - bytesBefore;
+    result.samples = device.getSamplesDecoded() - samplesBefore;
+
+    return result;
+}
+
+void printResults (const std::vector<BenchmarkResult>& results, bool csv)
+{
+    if (csv)
+        std::printf ("device,frames,ns_per_frame,samples_per_second,megabytes_per_second,realtime_factor\n");
+    else
+        std::printf ("%-16s %12s %12s %16s %10s %14s\n", "Device", "Frames", "ns/frame", "Samples/s", "MB/s", "x Real-time");
+
+    for (const auto& result : results)
+    {
+        const double nsPerFrame = result.frames > 0 ? result.seconds * 1e9 / result.frames : 0.0;
+        const double samplesPerSecond = result.seconds > 0.0 ? result.samples / result.seconds : 0.0;
+        const double megabytesPerSecond = result.seconds > 0.0 ? result.bytes / result.seconds / 1e6 : 0.0;
+        const double realTimeFactor = result.seconds > 0.0 ? result.frames / result.seconds / result.nominalFramesPerSecond : 0.0;
+
+        if (csv)
+            std::printf ("%s,%llu,%.2f,%.0f,%.2f,%.2f\n", result.name.c_str(), (unsigned long long) result.frames, nsPerFrame, samplesPerSecond, megabytesPerSecond, realTimeFactor);
+        else
+            std::printf ("%-16s %12llu %12.1f %16.0f %10.1f %14.1f\n", result.name.c_str(), (unsigned long long) result.frames, nsPerFrame, samplesPerSecond, megabytesPerSecond, realTimeFactor);
+    }
+}
+
+void printUsage()
+{
+    std::printf ("Usage: onix-decoder-benchmark [--seconds <s>] [--device <name>] [--isa <name>] [--csv]\n"
+                 "       onix-decoder-benchmark --scaling [--max-headstages <n>] [--config <name>] [--full] [--seconds <s>] [--isa <name>] [--csv]\n\n"
+                 "  --seconds <s>           Time spent decoding each device, or acquiring at each scaling step, default 2\n"
+                 "  --device <name>         Only benchmark the named device; may be repeated\n"
+                 "  --isa <name>            Most capable instruction set for decoders: Scalar, SSE4.1, AVX2, or AVX-512\n"
+                 "  --csv                   Print results as comma-separated values\n"
+                 "  --scaling               Add emulated NP1f headstages one at a time until decoding falls behind\n"
+                 "  --max-headstages <n>    Largest number of headstages in the scaling benchmark, default 16\n"
+                 "  --config <name>         Decode configuration: data, reader, or pool:<workers>; may be repeated\n"
+                 "  --full                  Keep adding headstages after the first step that falls behind\n");
+}
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    double durationSeconds = 2.0;
+    std::vector<std::string> selectedDevices;
+    bool csv = false;
+
+    bool scaling = false;
+    ScalingOptions scalingOptions;
+    std::vector<DecodeConfiguration> scalingConfigurations;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--seconds" && i + 1 < argc)
+            durationSeconds = std::atof (argv[++i]);
+        else if (arg == "--device" && i + 1 < argc)
+            selectedDevices.push_back (argv[++i]);
+        else if (arg == "--isa" && i + 1 < argc)
+        {
+            InstructionSet limit;
+
+            if (! CpuFeatures::parse (argv[++i], limit))
+            {
+                std::fprintf (stderr, "Unknown instruction set %s\n", argv[i]);
+                return 1;
+            }
+
+            CpuFeatures::setInstructionSetLimit (limit);
+        }
+        else if (arg == "--csv")
+            csv = true;
+        else if (arg == "--scaling")
+            scaling = true;
+        else if (arg == "--max-headstages" && i + 1 < argc)
+            scalingOptions.maxHeadstages = std::atoi (argv[++i]);
+        else if (arg == "--config" && i + 1 < argc)
+        {
+            try
+            {
+                scalingConfigurations.push_back (DecodeConfiguration::parse (argv[++i]));
+            }
+            catch (const error_str& e)
+            {
+                std::fprintf (stderr, "%s\n", e.what());
+                return 1;
+            }
+        }
+        else if (arg == "--full")
+            scalingOptions.continueAfterFailure = true;
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (scaling)
+    {
+        const int maxHeadstages = 2 + EmulatorSettings::MaxExtraHeadstages;
+
+        if (scalingOptions.maxHeadstages < 1 || scalingOptions.maxHeadstages > maxHeadstages)
+        {
+            std::fprintf (stderr, "The number of headstages must be between 1 and %d\n", maxHeadstages);
+            return 1;
+        }
+
+        if (! scalingConfigurations.empty())
+            scalingOptions.configurations = scalingConfigurations;
+
+        scalingOptions.secondsPerStep = durationSeconds;
+        scalingOptions.csv = csv;
+
+        return runScalingBenchmark (scalingOptions);
+    }
+
+    // NB: NP1f is only present on a port without passthrough, and NP1e and NP2e only on a port with it, so two
+    //     emulated hosts are used. ONIX_OPT_PASSTHROUGH uses bit 0 for port A, and bit 2 for port B.
+    std::shared_ptr<Onix1> breakoutContext, neuropixels1eContext;
+
+    try
+    {
+        breakoutContext = createBenchmarkContext ("emulator:A=np1f,B=np2e,rate=0", 1 << 2);
+        neuropixels1eContext = createBenchmarkContext ("emulator:A=np1e,B=none,rate=0", 1 << 0);
+    }
+    catch (const error_str& e)
+    {
+        std::fprintf (stderr, "Unable to create the emulated hardware: %s\n", e.what());
+        return 1;
+    }
+
+    const oni_dev_idx_t portA = OnixDevice::HubAddressPortA, portB = OnixDevice::HubAddressPortB;
+
+    // NB: Same offsets as the devices created by OnixSource and OnixSourceCanvas
+    static constexpr int AnalogIOOffset = 6, DigitalIOOffset = 7, MemoryMonitorOffset = 10, HarpSyncInputOffset = 12, BnoOffset = 2;
+
+    using DeviceFactory = std::function<std::shared_ptr<OnixDevice>()>;
+
+    const std::vector<std::tuple<std::string, std::shared_ptr<Onix1>, DeviceFactory>> factories = {
+        { "Neuropixels2e", breakoutContext, [&]
+          { return std::make_shared<Neuropixels2e> ("Neuropixels2e", "Port B", OnixDevice::getPassthroughIndexFromHubIndex (portB), breakoutContext); } },
+        { "Neuropixels1e", neuropixels1eContext, [&]
+          { return std::make_shared<Neuropixels1e> (ProbeString, "Port A", OnixDevice::getPassthroughIndexFromHubIndex (portA), neuropixels1eContext); } },
+        { "Neuropixels1f", breakoutContext, [&]
+          { return std::make_shared<Neuropixels1f> (ProbeString + "0", "Port A", portA, breakoutContext); } },
+        { "AnalogIO", breakoutContext, [&]
+          { return std::make_shared<AnalogIO> ("AnalogIO", "Breakout Board", AnalogIOOffset, breakoutContext); } },
+        { "DigitalIO", breakoutContext, [&]
+          { return std::make_shared<DigitalIO> ("DigitalIO", "Breakout Board", DigitalIOOffset, breakoutContext); } },
+        { "Bno055", breakoutContext, [&]
+          { return std::make_shared<Bno055> ("Bno055", "Port A", portA + BnoOffset, breakoutContext); } },
+        { "HarpSyncInput", breakoutContext, [&]
+          { return std::make_shared<HarpSyncInput> ("HarpSyncInput", "Breakout Board", HarpSyncInputOffset, breakoutContext); } },
+        { "MemoryMonitor", breakoutContext, [&]
+          { return std::make_shared<MemoryMonitor> ("MemoryMonitor", "Breakout Board", MemoryMonitorOffset, breakoutContext); } },
+    };
+
+    std::vector<std::unique_ptr<BenchmarkCase>> cases;
+    std::map<std::shared_ptr<Onix1>, std::vector<BenchmarkCase*>> casesByContext;
+
+    for (const auto& [name, context, factory] : factories)
+    {
+        if (! selectedDevices.empty() && std::find (selectedDevices.begin(), selectedDevices.end(), name) == selectedDevices.end())
+            continue;
+
+        auto benchmarkCase = std::make_unique<BenchmarkCase>();
+        benchmarkCase->name = name;
+
+        try
+        {
+            benchmarkCase->device = factory();
+
+            // NB: Some devices, such as HarpSyncInput, are disabled by default and would never produce frames
+            benchmarkCase->device->setEnabled (true);
+
+            if (benchmarkCase->device->configureDevice() != ONI_ESUCCESS)
+                throw error_str ("configureDevice failed");
+
+            if (auto probe = std::dynamic_pointer_cast<Neuropixels1> (benchmarkCase->device))
+                loadCalibrationFiles (*probe);
+        }
+        catch (const error_str& e)
+        {
+            std::fprintf (stderr, "Skipping %s: %s\n", name.c_str(), e.what());
+            continue;
+        }
+
+        uint32_t blockReadSize = 0;
+        context->getOption (ONI_OPT_BLOCKREADSIZE, &blockReadSize);
+
+        benchmarkCase->device->addSourceBuffers (benchmarkCase->buffers);
+        benchmarkCase->device->allocateFrameQueue (blockReadSize);
+        benchmarkCase->device->startAcquisition();
+
+        casesByContext[context].push_back (benchmarkCase.get());
+        cases.push_back (std::move (benchmarkCase));
+    }
+
+    for (const auto& [context, contextCases] : casesByContext)
+        collectFrames (context, contextCases);
+
+    std::vector<BenchmarkResult> results;
+
+    for (auto& benchmarkCase : cases)
+    {
+        if (benchmarkCase->frames.empty())
+        {
+            std::fprintf (stderr, "Skipping %s: no frames were produced by the emulated hardware\n", benchmarkCase->name.c_str());
+            continue;
+        }
+
+        results.push_back (runCase (*benchmarkCase, durationSeconds));
+    }
+
+    if (! csv)
+        std::printf ("Instruction set: %s\n\n", CpuFeatures::getName (CpuFeatures::getInstructionSet()).c_str());
+
+    printResults (results, csv);
+
+    return 0;
+}
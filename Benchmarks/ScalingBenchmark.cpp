@@ -0,0 +1,514 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ScalingBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <sys/resource.h>
+
+#include "../Source/DecodePool.h"
+#include "../Source/DeviceDiscovery.h"
+#include "../Source/FrameReader.h"
+#include "BenchmarkSupport.h"
+
+using namespace OnixSourcePlugin;
+
+namespace
+{
+/** Busy and total jiffies of each core, read from /proc/stat */
+struct CpuTimes
+{
+    std::vector<uint64_t> busy;
+    std::vector<uint64_t> total;
+
+    static CpuTimes read()
+    {
+        CpuTimes times;
+
+        std::ifstream stat ("/proc/stat");
+        std::string line;
+
+        while (std::getline (stat, line))
+        {
+            // NB: Per-core lines start with "cpu<n>"; the aggregate "cpu " line is skipped
+            if (line.compare (0, 3, "cpu") != 0 || line.size() < 4 || line[3] == ' ')
+                continue;
+
+            std::istringstream fields (line.substr (line.find (' ')));
+
+            uint64_t user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+            fields >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal;
+
+            const uint64_t busy = user + nice + system + irq + softirq + steal;
+
+            times.busy.push_back (busy);
+            times.total.push_back (busy + idle + iowait);
+        }
+
+        return times;
+    }
+
+    /** Returns the fraction of time each core was busy since the given earlier reading */
+    std::vector<double> getUtilizationSince (const CpuTimes& start) const
+    {
+        std::vector<double> utilization;
+
+        for (size_t i = 0; i < std::min (total.size(), start.total.size()); i++)
+        {
+            const uint64_t elapsed = total[i] - start.total[i];
+            utilization.push_back (elapsed > 0 ? (double) (busy[i] - start.busy[i]) / elapsed : 0.0);
+        }
+
+        return utilization;
+    }
+};
+
+/** User and system CPU time used by this process, in seconds */
+double getProcessCpuSeconds()
+{
+    rusage usage {};
+    getrusage (RUSAGE_SELF, &usage);
+
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+struct StepResult
+{
+    int headstages = 0;
+    int channels = 0;
+    uint32_t blockReadSize = 0;
+    double seconds = 0.0;
+    double megabytesPerSecond = 0.0;
+    double probeRateFraction = 0.0;
+    uint64_t overflows = 0;
+    double queueHighWaterFraction = 0.0;
+    std::string fullestQueue;
+    double readToBufferP99Milliseconds = 0.0;
+    double processCores = 0.0;
+    std::vector<double> coreUtilization;
+
+    /** Probe frames must arrive at this fraction of their nominal rate for a step to count as real time */
+    static constexpr double MinimumRateFraction = 0.98;
+
+    bool isRealTime() const { return overflows == 0 && probeRateFraction >= MinimumRateFraction; }
+};
+
+/** Reads every DataBuffer as the GUI would, so that the buffers never fill and their cost is included */
+class BufferDrain
+{
+public:
+    /** Adds the buffers of a device, which were added by addSourceBuffers starting at firstBuffer */
+    void addDevice (const OnixDevice& device, OwnedArray<DataBuffer>& buffers, int firstBuffer)
+    {
+        const int numBuffers = buffers.size() - firstBuffer;
+
+        // NB: Devices add either one buffer per stream, or a single buffer that holds every stream
+        for (int i = 0; i < numBuffers; i++)
+        {
+            int numChannels = 0;
+
+            if (numBuffers == device.streamInfos.size())
+                numChannels = device.streamInfos[i].getNumChannels();
+            else
+            {
+                for (const auto& streamInfo : device.streamInfos)
+                    numChannels += streamInfo.getNumChannels();
+            }
+
+            entries.push_back ({ buffers[firstBuffer + i], numChannels });
+            maxChannels = std::max (maxChannels, numChannels);
+        }
+    }
+
+    void drain()
+    {
+        for (const auto& [buffer, numChannels] : entries)
+        {
+            const int numSamples = buffer->getNumSamples();
+
+            if (numSamples == 0)
+                continue;
+
+            if (samples.getNumSamples() < numSamples || samples.getNumChannels() < maxChannels)
+            {
+                samples.setSize (maxChannels, std::max (samples.getNumSamples(), numSamples), false, false, true);
+                sampleNumbers.resize (samples.getNumSamples());
+                timestamps.resize (samples.getNumSamples());
+                eventCodes.resize (samples.getNumSamples());
+            }
+
+            buffer->readAllFromBuffer (samples, sampleNumbers.data(), timestamps.data(), eventCodes.data(), numSamples, 0, numChannels);
+        }
+    }
+
+private:
+    std::vector<std::pair<DataBuffer*, int>> entries;
+    int maxChannels = 0;
+
+    AudioBuffer<float> samples;
+    std::vector<int64> sampleNumbers;
+    std::vector<double> timestamps;
+    std::vector<uint64> eventCodes;
+};
+
+/** Emulator driver name with NP1f headstages on port A, port B, and then on extra hubs */
+std::string getDriverName (int numHeadstages)
+{
+    return std::string ("emulator:A=") + (numHeadstages >= 1 ? "np1f" : "none")
+           + ",B=" + (numHeadstages >= 2 ? "np1f" : "none")
+           + ",extra=" + std::to_string (std::max (0, numHeadstages - 2))
+           + ",rate=1";
+}
+
+/** Time between checks of the elapsed time when frames are decoded by other threads */
+constexpr std::chrono::microseconds FrameWaitTimeout { 10000 };
+
+StepResult runStep (const DecodeConfiguration& configuration, int numHeadstages, double seconds)
+{
+    auto context = createBenchmarkContext (getDriverName (numHeadstages), 0);
+
+    device_map_t deviceTable;
+    if (context->getDeviceTable (&deviceTable) != ONI_ESUCCESS)
+        throw error_str ("Unable to read the device table of the emulated hardware");
+
+    auto factory = [&context] (OnixDeviceType type, std::string name, std::string hubName, oni_dev_idx_t deviceIndex)
+    {
+        auto device = DeviceDiscovery::createDevice (type, name, hubName, deviceIndex, context);
+
+        // NB: Some devices, such as HarpSyncInput, are disabled by default and would never produce frames
+        if (device != nullptr)
+            device->setEnabled (true);
+
+        return device;
+    };
+
+    OnixDeviceVector devices;
+    std::map<int, std::string> hubNames;
+
+    if (! DeviceDiscovery::discoverDevices (context, deviceTable, factory, devices, hubNames))
+        throw error_str ("Unable to configure the emulated devices");
+
+    StepResult result;
+    result.headstages = numHeadstages;
+
+    OwnedArray<DataBuffer> buffers;
+    BufferDrain bufferDrain;
+
+    double bytesPerSecond = 0.0, probeFramesPerSecond = 0.0;
+
+    for (const auto& device : devices)
+    {
+        if (auto probe = std::dynamic_pointer_cast<Neuropixels1> (device))
+        {
+            loadCalibrationFiles (*probe);
+            probeFramesPerSecond += device->getFramesPerSecond();
+        }
+
+        const int firstBuffer = buffers.size();
+        device->addSourceBuffers (buffers);
+        bufferDrain.addDevice (*device, buffers, firstBuffer);
+
+        for (const auto& streamInfo : device->streamInfos)
+            result.channels += streamInfo.getNumChannels();
+
+        bytesPerSecond += device->getFramesPerSecond() * (Onix1::FrameHeaderSize + deviceTable.at (device->getDeviceIdx (true)).read_size);
+    }
+
+    // NB: Same block read size as the automatic setting of OnixSource
+    oni_size_t maxReadFrameSize = 0;
+    context->getOption<oni_size_t> (ONI_OPT_MAXREADFRAMESIZE, &maxReadFrameSize);
+
+    std::string rationale;
+    result.blockReadSize = BlockReadSizeTuner::estimate (bytesPerSecond, BlockReadSizeTuner::DefaultTargetLatencyMilliseconds * 1e-3, maxReadFrameSize, rationale);
+
+    if (context->setOption (ONI_OPT_BLOCKREADSIZE, result.blockReadSize) != ONI_ESUCCESS)
+        throw error_str ("Unable to set the block read size to " + std::to_string (result.blockReadSize) + " bytes");
+
+    for (const auto& device : devices)
+    {
+        device->allocateFrameQueue (result.blockReadSize);
+        device->startAcquisition();
+    }
+
+    std::unique_ptr<DecodePool> decodePool;
+
+    if (configuration.mode == DecodeConfiguration::Mode::Pool)
+    {
+        decodePool = std::make_unique<DecodePool> (devices, deviceTable, configuration.workers);
+        decodePool->startWorkers();
+    }
+
+    context->setOption (ONI_OPT_RESETACQCOUNTER, 2);
+
+    FrameReader frameReader (devices, FrameReader::createDispatchTable (devices), context, configuration.mode == DecodeConfiguration::Mode::ReaderThread);
+    frameReader.startThread();
+
+    const auto cpuStart = CpuTimes::read();
+    const double processCpuStart = getProcessCpuSeconds();
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration> (std::chrono::duration<double> (seconds));
+
+    while (std::chrono::steady_clock::now() < end)
+    {
+        // NB: Mirrors OnixSource::updateBuffer for each configuration
+        if (configuration.mode == DecodeConfiguration::Mode::ReaderThread)
+        {
+            std::this_thread::sleep_for (FrameWaitTimeout);
+        }
+        else if (frameReader.waitForFrames (FrameWaitTimeout))
+        {
+            if (decodePool != nullptr)
+                decodePool->notify();
+            else
+            {
+                for (const auto& device : devices)
+                    device->processQueuedFrames();
+            }
+        }
+
+        bufferDrain.drain();
+    }
+
+    result.seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - start).count();
+    result.processCores = (getProcessCpuSeconds() - processCpuStart) / result.seconds;
+    result.coreUtilization = CpuTimes::read().getUtilizationSince (cpuStart);
+
+    // NB: Stopping the hardware makes a blocked read return, so the reader always exits before the queues are drained
+    frameReader.signalThreadShouldExit();
+    frameReader.wakeWaitingThread();
+    context->setOption (ONI_OPT_RUNNING, 0);
+    frameReader.waitForThreadToExit (-1);
+
+    if (decodePool != nullptr)
+        decodePool->stopWorkers();
+
+    uint64_t bytes = 0, probeFrames = 0;
+
+    for (const auto& device : devices)
+    {
+        bytes += device->getBytesReceived();
+        result.overflows += device->getFrameQueueOverflowCount();
+
+        if (std::dynamic_pointer_cast<Neuropixels1> (device) != nullptr)
+            probeFrames += device->getFramesReceived();
+
+        const double queueFraction = device->getFrameQueueCapacity() > 0 ? (double) device->getFrameQueueHighWaterMark() / device->getFrameQueueCapacity() : 0.0;
+
+        if (queueFraction > result.queueHighWaterFraction)
+        {
+            result.queueHighWaterFraction = queueFraction;
+            result.fullestQueue = device->getHubName() + " " + device->getName();
+        }
+
+        const auto& latency = device->getLatencyProbe().getHistogram (LatencyProbe::Stage::ReadToBuffer);
+
+        if (latency.getCount() > 0)
+            result.readToBufferP99Milliseconds = std::max (result.readToBufferP99Milliseconds, latency.getPercentile (99.0) * 1e-6);
+
+        device->stopAcquisition();
+    }
+
+    result.megabytesPerSecond = bytes / result.seconds / 1e6;
+    result.probeRateFraction = probeFramesPerSecond > 0.0 ? probeFrames / (probeFramesPerSecond * result.seconds) : 1.0;
+
+    return result;
+}
+
+std::string formatCoreUtilization (const std::vector<double>& utilization, const char* separator)
+{
+    std::string text;
+
+    for (size_t i = 0; i < utilization.size(); i++)
+    {
+        if (i > 0)
+            text += separator;
+
+        text += std::to_string ((int) std::lround (utilization[i] * 100.0));
+    }
+
+    return text;
+}
+
+void printResult (const DecodeConfiguration& configuration, const StepResult& result, bool csv)
+{
+    const double busiestCore = result.coreUtilization.empty() ? 0.0 : *std::max_element (result.coreUtilization.begin(), result.coreUtilization.end());
+
+    if (csv)
+    {
+        std::printf ("%s,%d,%d,%u,%.2f,%.4f,%llu,%.4f,%.3f,%.2f,%s,%d\n",
+                     configuration.getName().c_str(),
+                     result.headstages,
+                     result.channels,
+                     result.blockReadSize,
+                     result.megabytesPerSecond,
+                     result.probeRateFraction,
+                     (unsigned long long) result.overflows,
+                     result.queueHighWaterFraction,
+                     result.readToBufferP99Milliseconds,
+                     result.processCores,
+                     formatCoreUtilization (result.coreUtilization, ";").c_str(),
+                     result.isRealTime() ? 1 : 0);
+    }
+    else
+    {
+        std::printf ("%10d %9d %8u %9.1f %7.1f %10llu %8.1f %9.2f %8.2f %9.0f   %s\n",
+                     result.headstages,
+                     result.channels,
+                     result.blockReadSize,
+                     result.megabytesPerSecond,
+                     result.probeRateFraction * 100.0,
+                     (unsigned long long) result.overflows,
+                     result.queueHighWaterFraction * 100.0,
+                     result.readToBufferP99Milliseconds,
+                     result.processCores,
+                     busiestCore * 100.0,
+                     result.isRealTime() ? "yes" : "NO");
+
+        std::printf ("%10s core %%: %s", "", formatCoreUtilization (result.coreUtilization, " ").c_str());
+
+        if (result.queueHighWaterFraction > 0.0)
+            std::printf ("; fullest queue: %s", result.fullestQueue.c_str());
+
+        std::printf ("\n");
+    }
+
+    std::fflush (stdout);
+}
+} // namespace
+
+std::string DecodeConfiguration::getName() const
+{
+    switch (mode)
+    {
+        case Mode::DataThread:
+            return "data";
+        case Mode::ReaderThread:
+            return "reader";
+        case Mode::Pool:
+            return "pool:" + std::to_string (workers);
+        default:
+            return "";
+    }
+}
+
+DecodeConfiguration DecodeConfiguration::parse (const std::string& name)
+{
+    DecodeConfiguration configuration;
+
+    if (name == "data")
+        configuration.mode = Mode::DataThread;
+    else if (name == "reader")
+        configuration.mode = Mode::ReaderThread;
+    else if (name.compare (0, 5, "pool:") == 0)
+    {
+        configuration.mode = Mode::Pool;
+
+        try
+        {
+            configuration.workers = std::stoi (name.substr (5));
+        }
+        catch (const std::exception&)
+        {
+            throw error_str ("Invalid number of decode workers in '" + name + "'.");
+        }
+
+        if (configuration.workers < 1 || configuration.workers > DecodePool::MaxWorkers)
+            throw error_str ("The number of decode workers must be between 1 and " + std::to_string (DecodePool::MaxWorkers) + ".");
+    }
+    else
+        throw error_str ("Unknown decode configuration '" + name + "'. Expected data, reader, or pool:<workers>.");
+
+    return configuration;
+}
+
+std::vector<DecodeConfiguration> DecodeConfiguration::getDefaults()
+{
+    std::vector<DecodeConfiguration> configurations = { parse ("data"), parse ("reader") };
+
+    // NB: The reader and the data thread need a core each, so larger pools would only compete with them
+    const int availableCores = (int) std::thread::hardware_concurrency() - 2;
+
+    for (int workers = 2; workers <= std::min (availableCores, DecodePool::MaxWorkers); workers *= 2)
+        configurations.push_back (parse ("pool:" + std::to_string (workers)));
+
+    return configurations;
+}
+
+int OnixSourcePlugin::runScalingBenchmark (const ScalingOptions& options)
+{
+    if (options.csv)
+        std::printf ("configuration,headstages,channels,block_read_size,megabytes_per_second,probe_rate_fraction,overflows,queue_high_water_fraction,p99_read_to_buffer_ms,process_cores,core_utilization_percent,realtime\n");
+
+    std::vector<std::pair<DecodeConfiguration, StepResult>> lastRealTimeSteps;
+
+    for (const auto& configuration : options.configurations)
+    {
+        if (! options.csv)
+        {
+            std::printf ("\nDecode configuration: %s\n", configuration.getName().c_str());
+            std::printf ("%10s %9s %8s %9s %7s %10s %8s %9s %8s %9s   %s\n", "Headstages", "Channels", "Block", "MB/s", "Rate %", "Overflows", "Queue %", "p99 ms", "Cores", "Busiest %", "Real-time");
+        }
+
+        StepResult lastRealTime;
+
+        for (int headstages = 1; headstages <= options.maxHeadstages; headstages++)
+        {
+            StepResult result;
+
+            try
+            {
+                result = runStep (configuration, headstages, options.secondsPerStep);
+            }
+            catch (const error_str& e)
+            {
+                std::fprintf (stderr, "Unable to run %d headstages with %s: %s\n", headstages, configuration.getName().c_str(), e.what());
+                return 1;
+            }
+
+            printResult (configuration, result, options.csv);
+
+            if (result.isRealTime())
+                lastRealTime = result;
+            else if (! options.continueAfterFailure)
+                break;
+        }
+
+        lastRealTimeSteps.push_back ({ configuration, lastRealTime });
+    }
+
+    if (! options.csv)
+    {
+        std::printf ("\nLargest real-time step for each configuration (rate >= %.0f%% of nominal, no frame queue overflows):\n", StepResult::MinimumRateFraction * 100.0);
+        std::printf ("%-14s %10s %9s %9s\n", "Configuration", "Headstages", "Channels", "MB/s");
+
+        for (const auto& [configuration, result] : lastRealTimeSteps)
+            std::printf ("%-14s %10d %9d %9.1f\n", configuration.getName().c_str(), result.headstages, result.channels, result.megabytesPerSecond);
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace OnixSourcePlugin
+{
+/** How decoding is distributed across threads, matching the options of OnixSource */
+struct DecodeConfiguration
+{
+    enum class Mode
+    {
+        DataThread, // NB: A single consumer thread waits for frames and calls processFrames, as OnixSource does by default
+        ReaderThread, // NB: Frames are decoded by the FrameReader as soon as they are read
+        Pool // NB: A DecodePool with the given number of workers
+    };
+
+    Mode mode = Mode::DataThread;
+    int workers = 0;
+
+    std::string getName() const;
+
+    /** Parses "data", "reader", or "pool:<workers>". Throws error_str if the name cannot be parsed. */
+    static DecodeConfiguration parse (const std::string& name);
+
+    /** Returns the data and reader thread configurations, and pools of 2, 4 and 8 workers that fit on this machine */
+    static std::vector<DecodeConfiguration> getDefaults();
+};
+
+struct ScalingOptions
+{
+    std::vector<DecodeConfiguration> configurations = DecodeConfiguration::getDefaults();
+
+    /** Largest number of emulated NP1f headstages; each step adds one */
+    int maxHeadstages = 16;
+
+    /** Time spent acquiring in real time at each step */
+    double secondsPerStep = 2.0;
+
+    /** Keeps adding headstages after the first step that could not keep real time */
+    bool continueAfterFailure = false;
+
+    bool csv = false;
+};
+
+/**
+
+    Ramps the number of emulated NP1f headstages behind one context from 1 to maxHeadstages, together with the
+    breakout board, and runs the full acquisition path (FrameReader, decoding, and draining the DataBuffers) in
+    real time for each decode configuration. Reports the aggregate channel count, the throughput relative to the
+    nominal rate, frame queue overflows and high-water marks, latency, and the utilization of each core, and the
+    largest number of headstages that kept real time.
+
+    The emulator generates frames on the FrameReader thread, so each step also includes the cost of producing the
+    frames, which the hardware does not add. Only runs on Linux, where core utilization is read from /proc/stat.
+
+    Returns the process exit code.
+
+*/
+int runScalingBenchmark (const ScalingOptions& options);
+} // namespace OnixSourcePlugin
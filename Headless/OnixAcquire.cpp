@@ -0,0 +1,663 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+
+    Connects to ONIX hardware without the GUI, configures it from a settings file, and streams the decoded data
+    of every enabled device to a binary file, until the given duration has elapsed or Ctrl+C is pressed.
+
+    Usage: onix-acquire --settings <file.json> --output <file> [--seconds <s>]
+
+    The settings file is a JSON object; every field is optional:
+
+    {
+        "driver": "riffa",                           ONI driver, or emulator / replay (see README.md)
+        "portA": { "headstage": "Neuropixels 1.0f Headstage", "voltage": "Auto" },
+        "portB": { "headstage": "None" },
+        "blockReadSize": 4096,                       bytes
+        "decodeThreads": 0,                          zero decodes every device on the main thread
+        "calibrationDirectory": "/path/to/files",    searched for <serial number>_ADCCalibration.csv and
+                                                     <serial number>_gainCalValues.csv
+        "disabledDevices": [ "Analog IO" ],          names, or device types, of devices to leave disabled
+        "traceFile": "trace.json",                   if set, a Chrome trace of the acquisition threads is
+                                                     written here when acquisition stops
+        "metricsFile": "metrics.csv",                if set, counters and gauges are appended here during
+                                                     acquisition, as CSV or, for *.ndjson, as JSON lines
+        "metricsInterval": 10,                       seconds between metrics snapshots
+        "advanceSampleNumbersOnGaps": false,         if true, sample numbers skip over frames found missing
+                                                     from the device clocks
+        "trackOffsetDrift": false                    if true, Neuropixels 1.0 channel offsets keep following
+                                                     slow drift after they are first calculated
+    }
+
+    Output format (little-endian):
+        Header:  "ONIXDAT\0", format version (u32), number of streams (u32),
+                 then for each stream: name length (u32), name (UTF-8), channels (u32), sample rate in Hz (f64)
+        Blocks:  stream index (u32), number of samples n (u32), sample numbers (i64 x n), timestamps in
+                 seconds (f64 x n), event codes (u64 x n), samples (f32 x channels x n, one channel after another)
+
+*/
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../Source/AsyncLogger.h"
+#include "../Source/DecodePool.h"
+#include "../Source/DeviceDiscovery.h"
+#include "../Source/Devices/DeviceList.h"
+#include "../Source/Devices/Neuropixels1e.h"
+#include "../Source/FrameReader.h"
+#include "../Source/MetricsLogger.h"
+
+using namespace OnixSourcePlugin;
+
+namespace
+{
+struct PortSettings
+{
+    std::string headstage = "None";
+    std::string voltage = "Auto";
+};
+
+struct AcquireSettings
+{
+    std::string driver = Onix1::getDefaultDriverName();
+    PortSettings portA, portB;
+    uint32_t blockReadSize = 4096;
+    int decodeThreads = 0;
+    std::string calibrationDirectory;
+    std::vector<std::string> disabledDevices;
+    std::string traceFile;
+    std::string metricsFile;
+    int metricsInterval = MetricsLogger::DefaultIntervalSeconds;
+    bool advanceSampleNumbersOnGaps = false;
+    bool trackOffsetDrift = false;
+};
+
+/** A DataBuffer of one device, and the data stream written for it */
+struct OutputStream
+{
+    DataBuffer* buffer;
+    std::string name;
+    int numChannels;
+    double sampleRate;
+};
+
+/** Magic bytes at the start of every output file */
+constexpr char Magic[8] = { 'O', 'N', 'I', 'X', 'D', 'A', 'T', '\0' };
+
+constexpr uint32_t FormatVersion = 1;
+
+/** Same suffixes as the calibration files provided with each probe, which are prefixed with its serial number */
+constexpr const char* AdcCalibrationSuffix = "_ADCCalibration.csv";
+constexpr const char* GainCalibrationSuffix = "_gainCalValues.csv";
+
+/** Maximum time the main thread waits for new frames, so that stop requests are seen promptly */
+constexpr std::chrono::microseconds FrameWaitTimeout { 10000 };
+
+std::atomic<bool> interrupted = false;
+
+void handleInterrupt (int)
+{
+    interrupted = true;
+}
+
+PortSettings parsePortSettings (const var& json)
+{
+    PortSettings port;
+
+    if (json.isObject())
+    {
+        port.headstage = json.getProperty ("headstage", String (port.headstage)).toString().toStdString();
+        port.voltage = json.getProperty ("voltage", String (port.voltage)).toString().toStdString();
+    }
+
+    return port;
+}
+
+AcquireSettings loadSettings (File file)
+{
+    auto json = JSON::parse (file);
+
+    if (! json.isObject())
+        throw error_str ("The settings file '" + file.getFullPathName().toStdString() + "' could not be parsed as a JSON object.");
+
+    AcquireSettings settings;
+
+    settings.driver = json.getProperty ("driver", String (settings.driver)).toString().toStdString();
+    settings.portA = parsePortSettings (json.getProperty ("portA", var()));
+    settings.portB = parsePortSettings (json.getProperty ("portB", var()));
+    settings.blockReadSize = (uint32_t) (int) json.getProperty ("blockReadSize", (int) settings.blockReadSize);
+    settings.decodeThreads = std::max (0, (int) json.getProperty ("decodeThreads", settings.decodeThreads));
+    settings.calibrationDirectory = json.getProperty ("calibrationDirectory", String()).toString().toStdString();
+    settings.traceFile = json.getProperty ("traceFile", String()).toString().toStdString();
+    settings.metricsFile = json.getProperty ("metricsFile", String()).toString().toStdString();
+    settings.metricsInterval = std::max (1, (int) json.getProperty ("metricsInterval", settings.metricsInterval));
+    settings.advanceSampleNumbersOnGaps = json.getProperty ("advanceSampleNumbersOnGaps", false);
+    settings.trackOffsetDrift = json.getProperty ("trackOffsetDrift", false);
+
+    if (auto disabled = json.getProperty ("disabledDevices", var()).getArray())
+    {
+        for (const auto& name : *disabled)
+            settings.disabledDevices.push_back (name.toString().toStdString());
+    }
+
+    return settings;
+}
+
+/** Returns true if the device is named in the list, either by its name or by its device type */
+bool isListed (const std::vector<std::string>& names, std::string name, OnixDeviceType type)
+{
+    return std::find (names.begin(), names.end(), name) != names.end()
+           || std::find (names.begin(), names.end(), OnixDevice::TypeString.at (type)) != names.end();
+}
+
+bool isPassthroughHeadstage (const std::string& headstage)
+{
+    return headstage == NEUROPIXELSV1E_HEADSTAGE_NAME || headstage == NEUROPIXELSV2E_HEADSTAGE_NAME;
+}
+
+/** Sets the voltage of a port as the editor does: searched for when a headstage is given, otherwise only if a voltage is given */
+bool configurePort (PortController& port, const PortSettings& settings)
+{
+    if (port.configureDevice() != ONI_ESUCCESS)
+    {
+        LOGE ("Unable to configure ", port.getPortNameString(), ".");
+        return false;
+    }
+
+    port.updateDiscoveryParameters (PortController::getHeadstageDiscoveryParameters (settings.headstage));
+
+    if (settings.headstage == "None" && settings.voltage == "Auto")
+    {
+        port.setVoltageOverride (0, false);
+        return true;
+    }
+
+    const bool locked = settings.voltage == "Auto" ? port.configureVoltage() : port.configureVoltage (std::stod (settings.voltage));
+
+    if (! locked)
+    {
+        LOGE ("Unable to acquire communication lock on ", port.getPortNameString(), ".");
+        return false;
+    }
+
+    LOGC (port.getPortNameString(), " locked at ", port.getLastVoltageSet(), " V");
+
+    return true;
+}
+
+/** Points each probe at the calibration files named after its serial number in the given directory */
+void setCalibrationFiles (OnixDevice& device, File directory)
+{
+    auto type = device.getDeviceType();
+
+    if (type == OnixDeviceType::NEUROPIXELSV1E || type == OnixDeviceType::NEUROPIXELSV1F)
+    {
+        auto& probe = static_cast<Neuropixels1&> (device);
+        auto serialNumber = std::to_string (probe.getProbeSerialNumber());
+
+        probe.setAdcCalibrationFilePath (directory.getChildFile (serialNumber + AdcCalibrationSuffix).getFullPathName().toStdString());
+        probe.setGainCalibrationFilePath (directory.getChildFile (serialNumber + GainCalibrationSuffix).getFullPathName().toStdString());
+    }
+    else if (type == OnixDeviceType::NEUROPIXELSV2E)
+    {
+        auto& probe = static_cast<Neuropixels2e&> (device);
+
+        for (int i = 0; i < (int) probe.settings.size(); i++)
+        {
+            if (probe.settings[i]->connected)
+                probe.setGainCorrectionFile (i, directory.getChildFile (std::to_string (probe.getProbeSerialNumber (i)) + GainCalibrationSuffix).getFullPathName().toStdString());
+        }
+    }
+}
+
+/** Matches each DataBuffer of the device to the stream it holds. Devices either add one buffer per stream, or
+    a single buffer that holds every stream, as OnixSource does when it creates combined data streams. */
+bool addOutputStreams (OnixDevice& device, OwnedArray<DataBuffer>& buffers, int firstBuffer, std::vector<OutputStream>& streams)
+{
+    const int numBuffers = buffers.size() - firstBuffer;
+
+    if (numBuffers == device.streamInfos.size())
+    {
+        for (int i = 0; i < numBuffers; i++)
+        {
+            const auto& streamInfo = device.streamInfos[i];
+            streams.push_back ({ buffers[firstBuffer + i], streamInfo.getName(), streamInfo.getNumChannels(), streamInfo.getSampleRate() });
+        }
+
+        return true;
+    }
+
+    if (numBuffers == 1 && device.streamInfos.size() > 0)
+    {
+        int numChannels = 0;
+
+        for (const auto& streamInfo : device.streamInfos)
+            numChannels += streamInfo.getNumChannels();
+
+        streams.push_back ({ buffers[firstBuffer], device.createStreamName(), numChannels, device.streamInfos[0].getSampleRate() });
+
+        return true;
+    }
+
+    LOGE (device.getName(), " added ", numBuffers, " buffers for ", device.streamInfos.size(), " streams. It will not be written to the output file.");
+
+    return false;
+}
+
+class OutputFile
+{
+public:
+    OutputFile (File file_) : file (file_) {}
+
+    bool open (const std::vector<OutputStream>& streams)
+    {
+        stream = std::make_unique<FileOutputStream> (file, StreamBufferSize);
+
+        // NB: FileOutputStream appends to an existing file, so it is rewound before truncating
+        if (stream->failedToOpen() || ! stream->setPosition (0) || stream->truncate().failed())
+            return false;
+
+        stream->write (Magic, sizeof (Magic));
+        stream->writeInt ((int) FormatVersion);
+        stream->writeInt ((int) streams.size());
+
+        for (const auto& outputStream : streams)
+        {
+            stream->writeInt ((int) outputStream.name.size());
+            stream->write (outputStream.name.data(), outputStream.name.size());
+            stream->writeInt (outputStream.numChannels);
+            stream->writeDouble (outputStream.sampleRate);
+        }
+
+        return true;
+    }
+
+    /** Reads every sample waiting in the buffer of the stream, and appends it to the file as one block */
+    void writeAvailableSamples (uint32_t streamIndex, const OutputStream& outputStream)
+    {
+        const int numSamples = outputStream.buffer->getNumSamples();
+
+        if (numSamples == 0)
+            return;
+
+        if (samples.getNumChannels() < outputStream.numChannels || samples.getNumSamples() < numSamples)
+            samples.setSize (std::max (samples.getNumChannels(), outputStream.numChannels), std::max (samples.getNumSamples(), numSamples), false, false, true);
+
+        sampleNumbers.resize (std::max (sampleNumbers.size(), (size_t) numSamples));
+        timestamps.resize (sampleNumbers.size());
+        eventCodes.resize (sampleNumbers.size());
+
+        const int numRead = outputStream.buffer->readAllFromBuffer (samples, sampleNumbers.data(), timestamps.data(), eventCodes.data(), numSamples, 0, outputStream.numChannels);
+
+        if (numRead <= 0)
+            return;
+
+        stream->writeInt ((int) streamIndex);
+        stream->writeInt (numRead);
+        stream->write (sampleNumbers.data(), numRead * sizeof (int64));
+        stream->write (timestamps.data(), numRead * sizeof (double));
+        stream->write (eventCodes.data(), numRead * sizeof (uint64));
+
+        for (int channel = 0; channel < outputStream.numChannels; channel++)
+            stream->write (samples.getReadPointer (channel), numRead * sizeof (float));
+
+        samplesWritten += numRead;
+    }
+
+    void close()
+    {
+        if (stream != nullptr)
+            stream->flush();
+
+        stream.reset();
+    }
+
+    uint64_t getSamplesWritten() const { return samplesWritten; }
+
+    File getFile() const { return file; }
+
+private:
+    static constexpr size_t StreamBufferSize = 1 << 22;
+
+    const File file;
+
+    std::unique_ptr<FileOutputStream> stream;
+
+    AudioBuffer<float> samples;
+    std::vector<int64> sampleNumbers;
+    std::vector<double> timestamps;
+    std::vector<uint64> eventCodes;
+
+    uint64_t samplesWritten = 0;
+};
+
+void printUsage()
+{
+    std::printf ("Usage: onix-acquire --settings <file.json> --output <file> [--seconds <s>]\n\n"
+                 "  --settings <file>  JSON file with the driver, headstages, and acquisition settings\n"
+                 "  --output <file>    Binary file that the decoded data is written to\n"
+                 "  --seconds <s>      Stop after this long; by default acquisition runs until Ctrl+C is pressed\n");
+}
+} // namespace
+
+int main (int argc, char* argv[])
+{
+    String settingsPath, outputPath;
+    double durationSeconds = 0.0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--settings" && i + 1 < argc)
+            settingsPath = argv[++i];
+        else if (arg == "--output" && i + 1 < argc)
+            outputPath = argv[++i];
+        else if (arg == "--seconds" && i + 1 < argc)
+            durationSeconds = std::atof (argv[++i]);
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (outputPath.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    auto outputFile = File::getCurrentWorkingDirectory().getChildFile (outputPath);
+
+    auto statusReporter = std::make_shared<LogStatusReporter>();
+    Onix1::setStatusReporter (statusReporter);
+
+    AcquireSettings settings;
+    std::shared_ptr<Onix1> context;
+
+    try
+    {
+        if (settingsPath.isNotEmpty())
+            settings = loadSettings (File::getCurrentWorkingDirectory().getChildFile (settingsPath));
+
+        context = std::make_shared<Onix1> (settings.driver);
+    }
+    catch (const std::exception& e)
+    {
+        LOGE ("Unable to connect: ", e.what());
+        return 1;
+    }
+
+    LOGC ("Using ONI driver ", context->getDriverName());
+
+    // NB: Tracing starts before the ports are configured, so that voltage discovery is part of the trace
+    TraceRecorder::setEnabled (settings.traceFile != "");
+
+    auto portA = std::make_shared<PortController> (PortName::PortA, context);
+    auto portB = std::make_shared<PortController> (PortName::PortB, context);
+
+    if (! configurePort (*portA, settings.portA) || ! configurePort (*portB, settings.portB))
+        return 1;
+
+    if (! DeviceDiscovery::enablePassthroughMode (context, isPassthroughHeadstage (settings.portA.headstage), isPassthroughHeadstage (settings.portB.headstage)))
+        return 1;
+
+    device_map_t deviceTable;
+
+    if (context->getDeviceTable (&deviceTable) != ONI_ESUCCESS || deviceTable.empty())
+    {
+        LOGE ("No devices were found on the connected hardware.");
+        return 1;
+    }
+
+    if (! DeviceDiscovery::checkHubFirmwareCompatibility (context, deviceTable))
+        return 1;
+
+    const auto& disabled = settings.disabledDevices;
+
+    auto factory = [&context, &disabled] (OnixDeviceType type, std::string name, std::string hubName, oni_dev_idx_t deviceIndex)
+    {
+        auto device = DeviceDiscovery::createDevice (type, name, hubName, deviceIndex, context);
+
+        if (device == nullptr)
+        {
+            LOGE ("Unable to create ", name, " on ", hubName, ".");
+            return device;
+        }
+
+        const bool isDisabled = isListed (disabled, name, type);
+
+        // NB: Devices are enabled or disabled in hardware when they are configured, so this is set before discovery
+        //     configures them. Some devices, such as HarpSyncInput, are otherwise disabled until their settings tab enables them.
+        device->setEnabled (! isDisabled);
+
+        return device;
+    };
+
+    OnixDeviceVector devices;
+    std::map<int, std::string> hubNames;
+
+    if (! DeviceDiscovery::discoverDevices (context, deviceTable, factory, devices, hubNames))
+        return 1;
+
+    context->issueReset();
+
+    // NB: Discovering headstages can set the link flags, so they are cleared once every device is configured
+    for (const auto& port : { portA, portB })
+    {
+        if (port->getLastVoltageSet() > 0)
+            port->resetLinkFlags();
+    }
+
+    oni_size_t maxReadFrameSize = 0;
+
+    if (context->getOption<oni_size_t> (ONI_OPT_MAXREADFRAMESIZE, &maxReadFrameSize) != ONI_ESUCCESS || settings.blockReadSize < maxReadFrameSize)
+    {
+        LOGE ("The block read size of ", settings.blockReadSize, " bytes must be at least the max read frame size of ", maxReadFrameSize, " bytes.");
+        return 1;
+    }
+
+    if (context->setOption (ONI_OPT_BLOCKREADSIZE, settings.blockReadSize) != ONI_ESUCCESS)
+    {
+        LOGE ("Unable to set the block read size to ", settings.blockReadSize, " bytes.");
+        return 1;
+    }
+
+    OnixDeviceVector enabledDevices;
+    OwnedArray<DataBuffer> buffers;
+    std::vector<OutputStream> streams;
+
+    for (const auto& device : devices)
+    {
+        if (! device->isEnabled())
+            continue;
+
+        if (isListed (disabled, device->getName(), device->getDeviceType()))
+            LOGC (device->getName(), " on ", device->getHubName(), " is always enabled, and cannot be disabled.");
+
+        if (settings.calibrationDirectory != "")
+            setCalibrationFiles (*device, File (settings.calibrationDirectory));
+
+        if (! device->updateSettings())
+        {
+            LOGE ("Unable to update the settings of ", device->getName(), " on ", device->getHubName(), ".");
+            return 1;
+        }
+
+        const int firstBuffer = buffers.size();
+        device->addSourceBuffers (buffers);
+        addOutputStreams (*device, buffers, firstBuffer, streams);
+
+        enabledDevices.emplace_back (device);
+
+        LOGC ("Enabled ", device->getName(), " on ", device->getHubName());
+    }
+
+    enabledDevices.emplace_back (portA);
+    enabledDevices.emplace_back (portB);
+
+    OutputFile output (outputFile);
+
+    if (! output.open (streams))
+    {
+        LOGE ("Unable to create the output file ", outputFile.getFullPathName(), ".");
+        return 1;
+    }
+
+    if (context->setOption (ONI_OPT_RESETACQCOUNTER, 2) != ONI_ESUCCESS)
+        return 1;
+
+    AsyncLogger::start();
+
+    for (const auto& device : enabledDevices)
+    {
+        device->allocateFrameQueue (settings.blockReadSize);
+        device->setAdvanceSampleNumbersOnGaps (settings.advanceSampleNumbersOnGaps);
+
+        if (device->getDeviceType() == OnixDeviceType::NEUROPIXELSV1E || device->getDeviceType() == OnixDeviceType::NEUROPIXELSV1F)
+            std::static_pointer_cast<Neuropixels1> (device)->setTrackOffsetDrift (settings.trackOffsetDrift);
+
+        device->startAcquisition();
+    }
+
+    std::unique_ptr<DecodePool> decodePool;
+
+    if (settings.decodeThreads > 0)
+    {
+        decodePool = std::make_unique<DecodePool> (enabledDevices, deviceTable, settings.decodeThreads);
+        decodePool->startWorkers();
+    }
+
+    FrameReader frameReader (enabledDevices, FrameReader::createDispatchTable (enabledDevices), context);
+    frameReader.startThread();
+
+    MetricsRegistry metricsRegistry;
+    std::unique_ptr<MetricsLogger> metricsLogger;
+
+    if (settings.metricsFile != "")
+    {
+        frameReader.registerMetrics (metricsRegistry);
+
+        for (const auto& device : enabledDevices)
+            device->registerMetrics (metricsRegistry);
+
+        metricsLogger = std::make_unique<MetricsLogger> (File::getCurrentWorkingDirectory().getChildFile (settings.metricsFile),
+                                                         metricsRegistry,
+                                                         std::chrono::seconds (settings.metricsInterval));
+
+        if (metricsLogger->open())
+            metricsLogger->startThread (Thread::Priority::low);
+        else
+            metricsLogger.reset();
+    }
+
+    std::signal (SIGINT, handleInterrupt);
+
+    LOGC ("Acquiring ", streams.size(), " streams to ", outputFile.getFullPathName(), durationSeconds > 0.0 ? "" : ". Press Ctrl+C to stop.");
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    auto isFinished = [&]
+    {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+        return interrupted.load()
+               || statusReporter->isStopRequested()
+               || portA->getErrorFlag()
+               || portB->getErrorFlag()
+               || (durationSeconds > 0.0 && elapsed.count() >= durationSeconds);
+    };
+
+    while (! isFinished())
+    {
+        if (frameReader.waitForFrames (FrameWaitTimeout))
+        {
+            if (decodePool != nullptr)
+                decodePool->notify();
+            else
+            {
+                for (const auto& device : enabledDevices)
+                    device->processQueuedFrames();
+            }
+        }
+
+        for (uint32_t i = 0; i < streams.size(); i++)
+            output.writeAvailableSamples (i, streams[i]);
+    }
+
+    // NB: Stopping the hardware makes a blocked read return, so the reader always exits before the queues are drained
+    frameReader.signalThreadShouldExit();
+    frameReader.wakeWaitingThread();
+    context->setOption (ONI_OPT_RUNNING, 0);
+    frameReader.waitForThreadToExit (-1);
+
+    if (decodePool != nullptr)
+        decodePool->stopWorkers();
+
+    // NB: Close the log before the devices stop, so that the last snapshot still reads their link state
+    if (metricsLogger != nullptr)
+        metricsLogger->close();
+
+    AsyncLogger::stop();
+
+    for (const auto& device : enabledDevices)
+    {
+        device->stopAcquisition();
+
+        if (device->getFrameQueueOverflowCount() > 0)
+            LOGE ("Dropped ", device->getFrameQueueOverflowCount(), " frames from ", device->getName(), " because its frame queue was full.");
+
+        if (device->getGapCount() > 0)
+            LOGE ("Found ", device->getGapCount(), " gaps in the clock of ", device->getName(), ", with ", device->getMissingFrameCount(), " frames missing.");
+    }
+
+    // NB: Write the samples decoded after the last pass through the loop
+    for (uint32_t i = 0; i < streams.size(); i++)
+        output.writeAvailableSamples (i, streams[i]);
+
+    output.close();
+
+    if (settings.traceFile != "")
+        TraceRecorder::writeTrace (File::getCurrentWorkingDirectory().getChildFile (settings.traceFile));
+
+    if (frameReader.getUnknownFrameCount() > 0)
+        LOGE ("Dropped ", frameReader.getUnknownFrameCount(), " frames with no matching device. Last unknown device index was ", frameReader.getLastUnknownIndex(), ".");
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+    LOGC ("Wrote ", output.getSamplesWritten(), " samples in ", elapsed.count(), " s to ", outputFile.getFullPathName());
+
+    if (portA->getErrorFlag() || portB->getErrorFlag())
+    {
+        LOGE ("A port lost communication lock during acquisition. Inspect hardware connections and the port switch.");
+        return 1;
+    }
+
+    return statusReporter->isStopRequested() ? 1 : 0;
+}
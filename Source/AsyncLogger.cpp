@@ -0,0 +1,306 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "AsyncLogger.h"
+
+#include <DataThreadHeaders.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+using namespace OnixSourcePlugin;
+
+namespace
+{
+struct Record
+{
+    AsyncLogger::Level level;
+    const char* message;
+    const char* source;
+    const char* detail;
+    std::optional<int64_t> value;
+    std::chrono::steady_clock::time_point time;
+};
+
+/** Bounded multi-producer queue of records, with a sequence number per cell so that producers only contend on
+    the enqueue position. Only the writer thread dequeues. */
+class RecordQueue
+{
+public:
+    RecordQueue()
+    {
+        for (size_t i = 0; i < AsyncLogger::QueueCapacity; i++)
+            cells[i].sequence.store (i, std::memory_order_relaxed);
+    }
+
+    bool tryEnqueue (const Record& record)
+    {
+        size_t position = enqueuePosition.load (std::memory_order_relaxed);
+
+        while (true)
+        {
+            Cell& cell = cells[position & Mask];
+            const size_t sequence = cell.sequence.load (std::memory_order_acquire);
+            const auto difference = (intptr_t) sequence - (intptr_t) position;
+
+            if (difference == 0)
+            {
+                if (enqueuePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.record = record;
+                    cell.sequence.store (position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = enqueuePosition.load (std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryDequeue (Record& record)
+    {
+        Cell& cell = cells[dequeuePosition & Mask];
+
+        if (cell.sequence.load (std::memory_order_acquire) != dequeuePosition + 1)
+            return false;
+
+        record = cell.record;
+        cell.sequence.store (dequeuePosition + AsyncLogger::QueueCapacity, std::memory_order_release);
+        dequeuePosition++;
+
+        return true;
+    }
+
+private:
+    static_assert ((AsyncLogger::QueueCapacity & (AsyncLogger::QueueCapacity - 1)) == 0, "The queue capacity must be a power of two");
+
+    static constexpr size_t Mask = AsyncLogger::QueueCapacity - 1;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    std::unique_ptr<Cell[]> cells { new Cell[AsyncLogger::QueueCapacity] };
+
+    alignas (64) std::atomic<size_t> enqueuePosition = 0;
+    alignas (64) size_t dequeuePosition = 0;
+};
+
+RecordQueue& getQueue()
+{
+    static RecordQueue queue;
+    return queue;
+}
+
+std::atomic<bool> writerRunning = false;
+std::atomic<uint64_t> droppedRecords = 0;
+
+std::string format (const Record& record)
+{
+    std::string text;
+
+    if (record.source != nullptr)
+        text = std::string (record.source) + ": ";
+
+    text += record.message;
+
+    if (record.value.has_value())
+        text += " " + std::to_string (*record.value);
+
+    if (record.detail != nullptr)
+        text += std::string (": ") + record.detail;
+
+    return text;
+}
+
+void write (AsyncLogger::Level level, const std::string& text)
+{
+    switch (level)
+    {
+        case AsyncLogger::Level::Error:
+            LOGE (text);
+            break;
+        case AsyncLogger::Level::Debug:
+            LOGD (text);
+            break;
+        default:
+            LOGC (text);
+            break;
+    }
+}
+
+/** Drains the queue and applies the repeat limit */
+class Writer : public Thread
+{
+public:
+    Writer() : Thread ("AsyncLogger") {}
+
+    ~Writer()
+    {
+        stopThread (1000);
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wait ((int) AsyncLogger::WriteInterval.count());
+
+            writeQueuedRecords();
+            writeSummaries (false);
+        }
+
+        writeQueuedRecords();
+        writeSummaries (true);
+    }
+
+private:
+    using Key = std::tuple<const char*, const char*, const char*, std::optional<int64_t>>;
+
+    struct RepeatState
+    {
+        AsyncLogger::Level level;
+        std::chrono::steady_clock::time_point lastWritten;
+        uint64_t suppressed = 0;
+    };
+
+    std::map<Key, RepeatState> repeats;
+
+    uint64_t reportedDroppedRecords = 0;
+    std::chrono::steady_clock::time_point lastDroppedReport;
+
+    void writeQueuedRecords()
+    {
+        Record record;
+
+        while (getQueue().tryDequeue (record))
+        {
+            const Key key { record.message, record.source, record.detail, record.value };
+            auto it = repeats.find (key);
+
+            if (it != repeats.end() && record.time - it->second.lastWritten < AsyncLogger::RepeatInterval)
+            {
+                it->second.suppressed++;
+                continue;
+            }
+
+            auto text = format (record);
+
+            if (it != repeats.end() && it->second.suppressed > 0)
+                text += " (" + std::to_string (it->second.suppressed) + " repeats suppressed)";
+
+            write (record.level, text);
+
+            repeats[key] = { record.level, record.time, 0 };
+        }
+    }
+
+    /** Summarises dropped records and suppressed repeats at most once per RepeatInterval, or all of them when the
+        writer stops */
+    void writeSummaries (bool all)
+    {
+        const auto now = std::chrono::steady_clock::now();
+
+        if (const auto dropped = droppedRecords.load (std::memory_order_relaxed); dropped > reportedDroppedRecords && (all || now - lastDroppedReport >= AsyncLogger::RepeatInterval))
+        {
+            LOGE ("Dropped ", dropped - reportedDroppedRecords, " log messages because the log queue was full.");
+            reportedDroppedRecords = dropped;
+            lastDroppedReport = now;
+        }
+
+        for (auto& [key, state] : repeats)
+        {
+            if (state.suppressed == 0 || (! all && now - state.lastWritten < AsyncLogger::RepeatInterval))
+                continue;
+
+            const auto& [message, source, detail, value] = key;
+
+            write (state.level, format ({ state.level, message, source, detail, value, now }) + " (repeated " + std::to_string (state.suppressed) + " more times)");
+
+            state.lastWritten = now;
+            state.suppressed = 0;
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Writer);
+};
+
+std::mutex writerLock;
+std::unique_ptr<Writer> writer;
+int writerUsers = 0;
+} // namespace
+
+void AsyncLogger::log (Level level, const char* message, const char* source, const char* detail, std::optional<int64_t> value)
+{
+    const Record record { level, message, source, detail, value, std::chrono::steady_clock::now() };
+
+    if (! writerRunning.load (std::memory_order_acquire))
+    {
+        write (level, format (record));
+        return;
+    }
+
+    if (! getQueue().tryEnqueue (record))
+        droppedRecords.fetch_add (1, std::memory_order_relaxed);
+}
+
+void AsyncLogger::start()
+{
+    std::lock_guard<std::mutex> lock (writerLock);
+
+    if (writerUsers++ > 0)
+        return;
+
+    writer = std::make_unique<Writer>();
+    writer->startThread (Thread::Priority::low);
+
+    writerRunning.store (true, std::memory_order_release);
+}
+
+void AsyncLogger::stop()
+{
+    std::lock_guard<std::mutex> lock (writerLock);
+
+    if (writerUsers == 0 || --writerUsers > 0)
+        return;
+
+    // NB: Records logged from here on are written directly, and the writer drains what was already queued
+    writerRunning.store (false, std::memory_order_release);
+    writer.reset();
+}
+
+uint64_t AsyncLogger::getDroppedCount()
+{
+    return droppedRecords.load (std::memory_order_relaxed);
+}
@@ -0,0 +1,80 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Logging for the acquisition threads, which must not block on console or file output.
+
+    log() copies a fixed-size record into a lock-free queue and returns, without formatting or allocating. A
+    writer thread drains the queue every WriteInterval, formats each record as "<source>: <message> <value>:
+    <detail>", and passes it to LOGE, LOGD or LOGC. If the queue is full, the record is dropped and counted, and
+    the count is written with the next batch.
+
+    Repeated messages are rate-limited by the writer: after a message is written, further records with the same
+    message, source, detail and value are only counted until RepeatInterval has passed, and are then summarised
+    in a single line, so a flapping link or a stuck register produces about one line per second instead of one
+    per frame. The value should identify what the message is about, such as a device index, rather than be a
+    measurement.
+
+    The message, source and detail are stored as pointers, so they must be string literals, come from
+    TraceRecorder::intern(), or otherwise remain valid for the lifetime of the process. Until the writer is
+    started, and after it has stopped, records are written immediately by the calling thread.
+
+*/
+class AsyncLogger
+{
+public:
+    enum class Level : uint8_t
+    {
+        Error,
+        Debug,
+        Console
+    };
+
+    /** Queues a record for the writer thread. Safe to call from any thread; never blocks. */
+    static void log (Level level, const char* message, const char* source = nullptr, const char* detail = nullptr, std::optional<int64_t> value = {});
+
+    /** Starts the writer thread. Calls are counted, so every call must be matched by a call to stop(). */
+    static void start();
+
+    /** Stops the writer thread when the last user stops it, after writing every queued record and summarising
+        any suppressed repeats */
+    static void stop();
+
+    /** Returns the number of records dropped because the queue was full, since the process started */
+    static uint64_t getDroppedCount();
+
+    static constexpr size_t QueueCapacity = 4096;
+
+    static constexpr std::chrono::milliseconds WriteInterval { 50 };
+
+    static constexpr std::chrono::seconds RepeatInterval { 1 };
+};
+} // namespace OnixSourcePlugin
@@ -0,0 +1,158 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "BlockReadSizeTuner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+using namespace OnixSourcePlugin;
+
+uint32_t BlockReadSizeTuner::constrain (double size, uint32_t maxReadFrameSize, std::string& rationale)
+{
+    const double minSize = std::max (MinBlockReadSize, maxReadFrameSize);
+
+    if (size < minSize)
+    {
+        size = minSize;
+        rationale += ", raised to the minimum of " + std::to_string ((uint32_t) minSize) + " bytes";
+    }
+    else if (size > MaxBlockReadSize)
+    {
+        size = MaxBlockReadSize;
+        rationale += ", capped at the maximum of " + std::to_string (MaxBlockReadSize) + " bytes";
+    }
+
+    return ((uint32_t) std::ceil (size) + 3) & ~3u; // NB: Round up to the next multiple of four to align with word boundaries in liboni
+}
+
+uint32_t BlockReadSizeTuner::estimate (double bytesPerSecond, double targetLatencySeconds, uint32_t maxReadFrameSize, std::string& rationale)
+{
+    std::ostringstream ss;
+    ss.precision (3);
+    ss << "Estimated " << bytesPerSecond / 1e6 << " MB/s from the enabled devices x " << targetLatencySeconds * 1e3 << " ms target latency";
+
+    rationale = ss.str();
+
+    return constrain (bytesPerSecond * targetLatencySeconds, maxReadFrameSize, rationale);
+}
+
+void BlockReadSizeTuner::startCalibration (uint32_t blockReadSize, std::function<double()> sampleQueueFraction)
+{
+    calibratedBlockReadSize = blockReadSize;
+    queueFractionSampler = sampleQueueFraction;
+
+    numReads = 0;
+    totalBytes = 0;
+    totalReadNanoseconds = 0;
+    minReadNanoseconds = std::numeric_limits<int64_t>::max();
+    elapsedNanoseconds = 0;
+    peakQueueFraction = 0.0;
+
+    complete = false;
+    startTime = std::chrono::steady_clock::now();
+    calibrating = true;
+}
+
+void BlockReadSizeTuner::recordRead (std::chrono::steady_clock::duration readDuration, size_t numBytes)
+{
+    if (! calibrating.load (std::memory_order_relaxed))
+        return;
+
+    const int64_t readNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds> (readDuration).count();
+
+    numReads.fetch_add (1, std::memory_order_relaxed);
+    totalBytes.fetch_add (numBytes, std::memory_order_relaxed);
+    totalReadNanoseconds.fetch_add (readNanoseconds, std::memory_order_relaxed);
+
+    // NB: Only the FrameReader records reads, so a plain load and store is sufficient
+    if (readNanoseconds < minReadNanoseconds.load (std::memory_order_relaxed))
+        minReadNanoseconds.store (readNanoseconds, std::memory_order_relaxed);
+
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+
+    if (elapsed >= std::chrono::duration<double> (CalibrationSeconds))
+    {
+        if (queueFractionSampler != nullptr)
+            peakQueueFraction.store (queueFractionSampler(), std::memory_order_relaxed);
+
+        elapsedNanoseconds.store (std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count(), std::memory_order_relaxed);
+        calibrating.store (false, std::memory_order_relaxed);
+        complete.store (true, std::memory_order_release);
+    }
+}
+
+bool BlockReadSizeTuner::isCalibrationComplete() const
+{
+    return complete.load (std::memory_order_acquire);
+}
+
+uint32_t BlockReadSizeTuner::refine (double targetLatencySeconds, uint32_t maxReadFrameSize, std::string& rationale) const
+{
+    const double elapsedSeconds = elapsedNanoseconds.load() * 1e-9;
+    const uint64_t reads = numReads.load();
+
+    if (! isCalibrationComplete() || reads == 0 || elapsedSeconds <= 0.0)
+    {
+        rationale = "Calibration did not complete; keeping " + std::to_string (calibratedBlockReadSize) + " bytes";
+        return calibratedBlockReadSize;
+    }
+
+    const double measuredBytesPerSecond = totalBytes.load() / elapsedSeconds;
+    const double meanReadSeconds = totalReadNanoseconds.load() * 1e-9 / reads;
+    const double minReadSeconds = minReadNanoseconds.load() * 1e-9;
+    const double queueFraction = peakQueueFraction.load();
+
+    std::ostringstream ss;
+    ss.precision (3);
+    ss << "Measured " << measuredBytesPerSecond / 1e6 << " MB/s, " << meanReadSeconds * 1e6 << " us per read on average and "
+       << minReadSeconds * 1e6 << " us at best over " << CalibrationSeconds << " s with " << calibratedBlockReadSize << " byte blocks";
+
+    double size = measuredBytesPerSecond * targetLatencySeconds;
+
+    // NB: Every batch starts with a block read, and the shortest batch is one whose block was already waiting, so it
+    //     approximates the fixed cost of a read. If that cost is a large part of the time the hardware takes to fill
+    //     a block, the reader spends too much of each block in overhead and falls behind, so grow the block until the
+    //     cost is at most MaxReadOverheadFraction of the fill time.
+    const double overheadLimitedSize = measuredBytesPerSecond * minReadSeconds / MaxReadOverheadFraction;
+
+    if (overheadLimitedSize > size)
+    {
+        size = overheadLimitedSize;
+        ss << "; reads cost " << (int) (100 * minReadSeconds / targetLatencySeconds) << "% of the target latency so the block was grown to keep them under "
+           << (int) (MaxReadOverheadFraction * 100) << "% of the fill time";
+    }
+
+    // NB: If frames piled up in the device queues during calibration, decoding could not keep up. Larger blocks
+    //     mean fewer reads, which leaves more time for decoding at the cost of latency.
+    if (queueFraction > 0.5)
+    {
+        size = std::max (size, 2.0 * calibratedBlockReadSize);
+        ss << "; queues reached " << (int) (queueFraction * 100) << "% so the block size was doubled";
+    }
+
+    rationale = ss.str();
+
+    return constrain (size, maxReadFrameSize, rationale);
+}
@@ -0,0 +1,94 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Chooses a block read size automatically.
+
+    A starting size is estimated from the aggregate byte rate of the enabled devices and a target latency,
+    so that a block is filled roughly once per target latency. The size is then refined from a short
+    calibration run at the start of an acquisition, which measures the actual byte rate, the duration
+    of each batch read, and how full the device frame queues became. Since the block read size cannot
+    change while acquiring, the refined size is used from the next acquisition onwards.
+
+*/
+class BlockReadSizeTuner
+{
+public:
+    /** Returns a block read size that holds targetLatencySeconds worth of data, and describes how it was chosen */
+    static uint32_t estimate (double bytesPerSecond, double targetLatencySeconds, uint32_t maxReadFrameSize, std::string& rationale);
+
+    /** Begins collecting read statistics. Must be called before the FrameReader starts. If given, sampleQueueFraction
+        is called from the FrameReader when calibration completes, and returns the largest fraction of any device frame
+        queue that has been used since acquisition started. */
+    void startCalibration (uint32_t blockReadSize, std::function<double()> sampleQueueFraction = nullptr);
+
+    /** Records a single batch read. Called from the FrameReader; does nothing once calibration is complete. */
+    void recordRead (std::chrono::steady_clock::duration readDuration, size_t numBytes);
+
+    /** Returns true once CalibrationSeconds worth of reads have been recorded */
+    bool isCalibrationComplete() const;
+
+    /** Returns a refined block read size from the calibration run */
+    uint32_t refine (double targetLatencySeconds, uint32_t maxReadFrameSize, std::string& rationale) const;
+
+    static constexpr double CalibrationSeconds = 5.0;
+
+    /** Largest fraction of the time taken to fill a block that may be spent on the fixed cost of reading it */
+    static constexpr double MaxReadOverheadFraction = 0.25;
+
+    static constexpr uint32_t MinBlockReadSize = 512;
+    static constexpr uint32_t MaxBlockReadSize = 20000;
+
+    static constexpr double DefaultTargetLatencyMilliseconds = 1.0;
+
+private:
+    uint32_t calibratedBlockReadSize = 0;
+
+    std::chrono::steady_clock::time_point startTime;
+
+    std::atomic<bool> calibrating = false;
+    std::atomic<bool> complete = false;
+
+    std::atomic<uint64_t> numReads = 0;
+    std::atomic<uint64_t> totalBytes = 0;
+    std::atomic<int64_t> totalReadNanoseconds = 0;
+    std::atomic<int64_t> minReadNanoseconds = 0;
+    std::atomic<int64_t> elapsedNanoseconds = 0;
+
+    std::function<double()> queueFractionSampler;
+    std::atomic<double> peakQueueFraction = 0.0;
+
+    /** Clamps the given size to the valid range and rounds it up to a multiple of four bytes */
+    static uint32_t constrain (double size, uint32_t maxReadFrameSize, std::string& rationale);
+};
+} // namespace OnixSourcePlugin
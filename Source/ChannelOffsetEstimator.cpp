@@ -0,0 +1,112 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ChannelOffsetEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace OnixSourcePlugin;
+
+namespace
+{
+/** Sums count samples into four independent partial sums, which the compiler can keep in one vector register
+    instead of waiting on a single chain of additions */
+double sumSamples (const float* samples, int count)
+{
+    double partial[4] = {};
+
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        for (int lane = 0; lane < 4; lane++)
+            partial[lane] += samples[i + lane];
+    }
+
+    for (; i < count; i++)
+        partial[0] += samples[i];
+
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+}
+} // namespace
+
+ChannelOffsetEstimator::ChannelOffsetEstimator (int numChannels_, double sampleRate_, double settleSeconds_, int samplesToAverage_)
+    : numChannels (numChannels_),
+      sampleRate (sampleRate_),
+      settleSeconds (settleSeconds_),
+      samplesToAverage (samplesToAverage_),
+      offsets (numChannels_, 0.0)
+{
+}
+
+void ChannelOffsetEstimator::reset (double driftTimeConstant_)
+{
+    std::fill (offsets.begin(), offsets.end(), 0.0);
+
+    numAveraged = 0;
+    calculated = false;
+    driftTimeConstant = driftTimeConstant_;
+}
+
+bool ChannelOffsetEstimator::update (const float* samples, int numColumns, int64_t sampleNumber)
+{
+    if (! calculated)
+    {
+        if (sampleNumber <= sampleRate * settleSeconds)
+            return false;
+
+        const int count = std::min (numColumns, samplesToAverage - numAveraged);
+
+        for (int channel = 0; channel < numChannels; channel++)
+            offsets[channel] += sumSamples (samples + (size_t) channel * numColumns, count);
+
+        numAveraged += count;
+
+        if (numAveraged < samplesToAverage)
+            return false;
+
+        for (auto& offset : offsets)
+            offset /= numAveraged;
+
+        calculated = true;
+
+        return true;
+    }
+
+    if (driftTimeConstant <= 0.0)
+        return false;
+
+    // NB: The weight of a buffer depends on its duration, so that the time constant holds for any buffer size
+    const double weight = (1.0 - std::exp (-numColumns / (sampleRate * driftTimeConstant))) / numColumns;
+
+    for (int channel = 0; channel < numChannels; channel++)
+        offsets[channel] += weight * sumSamples (samples + (size_t) channel * numColumns, numColumns);
+
+    return true;
+}
+
+void ChannelOffsetEstimator::getOffsets (float* offsets_) const
+{
+    for (int channel = 0; channel < numChannels; channel++)
+        offsets_[channel] = (float) offsets[channel];
+}
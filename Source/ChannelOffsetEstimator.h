@@ -0,0 +1,75 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Estimates the offset of each channel of a stream from the samples it decodes, for the decoder to subtract.
+
+    Once the stream has settled, the first samplesToAverage samples of each channel are averaged, one buffer at a
+    time, into running sums that are allocated when the estimator is created. If a drift time constant is set,
+    every later buffer then moves each offset towards the mean of the channel by an exponential moving average,
+    so that the offsets follow slow drift over long sessions. The samples are expected to have the current
+    offsets already subtracted, so the mean of a later buffer is the drift since the last update. An estimator is
+    only used from the thread that decodes its stream.
+
+*/
+class ChannelOffsetEstimator
+{
+public:
+    /** Creates an estimator that averages samplesToAverage samples of each of numChannels channels, starting
+        with the first buffer after settleSeconds of samples at sampleRate */
+    ChannelOffsetEstimator (int numChannels, double sampleRate, double settleSeconds, int samplesToAverage);
+
+    /** Forgets the offsets, and sets the time constant in seconds of the drift tracking that follows the initial
+        average. A time constant of zero leaves the offsets alone once they are calculated. */
+    void reset (double driftTimeConstant);
+
+    /** Adds a buffer of channel-major samples, numColumns for each channel, the first of which has the given
+        sample number. Returns true if the offsets changed. */
+    bool update (const float* samples, int numColumns, int64_t sampleNumber);
+
+    bool isCalculated() const { return calculated; }
+
+    /** Copies the offset of each channel to offsets */
+    void getOffsets (float* offsets) const;
+
+private:
+    const int numChannels;
+    const double sampleRate;
+    const double settleSeconds;
+    const int samplesToAverage;
+
+    /** Sum of the samples averaged so far for each channel, and then the offset of each channel */
+    std::vector<double> offsets;
+
+    int numAveraged = 0;
+    bool calculated = false;
+    double driftTimeConstant = 0.0;
+};
+} // namespace OnixSourcePlugin
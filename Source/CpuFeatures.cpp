@@ -0,0 +1,145 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+
+#if ONIX_X86 && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+using namespace OnixSourcePlugin;
+
+namespace
+{
+std::atomic<InstructionSet> instructionSetLimit = InstructionSet::Avx512;
+
+InstructionSet detectInstructionSet()
+{
+#if ONIX_X86 && defined(_MSC_VER)
+    int info[4];
+
+    __cpuid (info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid (info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    if (! sse41)
+        return InstructionSet::Scalar;
+
+    // NB: The AVX registers are only usable if the operating system saves them on a context switch
+    if (! osxsave || ! avx || maxLeaf < 7)
+        return InstructionSet::Sse41;
+
+    const auto enabledState = _xgetbv (0);
+
+    if ((enabledState & 0x6) != 0x6)
+        return InstructionSet::Sse41;
+
+    __cpuidex (info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    const bool avx512f = (info[1] & (1 << 16)) != 0;
+
+    if (! avx2)
+        return InstructionSet::Sse41;
+
+    if (avx512f && (enabledState & 0xE6) == 0xE6)
+        return InstructionSet::Avx512;
+
+    return InstructionSet::Avx2;
+#elif ONIX_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports ("avx512f"))
+        return InstructionSet::Avx512;
+
+    if (__builtin_cpu_supports ("avx2"))
+        return InstructionSet::Avx2;
+
+    if (__builtin_cpu_supports ("sse4.1"))
+        return InstructionSet::Sse41;
+
+    return InstructionSet::Scalar;
+#else
+    return InstructionSet::Scalar;
+#endif
+}
+} // namespace
+
+InstructionSet CpuFeatures::getInstructionSet()
+{
+    return std::min (getSupportedInstructionSet(), instructionSetLimit.load());
+}
+
+InstructionSet CpuFeatures::getSupportedInstructionSet()
+{
+    static const InstructionSet supported = detectInstructionSet();
+    return supported;
+}
+
+void CpuFeatures::setInstructionSetLimit (InstructionSet limit)
+{
+    instructionSetLimit.store (limit);
+}
+
+std::string CpuFeatures::getName (InstructionSet instructionSet)
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::Sse41:
+            return "SSE4.1";
+        case InstructionSet::Avx2:
+            return "AVX2";
+        case InstructionSet::Avx512:
+            return "AVX-512";
+        default:
+            return "Scalar";
+    }
+}
+
+bool CpuFeatures::parse (const std::string& name, InstructionSet& instructionSet)
+{
+    auto toLower = [] (std::string text)
+    {
+        std::transform (text.begin(), text.end(), text.begin(), [] (unsigned char c)
+                        { return (char) std::tolower (c); });
+        return text;
+    };
+
+    for (auto candidate : { InstructionSet::Scalar, InstructionSet::Sse41, InstructionSet::Avx2, InstructionSet::Avx512 })
+    {
+        if (toLower (getName (candidate)) == toLower (name))
+        {
+            instructionSet = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
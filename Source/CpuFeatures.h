@@ -0,0 +1,78 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ONIX_X86 1
+#else
+#define ONIX_X86 0
+#endif
+
+// NB: GCC and Clang only emit instructions from an extension inside functions that enable it, while MSVC accepts
+//     intrinsics from any extension anywhere
+#if ONIX_X86 && (defined(__GNUC__) || defined(__clang__))
+#define ONIX_TARGET(isa) __attribute__ ((target (isa)))
+#else
+#define ONIX_TARGET(isa)
+#endif
+
+namespace OnixSourcePlugin
+{
+/** Vector instruction sets that decoders have kernels for, from least to most capable */
+enum class InstructionSet
+{
+    Scalar,
+    Sse41,
+    Avx2,
+    Avx512
+};
+
+/**
+
+    Detects the vector instruction sets supported by the CPU and the operating system, so that decoders can pick
+    a kernel at run time instead of the plugin being built for one CPU.
+
+    The result can be capped with setInstructionSetLimit(), which is how the benchmarks compare kernels on the
+    same machine. On CPUs other than x86, only the scalar kernels are used.
+
+*/
+class CpuFeatures
+{
+public:
+    /** Returns the most capable instruction set that is supported and not above the limit */
+    static InstructionSet getInstructionSet();
+
+    /** Returns the most capable instruction set that is supported, ignoring the limit */
+    static InstructionSet getSupportedInstructionSet();
+
+    /** Caps the instruction set returned by getInstructionSet(). Only affects decoders that start afterwards. */
+    static void setInstructionSetLimit (InstructionSet limit);
+
+    static std::string getName (InstructionSet instructionSet);
+
+    /** Parses a name returned by getName(), ignoring case. Returns false if the name is not recognised. */
+    static bool parse (const std::string& name, InstructionSet& instructionSet);
+};
+} // namespace OnixSourcePlugin
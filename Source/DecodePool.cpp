@@ -0,0 +1,135 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "DecodePool.h"
+
+using namespace OnixSourcePlugin;
+
+DecodePool::DecodePool (const OnixDeviceVector& sources_, const device_map_t& deviceTable, int numWorkers)
+    : sources (sources_)
+{
+    numWorkers = std::clamp (numWorkers, 1, std::min (MaxWorkers, std::max ((int) sources.size(), 1)));
+
+    for (int i = 0; i < numWorkers; i++)
+        workers.add (new DecodeWorker (i));
+
+    std::vector<std::pair<OnixDevice*, double>> sortedSources;
+
+    for (const auto& source : sources)
+    {
+        auto it = deviceTable.find (source->getDeviceIdx (true));
+        oni_size_t readSize = it != deviceTable.end() ? it->second.read_size : 0;
+
+        sortedSources.emplace_back (source.get(), source->getFramesPerSecond() * (Onix1::FrameHeaderSize + readSize));
+    }
+
+    std::stable_sort (sortedSources.begin(), sortedSources.end(), [] (const auto& a, const auto& b)
+                      { return a.second > b.second; });
+
+    // NB: Greedily give the next busiest device to the least loaded worker
+    for (const auto& [source, bytesPerSecond] : sortedSources)
+    {
+        DecodeWorker* leastLoaded = workers.getFirst();
+
+        for (auto worker : workers)
+        {
+            if (worker->getLoad() < leastLoaded->getLoad())
+                leastLoaded = worker;
+        }
+
+        leastLoaded->addDevice (source, bytesPerSecond);
+    }
+}
+
+DecodePool::~DecodePool()
+{
+    stopWorkers();
+}
+
+void DecodePool::setThreadPolicy (ThreadPolicy policy)
+{
+    for (int i = 0; i < workers.size(); i++)
+        workers[i]->setThreadPolicy (policy.forGroupMember (i));
+}
+
+void DecodePool::startWorkers()
+{
+    for (auto worker : workers)
+        worker->startThread();
+}
+
+void DecodePool::stopWorkers()
+{
+    for (auto worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->notify();
+    }
+
+    for (auto worker : workers)
+        worker->waitForThreadToExit (2000);
+}
+
+void DecodePool::notify()
+{
+    for (auto worker : workers)
+        worker->notify();
+}
+
+DecodePool::DecodeWorker::DecodeWorker (int index_)
+    : Thread ("DecodeWorker" + String (index_)), index (index_)
+{
+}
+
+void DecodePool::DecodeWorker::addDevice (OnixDevice* device, double bytesPerSecond)
+{
+    devices.emplace_back (device);
+    load += bytesPerSecond;
+}
+
+void DecodePool::DecodeWorker::notify()
+{
+    framesAvailable.signal();
+}
+
+void DecodePool::DecodeWorker::run()
+{
+    LOGC (ThreadPolicy::getThreadName (AcquisitionThread::DecodeWorkers), " ", index, " thread policy: ", threadPolicy.applyToCurrentThread());
+
+    while (! threadShouldExit())
+    {
+        if (! framesAvailable.wait (WaitTimeoutMicroseconds))
+            continue;
+
+        while (framesAvailable.tryWait())
+        {
+        }
+
+        for (const auto& device : devices)
+        {
+            device->processQueuedFrames();
+
+            if (threadShouldExit())
+                return;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <DataThreadHeaders.h>
+
+#include "OnixDevice.h"
+#include "Queue/atomicops.h"
+#include "ThreadPolicy.h"
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Runs device decoding on a set of worker threads instead of the DataThread.
+
+    Each device is assigned to exactly one worker for the whole acquisition, so frames from a device are
+    always decoded in order, and each DataBuffer is only ever written by a single thread. Devices are
+    distributed across workers by their expected data rate, since the cost of decoding a frame grows with
+    its size.
+
+*/
+class DecodePool
+{
+public:
+    /** Constructor. Creates up to numWorkers threads, but never more threads than there are devices. The device
+        table gives the size of the frames of each device, which weights its frame rate when balancing workers. */
+    DecodePool (const OnixDeviceVector& sources, const device_map_t& deviceTable, int numWorkers);
+
+    ~DecodePool();
+
+    /** Sets the affinity and scheduling policy of the workers. Worker i uses ThreadPolicy::forGroupMember (i),
+        so each worker gets its own core. Must be called before the workers start. */
+    void setThreadPolicy (ThreadPolicy policy);
+
+    void startWorkers();
+
+    /** Stops all workers and waits for them to exit. Must be called before device queues are drained. */
+    void stopWorkers();
+
+    /** Wakes up every worker so that newly queued frames are decoded */
+    void notify();
+
+    int getNumWorkers() const { return workers.size(); }
+
+    static constexpr int MaxWorkers = 8;
+
+private:
+    class DecodeWorker : public Thread
+    {
+    public:
+        DecodeWorker (int index);
+
+        void run() override;
+
+        /** Assigns a device to this worker, adding its expected bytes per second to the load */
+        void addDevice (OnixDevice* device, double bytesPerSecond);
+
+        void notify();
+
+        double getLoad() const { return load; }
+
+        void setThreadPolicy (ThreadPolicy policy) { threadPolicy = policy; }
+
+    private:
+        const int index;
+
+        std::vector<OnixDevice*> devices;
+        double load = 0.0;
+
+        ThreadPolicy threadPolicy;
+
+        moodycamel::spsc_sema::LightweightSemaphore framesAvailable;
+
+        static constexpr int64 WaitTimeoutMicroseconds = 10000;
+
+        JUCE_LEAK_DETECTOR (DecodeWorker);
+    };
+
+    OnixDeviceVector sources;
+    OwnedArray<DecodeWorker> workers;
+
+    JUCE_LEAK_DETECTOR (DecodePool);
+};
+} // namespace OnixSourcePlugin
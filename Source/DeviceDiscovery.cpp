@@ -0,0 +1,269 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "DeviceDiscovery.h"
+
+#include "Devices/DeviceList.h"
+#include "Devices/Neuropixels1e.h"
+#include "Devices/PolledBno055.h"
+
+using namespace OnixSourcePlugin;
+
+std::shared_ptr<OnixDevice> DeviceDiscovery::createDevice (OnixDeviceType type, std::string name, std::string hubName, oni_dev_idx_t deviceIndex, std::shared_ptr<Onix1> context)
+{
+    switch (type)
+    {
+        case OnixDeviceType::BNO:
+            return std::make_shared<Bno055> (name, hubName, deviceIndex, context);
+        case OnixDeviceType::POLLEDBNO:
+            return std::make_shared<PolledBno055> (name, hubName, OnixDevice::getPassthroughIndexFromHubIndex (deviceIndex), context);
+        case OnixDeviceType::NEUROPIXELSV1E:
+            return std::make_shared<Neuropixels1e> (name, hubName, OnixDevice::getPassthroughIndexFromHubIndex (deviceIndex), context);
+        case OnixDeviceType::NEUROPIXELSV1F:
+            return std::make_shared<Neuropixels1f> (name, hubName, deviceIndex, context);
+        case OnixDeviceType::NEUROPIXELSV2E:
+            return std::make_shared<Neuropixels2e> (name, hubName, OnixDevice::getPassthroughIndexFromHubIndex (deviceIndex), context);
+        case OnixDeviceType::MEMORYMONITOR:
+            return std::make_shared<MemoryMonitor> (name, hubName, deviceIndex, context);
+        case OnixDeviceType::OUTPUTCLOCK:
+            return std::make_shared<OutputClock> (name, hubName, deviceIndex, context);
+        case OnixDeviceType::HARPSYNCINPUT:
+            return std::make_shared<HarpSyncInput> (name, hubName, deviceIndex, context);
+        case OnixDeviceType::ANALOGIO:
+            return std::make_shared<AnalogIO> (name, hubName, deviceIndex, context);
+        case OnixDeviceType::DIGITALIO:
+            return std::make_shared<DigitalIO> (name, hubName, deviceIndex, context);
+        default:
+            return nullptr;
+    }
+}
+
+bool DeviceDiscovery::addDevice (const DeviceFactory& factory, OnixDeviceType type, std::string name, std::string hubName, oni_dev_idx_t deviceIndex, OnixDeviceVector& devices)
+{
+    auto device = factory (type, name, hubName, deviceIndex);
+
+    if (device == nullptr)
+        return false;
+
+    int res = 1;
+
+    try
+    {
+        res = device->configureDevice();
+    }
+    catch (const error_str& e)
+    {
+        Onix1::showWarningMessageBoxAsync ("Configuration Error", e.what());
+
+        return false;
+    }
+
+    devices.emplace_back (device);
+
+    return res == ONI_ESUCCESS;
+}
+
+bool DeviceDiscovery::discoverDevices (std::shared_ptr<Onix1> context, const device_map_t& deviceTable, const DeviceFactory& factory, OnixDeviceVector& devices, std::map<int, std::string>& hubNames)
+{
+    // NB: Search through all hubs, and initialize devices
+    for (const auto& [hubIndex, hubId] : context->getHubIds (deviceTable))
+    {
+        if (hubId == ONIX_HUB_FMCHOST)
+        {
+            hubNames.insert ({ hubIndex, BREAKOUT_BOARD_NAME });
+
+            static constexpr int OutputClockOffset = 5, AnalogIOOffset = 6, DigitalIOOffset = 7, MemoryMonitorOffset = 10, HarpSyncInputOffset = 12;
+
+            if (! addDevice (factory, OutputClock::getDeviceType(), OnixDevice::TypeString.at (OutputClock::getDeviceType()), BREAKOUT_BOARD_NAME, hubIndex + OutputClockOffset, devices)
+                || ! addDevice (factory, DigitalIO::getDeviceType(), OnixDevice::TypeString.at (DigitalIO::getDeviceType()), BREAKOUT_BOARD_NAME, hubIndex + DigitalIOOffset, devices)
+                || ! addDevice (factory, AnalogIO::getDeviceType(), OnixDevice::TypeString.at (AnalogIO::getDeviceType()), BREAKOUT_BOARD_NAME, hubIndex + AnalogIOOffset, devices)
+                || ! addDevice (factory, MemoryMonitor::getDeviceType(), OnixDevice::TypeString.at (MemoryMonitor::getDeviceType()), BREAKOUT_BOARD_NAME, hubIndex + MemoryMonitorOffset, devices)
+                || ! addDevice (factory, HarpSyncInput::getDeviceType(), OnixDevice::TypeString.at (HarpSyncInput::getDeviceType()), BREAKOUT_BOARD_NAME, hubIndex + HarpSyncInputOffset, devices))
+            {
+                return false;
+            }
+        }
+        else if (hubId == ONIX_HUB_HSNP)
+        {
+            hubNames.insert ({ hubIndex, NEUROPIXELSV1F_HEADSTAGE_NAME });
+
+            for (int i = 0; i < 2; i++)
+            {
+                if (! addDevice (factory, Neuropixels1f::getDeviceType(), ProbeString + std::to_string (i), NEUROPIXELSV1F_HEADSTAGE_NAME, hubIndex + i, devices))
+                    return false;
+            }
+
+            if (! addDevice (factory, Bno055::getDeviceType(), OnixDevice::TypeString.at (Bno055::getDeviceType()), NEUROPIXELSV1F_HEADSTAGE_NAME, hubIndex + 2, devices))
+                return false;
+        }
+        else
+        {
+            Onix1::showWarningMessageBoxAsync (
+                "Unknown Hub ID",
+                "Discovered hub ID " + std::to_string (hubId) + " (" + onix_hub_str (hubId) + ") on " + OnixDevice::getPortName (hubIndex) + " which does not match any currently implemented hubs.");
+            return false;
+        }
+    }
+
+    // NB: Search for passthrough devices, and initialize any headstages found in passthrough mode
+    for (const auto& [index, device] : deviceTable)
+    {
+        if (device.id != ONIX_DS90UB9RAW)
+            continue;
+
+        LOGD ("Passthrough device detected");
+
+        auto serializer = std::make_unique<I2CRegisterContext> (DS90UB9x::SER_ADDR, index, context);
+        serializer->WriteByte ((uint32_t) DS90UB9x::DS90UB9xSerializerI2CRegister::SCLHIGH, 20);
+        serializer->WriteByte ((uint32_t) DS90UB9x::DS90UB9xSerializerI2CRegister::SCLLOW, 20);
+
+        auto EEPROM = std::make_unique<HeadStageEEPROM> (index, context);
+        uint32_t hsid = EEPROM->GetHeadStageID();
+        LOGC ("Detected headstage ", onix_hub_str (hsid));
+
+        auto hubIndex = OnixDevice::getHubIndexFromPassthroughIndex (index);
+
+        std::string headstageName;
+        PolledBno055::Bno055AxisSign secondMirroredAxis;
+
+        if (hsid == ONIX_HUB_HSNP2E)
+        {
+            headstageName = NEUROPIXELSV2E_HEADSTAGE_NAME;
+            secondMirroredAxis = PolledBno055::Bno055AxisSign::MirrorY;
+
+            if (! addDevice (factory, Neuropixels2e::getDeviceType(), ProbeString, headstageName, hubIndex, devices))
+                return false;
+        }
+        else if (hsid == ONIX_HUB_HSNP1ET || hsid == ONIX_HUB_HSNP1EH)
+        {
+            headstageName = NEUROPIXELSV1E_HEADSTAGE_NAME;
+            secondMirroredAxis = PolledBno055::Bno055AxisSign::MirrorZ;
+
+            if (! addDevice (factory, Neuropixels1e::getDeviceType(), ProbeString, headstageName, hubIndex, devices))
+                return false;
+        }
+        else
+        {
+            Onix1::showWarningMessageBoxAsync (
+                "Unknown Hub ID",
+                "Discovered hub ID " + std::to_string (hsid) + " (" + onix_hub_str (hsid) + ") on " + OnixDevice::getPortName (hubIndex) + " which does not match any currently implemented hubs.");
+            return false;
+        }
+
+        if (! addDevice (factory, PolledBno055::getDeviceType(), OnixDevice::TypeString.at (PolledBno055::getDeviceType()), headstageName, hubIndex + 1, devices))
+            return false;
+
+        if (devices.back()->getDeviceType() != OnixDeviceType::POLLEDBNO)
+        {
+            LOGE ("Unknown device encountered when configuring headstage ", headstageName);
+            return false;
+        }
+
+        const auto& polledBno = std::static_pointer_cast<PolledBno055> (devices.back());
+
+        // NB: The IMU is mounted differently on each headstage, so the second mirrored axis depends on the headstage
+        polledBno->setBnoAxisMap (PolledBno055::Bno055AxisMap::YZX);
+        polledBno->setBnoAxisSign ((uint32_t) (PolledBno055::Bno055AxisSign::MirrorX) | (uint32_t) secondMirroredAxis);
+
+        hubNames.insert ({ OnixDevice::getOffset (polledBno->getDeviceIdx()), headstageName });
+    }
+
+    return true;
+}
+
+bool DeviceDiscovery::getHubFirmwareVersion (std::shared_ptr<Onix1> context, uint32_t hubIndex, uint32_t* firmwareVersion)
+{
+    if (context->readRegister (hubIndex + ONIX_HUB_DEV_IDX, ONIX_HUB_FIRMWAREVER, firmwareVersion) != ONI_ESUCCESS)
+    {
+        LOGE ("Unable to read the hub firmware version at index ", hubIndex);
+        return false;
+    }
+
+    return true;
+}
+
+bool DeviceDiscovery::enablePassthroughMode (std::shared_ptr<Onix1> context, bool passthroughA, bool passthroughB)
+{
+    if (context == nullptr || ! context->isInitialized())
+    {
+        Onix1::showWarningMessageBoxAsync ("Invalid Context", "Cannot enable passthrough mode, context is not initialized correctly.");
+        return false;
+    }
+
+    int val = 0;
+
+    if (passthroughA)
+    {
+        LOGD ("Passthrough mode enabled for Port A");
+        val |= 1 << 0;
+    }
+
+    if (passthroughB)
+    {
+        LOGD ("Passthrough mode enabled for Port B");
+        val |= 1 << 2;
+    }
+
+    return context->setOption (ONIX_OPT_PASSTHROUGH, val) == ONI_ESUCCESS;
+}
+
+bool DeviceDiscovery::checkHubFirmwareCompatibility (std::shared_ptr<Onix1> context, device_map_t deviceTable)
+{
+    auto hubIds = context->getHubIds (deviceTable);
+
+    if (hubIds.size() == 0)
+    {
+        LOGE ("No hub IDs found.");
+        return false;
+    }
+
+    for (const auto& [hubIndex, hubId] : hubIds)
+    {
+        if (hubId == ONIX_HUB_FMCHOST)
+        {
+            static constexpr int RequiredMajorVersion = 2;
+            uint32_t firmwareVersion = 0;
+            if (! getHubFirmwareVersion (context, hubIndex, &firmwareVersion))
+            {
+                return false;
+            }
+
+            auto majorVersion = (firmwareVersion & 0xFF00) >> 8;
+            auto minorVersion = firmwareVersion & 0xFF;
+
+            LOGC ("PCIe Host firmware version: v", majorVersion, ".", minorVersion);
+
+            if (majorVersion != RequiredMajorVersion)
+            {
+                Onix1::showWarningMessageBoxAsync (
+                    "Invalid Firmware Version",
+                    "The PCIe Host firmware major version is v"
+                        + std::to_string (majorVersion) + ", but this plugin is only compatible with v"
+                        + std::to_string (RequiredMajorVersion) + ". To use this plugin, modify the firmware"
+                        + " to version v" + std::to_string (majorVersion));
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
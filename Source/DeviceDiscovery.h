@@ -0,0 +1,61 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <functional>
+
+#include "OnixDevice.h"
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Finds the hubs and headstages in a device table, and creates and configures their devices. Shared by
+    OnixSource, which takes devices from its settings tabs, and the headless tools, which create them directly.
+
+*/
+class DeviceDiscovery
+{
+public:
+    /** Returns the device of the given type at the given index, or nullptr after reporting why it is missing.
+        The device is configured by discoverDevices, and must not have been configured yet. */
+    using DeviceFactory = std::function<std::shared_ptr<OnixDevice> (OnixDeviceType type, std::string name, std::string hubName, oni_dev_idx_t deviceIndex)>;
+
+    /** Creates the devices of every hub and passthrough headstage in the device table, and adds them to
+        devices. Returns false, after reporting why, if a hub is unknown or a device could not be configured. */
+    static bool discoverDevices (std::shared_ptr<Onix1> context, const device_map_t& deviceTable, const DeviceFactory& factory, OnixDeviceVector& devices, std::map<int, std::string>& hubNames);
+
+    /** Creates a new device of the given type, or returns nullptr for types that are not created from the device table.
+        The index is the one passed to the factory; passthrough devices are created at the matching passthrough index. */
+    static std::shared_ptr<OnixDevice> createDevice (OnixDeviceType type, std::string name, std::string hubName, oni_dev_idx_t deviceIndex, std::shared_ptr<Onix1> context);
+
+    static bool enablePassthroughMode (std::shared_ptr<Onix1> context, bool passthroughA, bool passthroughB);
+
+    static bool checkHubFirmwareCompatibility (std::shared_ptr<Onix1> context, device_map_t deviceTable);
+
+    static bool getHubFirmwareVersion (std::shared_ptr<Onix1> context, uint32_t hubIndex, uint32_t* firmwareVersion);
+
+private:
+    static bool addDevice (const DeviceFactory& factory, OnixDeviceType type, std::string name, std::string hubName, oni_dev_idx_t deviceIndex, OnixDeviceVector& devices);
+};
+} // namespace OnixSourcePlugin
@@ -189,12 +189,15 @@ void AnalogIO::startAcquisition()
     currentAverageFrame = 0;
     sampleNumber = 0;
 
+    gapDetector.reset (getFramePeriodTicks (AnalogIOFrequencyHz));
+    skippedFrames = 0;
+
     analogInputSamples.fill (0);
 }
 
 int AnalogIO::getNumberOfFrames()
 {
-    return frameQueue.size_approx();
+    return frameQueue.sizeApprox();
 }
 
 void AnalogIO::addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers)
@@ -206,11 +209,20 @@ void AnalogIO::addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers)
 void AnalogIO::processFrame (uint64_t eventWord)
 {
     oni_frame_t* frame;
-    if (! frameQueue.try_dequeue (frame))
+    if (! dequeueFrame (frame))
     { // NB: This method should never be called unless a frame is sure to be there
         jassertfalse;
     }
 
+    // NB: Samples are averaged over framesToAverage frames, so missing frames are carried over until they add
+    //     up to a whole sample
+    if (auto skipped = checkForGap (gapDetector, *(uint64_t*) frame->data); skipped > 0)
+    {
+        skippedFrames += skipped;
+        sampleNumber += skippedFrames / framesToAverage;
+        skippedFrames %= framesToAverage;
+    }
+
     int16_t* dataPtr = (int16_t*) frame->data;
 
     int dataOffset = 4;
@@ -246,11 +258,13 @@ void AnalogIO::processFrame (uint64_t eventWord)
         currentFrame++;
     }
 
-    oni_destroy_frame (frame);
+    deviceContext->destroyFrame (frame);
 
     if (currentFrame >= numFrames)
     {
+        TraceScope trace ("DataBuffer::addToBuffer", "buffer", "samples", numFrames);
         analogInputBuffer->addToBuffer (analogInputSamples.data(), sampleNumbers, timestamps, eventCodes, numFrames);
+        recordBufferWrite (numFrames);
 
         analogInputSamples.fill (0);
         currentFrame = 0;
@@ -76,6 +76,7 @@ public:
     void startAcquisition() override;
     void addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers) override;
     void processFrames() override;
+    double getFramesPerSecond() const override { return AnalogIOFrequencyHz; }
 
     void processFrame (uint64_t eventWord = 0);
 
@@ -116,6 +117,11 @@ private:
     unsigned short currentAverageFrame = 0;
     int sampleNumber = 0;
 
+    FrameGapDetector gapDetector;
+
+    /** Missing frames that do not yet add up to a whole skipped sample */
+    uint32_t skippedFrames = 0;
+
     std::array<float, numFrames * numChannels> analogInputSamples;
 
     double timestamps[numFrames];
@@ -156,7 +156,7 @@ void Bno055::addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers)
 void Bno055::processFrames()
 {
     oni_frame_t* frame;
-    while (frameQueue.try_dequeue (frame))
+    while (dequeueFrame (frame))
     {
         int16_t* dataPtr = ((int16_t*) frame->data) + 4;
 
@@ -205,7 +205,7 @@ void Bno055::processFrames()
             bnoSamples[currentFrame + (offset + i + 1) * numFrames] = (calibrationStatus & (statusMask << (2 * i))) >> (2 * i);
         }
 
-        oni_destroy_frame (frame);
+        deviceContext->destroyFrame (frame);
 
         sampleNumbers[currentFrame] = sampleNumber++;
 
@@ -220,7 +220,9 @@ void Bno055::processFrames()
         if (shouldAddToBuffer)
         {
             shouldAddToBuffer = false;
+            TraceScope trace ("DataBuffer::addToBuffer", "buffer", "samples", numFrames);
             bnoBuffer->addToBuffer (bnoSamples.data(), sampleNumbers, bnoTimestamps, eventCodes, numFrames);
+            recordBufferWrite (numFrames);
         }
     }
 }
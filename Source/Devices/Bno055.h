@@ -46,6 +46,8 @@ public:
     void processFrames() override;
     void addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers) override;
 
+    double getFramesPerSecond() const override { return sampleRate; }
+
     static OnixDeviceType getDeviceType();
 
 private:
@@ -26,7 +26,7 @@
 
 namespace OnixSourcePlugin
 {
-static class DS90UB9x
+class DS90UB9x
 {
 public:
     // managed registers
@@ -98,6 +98,8 @@ void DigitalIO::startAcquisition()
     currentFrame = 0;
     sampleNumber = 0;
 
+    gapDetector.reset (getFramePeriodTicks (getFramesPerSecond()));
+
     digitalSamples.fill (0);
 }
 
@@ -126,10 +128,15 @@ float DigitalIO::getChannelState (uint8_t state, int channel)
     return (state & (1 << channel)) >> channel; // NB: Return the state of the specified channel
 };
 
+double DigitalIO::getFramesPerSecond() const
+{
+    return AnalogIO::getSampleRate();
+}
+
 void DigitalIO::processFrames()
 {
     oni_frame_t* frame;
-    while (frameQueue.try_dequeue (frame))
+    while (dequeueFrame (frame))
     {
         size_t offset = 0;
 
@@ -138,6 +145,8 @@ void DigitalIO::processFrames()
         //     ONI v2.0 this behavior may change, and frame->time can be used instead for consistency across devices.
         auto hubClock = (uint64_t*) frame->data;
 
+        sampleNumber += checkForGap (gapDetector, *hubClock);
+
         timestamps[currentFrame] = deviceContext->convertTimestampToSeconds (*hubClock);
         sampleNumbers[currentFrame] = sampleNumber++;
 
@@ -161,11 +170,13 @@ void DigitalIO::processFrames()
 
         eventCodes[currentFrame] = (buttonState & 0x3F) << 8 | (inputState & 0xFF);
 
-        oni_destroy_frame (frame);
+        deviceContext->destroyFrame (frame);
 
         if (++currentFrame >= NumFrames)
         {
+            TraceScope trace ("DataBuffer::addToBuffer", "buffer", "samples", NumFrames);
             digitalBuffer->addToBuffer (digitalSamples.data(), sampleNumbers.data(), timestamps.data(), eventCodes.data(), NumFrames);
+            recordBufferWrite (NumFrames);
 
             currentFrame = 0;
         }
@@ -86,6 +86,8 @@ private:
 
     static float getChannelState (uint8_t state, int channel);
 
+    double getFramesPerSecond() const override;
+
     static constexpr int NumFrames = 25;
 
     static constexpr int NumDigitalInputs = 8;
@@ -97,11 +99,13 @@ private:
     unsigned short currentFrame = 0;
     int64_t sampleNumber = 0;
 
+    FrameGapDetector gapDetector;
+
     std::array<float, NumSamples> digitalSamples;
 
     std::array<double, NumFrames> timestamps;
-    std::array<int64_t, NumFrames> sampleNumbers;
-    std::array<uint64_t, NumFrames> eventCodes;
+    std::array<int64, NumFrames> sampleNumbers;
+    std::array<uint64, NumFrames> eventCodes;
 
     JUCE_LEAK_DETECTOR (DigitalIO);
 };
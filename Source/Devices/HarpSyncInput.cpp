@@ -80,7 +80,7 @@ void HarpSyncInput::addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers)
 void HarpSyncInput::processFrames()
 {
     oni_frame_t* frame;
-    while (frameQueue.try_dequeue (frame))
+    while (dequeueFrame (frame))
     {
         // NB: In ONI v1.0 frame clock is when the frame is created, not necessarily when the data is received.
         //     For local and passthrough devices, we will instead use the hub clock for the timestamp; in
@@ -93,7 +93,7 @@ void HarpSyncInput::processFrames()
 
         harpTimeSamples[currentFrame] = *(dataPtr + 2) + 1;
 
-        oni_destroy_frame (frame);
+        deviceContext->destroyFrame (frame);
 
         sampleNumbers[currentFrame] = sampleNumber++;
 
@@ -108,7 +108,9 @@ void HarpSyncInput::processFrames()
         if (shouldAddToBuffer)
         {
             shouldAddToBuffer = false;
+            TraceScope trace ("DataBuffer::addToBuffer", "buffer", "samples", numFrames);
             harpTimeBuffer->addToBuffer (harpTimeSamples, sampleNumbers, timestamps, eventCodes, numFrames);
+            recordBufferWrite (numFrames);
         }
     }
 }
@@ -52,6 +52,9 @@ public:
     void addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers) override;
     void processFrames() override;
 
+    /** Harp sends its clock time once per second */
+    double getFramesPerSecond() const override { return 1.0; }
+
     static OnixDeviceType getDeviceType();
 
 private:
@@ -140,6 +140,14 @@ void MemoryMonitor::addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers)
     percentUsedBuffer = sourceBuffers.getLast();
 }
 
+void MemoryMonitor::registerMetrics (MetricsRegistry& registry)
+{
+    OnixDevice::registerMetrics (registry);
+
+    registry.addGauge (getInstanceName() + ".percent_used", [this]
+                       { return (double) lastPercentUsedValue.load(); });
+}
+
 float MemoryMonitor::getLastPercentUsedValue()
 {
     return lastPercentUsedValue;
@@ -147,10 +155,10 @@ float MemoryMonitor::getLastPercentUsedValue()
 
 void MemoryMonitor::processFrames()
 {
-    static uint64_t ec = 0;
+    static uint64 ec = 0;
     oni_frame_t* frame;
 
-    while (frameQueue.try_dequeue (frame))
+    while (dequeueFrame (frame))
     {
         // NB: In ONI v1.0 frame clock is when the frame is created, not necessarily when the data is received.
         //     For local and passthrough devices, we will instead use the hub clock for the timestamp; in
@@ -160,8 +168,14 @@ void MemoryMonitor::processFrames()
         uint32_t* dataPtr = (uint32_t*) frame->data;
         auto p = 100.0f * float (*(dataPtr + 2)) / totalMemory;
         lastPercentUsedValue = p;
-        oni_destroy_frame (frame);
-        auto sn = sampleNumber++;
-        percentUsedBuffer->addToBuffer (&p, &sn, &t, &ec, 1);
+        deviceContext->destroyFrame (frame);
+        int64 sn = sampleNumber++;
+
+        {
+            TraceScope trace ("DataBuffer::addToBuffer", "buffer", "samples", 1);
+            percentUsedBuffer->addToBuffer (&p, &sn, &t, &ec, 1);
+        }
+
+        recordBufferWrite (1);
     }
 }
@@ -49,6 +49,9 @@ public:
     void startAcquisition() override;
     void addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers) override;
     void processFrames() override;
+    void registerMetrics (MetricsRegistry& registry) override;
+
+    double getFramesPerSecond() const override { return samplesPerSecond; }
 
     float getLastPercentUsedValue();
 
@@ -25,7 +25,7 @@
 using namespace OnixSourcePlugin;
 
 NeuropixelsV1BackgroundUpdater::NeuropixelsV1BackgroundUpdater (Neuropixels1* d)
-    : ThreadWithProgressWindow ("Writing calibration files to Neuropixels Probe: " + d->getName(), true, false)
+    : ProgressTask ("Writing calibration files to Neuropixels Probe: " + d->getName())
 {
     device = d;
 }
@@ -33,7 +33,7 @@ NeuropixelsV1BackgroundUpdater::NeuropixelsV1BackgroundUpdater (Neuropixels1* d)
 bool NeuropixelsV1BackgroundUpdater::updateSettings()
 {
     if (device->isEnabled())
-        runThread();
+        Onix1::getStatusReporter()->runTask (*this);
     else
         return false;
 
@@ -41,15 +41,15 @@ bool NeuropixelsV1BackgroundUpdater::updateSettings()
 }
 
 Neuropixels1::Neuropixels1 (std::string name, std::string hubName, OnixDeviceType deviceType, const oni_dev_idx_t deviceIndex, std::shared_ptr<Onix1> context)
-    : OnixDevice (name, hubName, deviceType, deviceIndex, context, deviceType == OnixDeviceType::NEUROPIXELSV1E),
-      I2CRegisterContext (ProbeI2CAddress, deviceIndex, context),
-      INeuropixel (NeuropixelsV1Values::numberOfSettings, NeuropixelsV1Values::numberOfShanks)
+    : INeuropixel (NeuropixelsV1Values::numberOfSettings, NeuropixelsV1Values::numberOfShanks),
+      OnixDevice (name, hubName, deviceType, deviceIndex, context, deviceType == OnixDeviceType::NEUROPIXELSV1E),
+      I2CRegisterContext (ProbeI2CAddress, deviceIndex, context)
 {
 }
 
 void Neuropixels1::setSettings (ProbeSettings* settings_, int index)
 {
-    if (index >= settings.size())
+    if (index >= (int) settings.size())
     {
         LOGE ("Invalid index given when trying to update settings.");
         return;
@@ -113,70 +113,110 @@ std::vector<int> Neuropixels1::selectElectrodeConfiguration (int electrodeConfig
     return selection;
 }
 
-void Neuropixels1::updateApOffsets (std::array<float, numApSamples>& samples, int64 sampleNumber)
+void Neuropixels1::checkForSuperFrameGap (uint64_t clock)
 {
-    if (sampleNumber > apSampleRate * secondsToSettle)
-    {
-        uint32_t counter = 0;
+    const uint32_t skipped = checkForGap (gapDetector, clock);
 
-        while (apOffsetValues[0].size() < samplesToAverage)
-        {
-            if (counter >= superFramesPerUltraFrame * numUltraFrames)
-                break;
+    if (skipped == 0)
+        return;
 
-            for (size_t i = 0; i < numberOfChannels; i++)
-            {
-                apOffsetValues[i].emplace_back (samples[i * superFramesPerUltraFrame * numUltraFrames + counter]);
-            }
+    // NB: LFP samples are taken once per ultraframe, so missing superframes are carried over until they add up
+    //     to a whole LFP sample
+    apSampleNumber += skipped;
+    skippedSuperFrames += skipped;
+    lfpSampleNumber += skippedSuperFrames / superFramesPerUltraFrame;
+    skippedSuperFrames %= superFramesPerUltraFrame;
+}
 
-            counter++;
-        }
+template <class Layout>
+void Neuropixels1::processSuperFrames (Neuropixels1Decoder<Layout>& decoder)
+{
+    // NB: Claim a run of superframes at once, so the queue and the latency probe are updated once per run
+    std::array<oni_frame_t*, MaxFramesPerDequeue> frames;
+    size_t numFramesDequeued;
 
-        if (apOffsetValues[0].size() >= samplesToAverage)
+    while ((numFramesDequeued = dequeueFrames (frames.data(), frames.size())) > 0)
+    {
+        for (size_t f = 0; f < numFramesDequeued; f++)
         {
-            for (int i = 0; i < numberOfChannels; i++)
-            {
-                apOffsets[i] = std::reduce (apOffsetValues.at (i).begin(), apOffsetValues.at (i).end()) / apOffsetValues.at (i).size();
-            }
+            oni_frame_t* frame = frames[f];
 
-            apOffsetCalculated = true;
-            apOffsetValues.clear();
-        }
-    }
-}
+            // NB: In ONI v1.0 frame clock is when the frame is created, not necessarily when the data is received.
+            //     For local and passthrough devices, we will instead use the hub clock for the timestamp; in
+            //     ONI v2.0 this behavior may change, and frame->time can be used instead for consistency across devices.
+            const uint64_t clock = Layout::UsesHubClock ? *(uint64_t*) frame->data : frame->time;
 
-void Neuropixels1::updateLfpOffsets (std::array<float, numLfpSamples>& samples, int64 sampleNumber)
-{
-    if (sampleNumber > lfpSampleRate * secondsToSettle)
-    {
-        uint32_t counter = 0;
+            checkForSuperFrameGap (clock);
 
-        while (lfpOffsetValues[0].size() < samplesToAverage)
-        {
-            if (counter >= numUltraFrames)
-                break;
+            apTimestamps[superFrameCount] = deviceContext->convertTimestampToSeconds (clock);
+            apSampleNumbers[superFrameCount] = apSampleNumber++;
+
+            const uint16_t* dataPtr = (uint16_t*) frame->data + Layout::DataOffset;
 
-            for (size_t i = 0; i < numberOfChannels; i++)
+            const int superCountOffset = superFrameCount % superFramesPerUltraFrame;
+            if (superCountOffset == 0)
             {
-                lfpOffsetValues[i].emplace_back (samples[i * numUltraFrames + counter]);
+                lfpTimestamps[ultraFrameCount] = apTimestamps[superFrameCount];
+                lfpSampleNumbers[ultraFrameCount] = lfpSampleNumber++;
             }
 
-            counter++;
-        }
+            decoder.decode (NeuropixelsV1Band::Lfp, dataPtr, superCountOffset, lfpSamples.data() + ultraFrameCount);
 
-        if (lfpOffsetValues[0].size() >= samplesToAverage)
-        {
-            for (int i = 0; i < numberOfChannels; i++)
+            for (int i = 1; i < framesPerSuperFrame; i++)
+                decoder.decode (NeuropixelsV1Band::Ap, dataPtr + i * Layout::FrameWords, i - 1, apSamples.data() + superFrameCount);
+
+            deviceContext->destroyFrame (frame);
+
+            superFrameCount++;
+
+            if (superFrameCount % superFramesPerUltraFrame == 0)
             {
-                lfpOffsets[i] = std::reduce (lfpOffsetValues.at (i).begin(), lfpOffsetValues.at (i).end()) / lfpOffsetValues.at (i).size();
+                ultraFrameCount++;
             }
 
-            lfpOffsetCalculated = true;
-            lfpOffsetValues.clear();
+            if (ultraFrameCount >= numUltraFrames)
+            {
+                ultraFrameCount = 0;
+                superFrameCount = 0;
+
+                {
+                    TraceScope trace ("DataBuffer::addToBuffer", "buffer", "samples", numUltraFrames * (superFramesPerUltraFrame + 1));
+                    lfpBuffer->addToBuffer (lfpSamples.data(), lfpSampleNumbers, lfpTimestamps, lfpEventCodes, numUltraFrames);
+                    apBuffer->addToBuffer (apSamples.data(), apSampleNumbers, apTimestamps, apEventCodes, numUltraFrames * superFramesPerUltraFrame);
+                }
+
+                recordBufferWrite (numUltraFrames * (superFramesPerUltraFrame + 1));
+
+                if (lfpOffsetEstimator.update (lfpSamples.data(), numUltraFrames, lfpSampleNumbers[0]))
+                {
+                    lfpOffsetEstimator.getOffsets (lfpOffsets.data());
+                    decoder.setChannelOffsets (NeuropixelsV1Band::Lfp, lfpOffsets);
+                }
+
+                if (apOffsetEstimator.update (apSamples.data(), numUltraFrames * superFramesPerUltraFrame, apSampleNumbers[0]))
+                {
+                    apOffsetEstimator.getOffsets (apOffsets.data());
+                    decoder.setChannelOffsets (NeuropixelsV1Band::Ap, apOffsets);
+                }
+            }
         }
     }
 }
 
+template void Neuropixels1::processSuperFrames (Neuropixels1eDecoder&);
+template void Neuropixels1::processSuperFrames (Neuropixels1fDecoder&);
+
+void Neuropixels1::resetOffsets()
+{
+    apOffsets.fill (0);
+    lfpOffsets.fill (0);
+
+    const double driftTimeConstant = trackOffsetDrift ? OffsetDriftTimeConstant : 0.0;
+
+    apOffsetEstimator.reset (driftTimeConstant);
+    lfpOffsetEstimator.reset (driftTimeConstant);
+}
+
 void Neuropixels1::defineMetadata (ProbeSettings* settings, ProbeType probeType)
 {
     settings->probeType = probeType;
@@ -299,22 +339,22 @@ void Neuropixels1::defineMetadata (ProbeSettings* settings, ProbeType probeType)
     settings->selectElectrodes (selection);
 }
 
-uint64_t Neuropixels1::getProbeSerialNumber (int index)
+uint64_t Neuropixels1::getProbeSerialNumber (int)
 {
     return probeMetadata.getProbeSerialNumber();
 }
 
-std::string Neuropixels1::getProbePartNumber (int index)
+std::string Neuropixels1::getProbePartNumber (int)
 {
     return probeMetadata.getProbePartNumber();
 }
 
-std::string Neuropixels1::getFlexPartNumber (int index)
+std::string Neuropixels1::getFlexPartNumber (int)
 {
     return probeMetadata.getFlexPartNumber();
 }
 
-std::string Neuropixels1::getFlexVersion (int index)
+std::string Neuropixels1::getFlexVersion (int)
 {
     return probeMetadata.getFlexVersion();
 }
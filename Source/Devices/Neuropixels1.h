@@ -22,8 +22,10 @@
 
 #pragma once
 
+#include "../ChannelOffsetEstimator.h"
 #include "../I2CRegisterContext.h"
 #include "../NeuropixelsComponents.h"
+#include "Neuropixels1Decoder.h"
 #include "NeuropixelsProbeMetadata.h"
 
 namespace OnixSourcePlugin
@@ -62,6 +64,11 @@ public:
     bool parseGainCalibrationFile();
     bool parseAdcCalibrationFile();
 
+    /** Sets whether the channel offsets keep following slow drift after they are first calculated. Takes effect
+        at the next acquisition. */
+    void setTrackOffsetDrift (bool track) { trackOffsetDrift = track; }
+    bool getTrackOffsetDrift() const { return trackOffsetDrift; }
+
 protected:
     DataBuffer* apBuffer;
     DataBuffer* lfpBuffer;
@@ -82,7 +89,6 @@ protected:
     static constexpr int framesPerSuperFrame = 13;
     static constexpr int framesPerUltraFrame = superFramesPerUltraFrame * framesPerSuperFrame;
     static constexpr int numUltraFrames = 12;
-    static constexpr int dataOffset = 4 + 1; // NB: 4 bytes [hubClock] + 1 byte [probeIndex]
 
     static constexpr uint16_t NumberOfAdcBins = 1024;
     static constexpr float DataMidpoint = NumberOfAdcBins / 2;
@@ -99,14 +105,16 @@ protected:
     static constexpr float lfpSampleRate = 2500.0f;
     static constexpr float apSampleRate = 30000.0f;
 
-    bool lfpOffsetCalculated = false;
-    bool apOffsetCalculated = false;
+    /** Time constant in seconds of the moving average that tracks offset drift */
+    static constexpr double OffsetDriftTimeConstant = 60.0;
+
+    bool trackOffsetDrift = false;
 
     std::array<float, numberOfChannels> apOffsets;
     std::array<float, numberOfChannels> lfpOffsets;
 
-    std::vector<std::vector<float>> apOffsetValues;
-    std::vector<std::vector<float>> lfpOffsetValues;
+    ChannelOffsetEstimator apOffsetEstimator { numberOfChannels, apSampleRate, secondsToSettle, samplesToAverage };
+    ChannelOffsetEstimator lfpOffsetEstimator { numberOfChannels, lfpSampleRate, secondsToSettle, samplesToAverage };
 
     std::array<float, numLfpSamples> lfpSamples;
     std::array<float, numApSamples> apSamples;
@@ -125,13 +133,30 @@ protected:
     int apSampleNumber = 0;
     int lfpSampleNumber = 0;
 
+    FrameGapDetector gapDetector;
+
+    /** Missing superframes that do not yet add up to a whole skipped LFP sample */
+    uint32_t skippedSuperFrames = 0;
+
+    /** Checks the clock of a superframe for missing superframes, and skips their sample numbers if enabled. Must
+        be called before the sample numbers of the superframe are assigned. */
+    void checkForSuperFrameGap (uint64_t clock);
+
+    /** Decodes every queued superframe with decoder, and adds the samples to the buffers once every
+        numUltraFrames ultraframes */
+    template <class Layout>
+    void processSuperFrames (Neuropixels1Decoder<Layout>& decoder);
+
     int apGain = 1000;
     int lfpGain = 50;
 
     std::vector<NeuropixelsV1Adc> adcValues;
 
-    void updateLfpOffsets (std::array<float, numLfpSamples>&, int64);
-    void updateApOffsets (std::array<float, numApSamples>&, int64);
+    /** Zeroes the channel offsets, and restarts their estimation. Must be called before the offsets are passed to
+        the decoder at the start of an acquisition. */
+    void resetOffsets();
+
+    double getFramesPerSecond() const override { return apSampleRate; }
 
     bool validateProbeTypeAndPartNumber ();
 
@@ -156,9 +181,9 @@ protected:
 };
 
 /*
-    A thread that updates Neuropixels 1.0 probe settings in the background and shows a progress bar
+    A task that updates Neuropixels 1.0 probe settings in the background, and reports its progress
 */
-class NeuropixelsV1BackgroundUpdater : public ThreadWithProgressWindow
+class NeuropixelsV1BackgroundUpdater : public ProgressTask
 {
 public:
     NeuropixelsV1BackgroundUpdater (Neuropixels1* d);
@@ -0,0 +1,287 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "Neuropixels1Decoder.h"
+
+#include <limits>
+
+#if ONIX_X86
+#include <immintrin.h>
+#endif
+
+using namespace OnixSourcePlugin;
+
+namespace
+{
+template <class Layout>
+constexpr bool samplesFitInFrame()
+{
+    for (int index : Neuropixels1Decoder<Layout>::adcToFrameIndex)
+    {
+        if (index < 0 || index >= Layout::FrameWords)
+            return false;
+    }
+
+    return true;
+}
+
+static_assert (Neuropixels1eDecoder::adcToFrameIndex[0] == 1 && Neuropixels1eDecoder::adcToFrameIndex[5] == 2 && Neuropixels1eDecoder::adcToFrameIndex[31] == 15);
+static_assert (Neuropixels1fDecoder::adcToFrameIndex[0] == 0 && Neuropixels1fDecoder::adcToFrameIndex[4] == 28 && Neuropixels1fDecoder::adcToFrameIndex[31] == 13);
+static_assert (Neuropixels1eDecoder::rawToChannel[2][0] == 24 && Neuropixels1eDecoder::rawToChannel[31][11] == 383);
+static_assert (samplesFitInFrame<Neuropixels1eLayout>() && samplesFitInFrame<Neuropixels1fLayout>(), "Every ADC word must be in its frame");
+static_assert (Neuropixels1eLayout::FrameWords % 4 == 0 && Neuropixels1fLayout::FrameWords % 4 == 0, "The vector kernels convert the words of a frame in groups of four");
+
+template <class Layout>
+void decodeScalar (const Neuropixels1Decoder<Layout>& decoder, const typename Neuropixels1Decoder<Layout>::BandTables& band, const uint16_t* frame, int row, float* samples)
+{
+    using Decoder = Neuropixels1Decoder<Layout>;
+    using Real = typename Layout::Real;
+
+    const auto& thresholds = decoder.getThresholds();
+    const auto& offsets = decoder.getOffsets();
+    const Real midpoint = decoder.getMidpoint();
+
+    const int32_t* outputOffsets = band.outputOffsets.data() + row * Decoder::AdcCount;
+    const Real* channelOffsets = band.channelOffsets.data() + row * Decoder::FrameWords;
+
+    for (int adc = 0; adc < Decoder::AdcCount; adc++)
+    {
+        const size_t word = Decoder::adcToFrameIndex[adc];
+
+        uint16_t sample = frame[word] >> Layout::SampleShift;
+
+        if constexpr (Layout::CorrectsAdcs)
+            sample = sample > thresholds[word] ? sample - offsets[word] : sample;
+
+        samples[outputOffsets[adc]] = (float) (band.conversion * (band.gainCorrection * sample - midpoint) - channelOffsets[word]);
+    }
+}
+
+#if ONIX_X86
+
+/** Writes the samples among the converted words of a frame through the output table of the row */
+template <class Layout>
+inline void writeFrame (const typename Neuropixels1Decoder<Layout>::BandTables& band, int row, const float* values, float* samples)
+{
+    using Decoder = Neuropixels1Decoder<Layout>;
+
+    const int32_t* outputOffsets = band.outputOffsets.data() + row * Decoder::AdcCount;
+
+    for (int adc = 0; adc < Decoder::AdcCount; adc++)
+        samples[outputOffsets[adc]] = values[Decoder::adcToFrameIndex[adc]];
+}
+
+/** Converts four samples in double precision, with the offsets of their channels */
+ONIX_TARGET ("sse4.1")
+inline __m128 convertSse41 (__m128i sample, double gainCorrection, double conversion, double midpoint, const double* channelOffsets)
+{
+    const __m128d gainVector = _mm_set1_pd (gainCorrection);
+    const __m128d conversionVector = _mm_set1_pd (conversion);
+    const __m128d midpointVector = _mm_set1_pd (midpoint);
+
+    const __m128d low = _mm_sub_pd (_mm_mul_pd (conversionVector, _mm_sub_pd (_mm_mul_pd (gainVector, _mm_cvtepi32_pd (sample)), midpointVector)), _mm_loadu_pd (channelOffsets));
+    const __m128d high = _mm_sub_pd (_mm_mul_pd (conversionVector, _mm_sub_pd (_mm_mul_pd (gainVector, _mm_cvtepi32_pd (_mm_unpackhi_epi64 (sample, sample))), midpointVector)), _mm_loadu_pd (channelOffsets + 2));
+
+    return _mm_movelh_ps (_mm_cvtpd_ps (low), _mm_cvtpd_ps (high));
+}
+
+/** Converts four samples in single precision, with the offsets of their channels */
+ONIX_TARGET ("sse4.1")
+inline __m128 convertSse41 (__m128i sample, float gainCorrection, float conversion, float midpoint, const float* channelOffsets)
+{
+    return _mm_sub_ps (_mm_mul_ps (_mm_set1_ps (conversion), _mm_sub_ps (_mm_mul_ps (_mm_set1_ps (gainCorrection), _mm_cvtepi32_ps (sample)), _mm_set1_ps (midpoint))), _mm_loadu_ps (channelOffsets));
+}
+
+/** Corrects and converts the four words of a frame starting at word w */
+template <class Layout>
+ONIX_TARGET ("sse4.1")
+inline __m128 decodeWordsSse41 (const Neuropixels1Decoder<Layout>& decoder, const typename Neuropixels1Decoder<Layout>::BandTables& band, const uint16_t* frame, const typename Layout::Real* channelOffsets, int w)
+{
+    __m128i sample = _mm_cvtepu16_epi32 (_mm_loadl_epi64 ((const __m128i*) (frame + w)));
+
+    if constexpr (Layout::SampleShift > 0)
+        sample = _mm_srli_epi32 (sample, Layout::SampleShift);
+
+    if constexpr (Layout::CorrectsAdcs)
+    {
+        // NB: The corrected sample wraps around as a 16-bit word, as it does in the scalar kernel
+        const __m128i corrected = _mm_and_si128 (_mm_sub_epi32 (sample, _mm_loadu_si128 ((const __m128i*) (decoder.getOffsets().data() + w))), _mm_set1_epi32 (0xFFFF));
+        sample = _mm_blendv_epi8 (sample, corrected, _mm_cmpgt_epi32 (sample, _mm_loadu_si128 ((const __m128i*) (decoder.getThresholds().data() + w))));
+    }
+
+    return convertSse41 (sample, band.gainCorrection, band.conversion, decoder.getMidpoint(), channelOffsets + w);
+}
+
+template <class Layout>
+ONIX_TARGET ("sse4.1")
+void decodeSse41 (const Neuropixels1Decoder<Layout>& decoder, const typename Neuropixels1Decoder<Layout>::BandTables& band, const uint16_t* frame, int row, float* samples)
+{
+    const typename Layout::Real* channelOffsets = band.channelOffsets.data() + row * Layout::FrameWords;
+
+    alignas (16) float values[Layout::FrameWords];
+
+    for (int w = 0; w < Layout::FrameWords; w += 4)
+        _mm_store_ps (values + w, decodeWordsSse41 (decoder, band, frame, channelOffsets, w));
+
+    writeFrame<Layout> (band, row, values, samples);
+}
+
+/** Converts eight samples in double precision, with the offsets of their channels */
+ONIX_TARGET ("avx2")
+inline __m256 convertAvx2 (__m256i sample, double gainCorrection, double conversion, double midpoint, const double* channelOffsets)
+{
+    const __m256d gainVector = _mm256_set1_pd (gainCorrection);
+    const __m256d conversionVector = _mm256_set1_pd (conversion);
+    const __m256d midpointVector = _mm256_set1_pd (midpoint);
+
+    const __m256d low = _mm256_sub_pd (_mm256_mul_pd (conversionVector, _mm256_sub_pd (_mm256_mul_pd (gainVector, _mm256_cvtepi32_pd (_mm256_castsi256_si128 (sample))), midpointVector)), _mm256_loadu_pd (channelOffsets));
+    const __m256d high = _mm256_sub_pd (_mm256_mul_pd (conversionVector, _mm256_sub_pd (_mm256_mul_pd (gainVector, _mm256_cvtepi32_pd (_mm256_extracti128_si256 (sample, 1))), midpointVector)), _mm256_loadu_pd (channelOffsets + 4));
+
+    return _mm256_set_m128 (_mm256_cvtpd_ps (high), _mm256_cvtpd_ps (low));
+}
+
+/** Converts eight samples in single precision, with the offsets of their channels */
+ONIX_TARGET ("avx2")
+inline __m256 convertAvx2 (__m256i sample, float gainCorrection, float conversion, float midpoint, const float* channelOffsets)
+{
+    return _mm256_sub_ps (_mm256_mul_ps (_mm256_set1_ps (conversion), _mm256_sub_ps (_mm256_mul_ps (_mm256_set1_ps (gainCorrection), _mm256_cvtepi32_ps (sample)), _mm256_set1_ps (midpoint))), _mm256_loadu_ps (channelOffsets));
+}
+
+template <class Layout>
+ONIX_TARGET ("avx2")
+void decodeAvx2 (const Neuropixels1Decoder<Layout>& decoder, const typename Neuropixels1Decoder<Layout>::BandTables& band, const uint16_t* frame, int row, float* samples)
+{
+    constexpr int VectorWords = Layout::FrameWords & ~7;
+
+    const typename Layout::Real* channelOffsets = band.channelOffsets.data() + row * Layout::FrameWords;
+
+    alignas (32) float values[Layout::FrameWords];
+
+    for (int w = 0; w < VectorWords; w += 8)
+    {
+        __m256i sample = _mm256_cvtepu16_epi32 (_mm_loadu_si128 ((const __m128i*) (frame + w)));
+
+        if constexpr (Layout::SampleShift > 0)
+            sample = _mm256_srli_epi32 (sample, Layout::SampleShift);
+
+        if constexpr (Layout::CorrectsAdcs)
+        {
+            // NB: The corrected sample wraps around as a 16-bit word, as it does in the scalar kernel
+            const __m256i corrected = _mm256_and_si256 (_mm256_sub_epi32 (sample, _mm256_loadu_si256 ((const __m256i*) (decoder.getOffsets().data() + w))), _mm256_set1_epi32 (0xFFFF));
+            sample = _mm256_blendv_epi8 (sample, corrected, _mm256_cmpgt_epi32 (sample, _mm256_loadu_si256 ((const __m256i*) (decoder.getThresholds().data() + w))));
+        }
+
+        _mm256_store_ps (values + w, convertAvx2 (sample, band.gainCorrection, band.conversion, decoder.getMidpoint(), channelOffsets + w));
+    }
+
+    // NB: A frame whose length is not a multiple of eight words ends with a group of four
+    if constexpr (VectorWords < Layout::FrameWords)
+        _mm_store_ps (values + VectorWords, decodeWordsSse41 (decoder, band, frame, channelOffsets, VectorWords));
+
+    writeFrame<Layout> (band, row, values, samples);
+}
+
+#endif
+} // namespace
+
+template <class Layout>
+Neuropixels1Decoder<Layout>::Neuropixels1Decoder (int apNumColumns, int lfpNumColumns, Real midpoint_)
+    : midpoint (midpoint_)
+{
+    thresholds.fill (std::numeric_limits<int32_t>::max());
+    offsets.fill (0);
+
+    const int numColumns[] = { apNumColumns, lfpNumColumns };
+
+    for (int b = 0; b < (int) bands.size(); b++)
+    {
+        for (int row = 0; row < SuperFramesPerUltraFrame; row++)
+        {
+            for (int adc = 0; adc < AdcCount; adc++)
+                bands[b].outputOffsets[row * AdcCount + adc] = (int32_t) rawToChannel[adc][row] * numColumns[b];
+        }
+    }
+
+    setInstructionSet (InstructionSet::Scalar);
+}
+
+template <class Layout>
+void Neuropixels1Decoder<Layout>::setAdcCorrections (const std::vector<NeuropixelsV1Adc>& adcValues)
+{
+    thresholds.fill (std::numeric_limits<int32_t>::max());
+    offsets.fill (0);
+
+    for (int adc = 0; adc < AdcCount && adc < (int) adcValues.size(); adc++)
+    {
+        thresholds[adcToFrameIndex[adc]] = adcValues[adc].threshold;
+        offsets[adcToFrameIndex[adc]] = adcValues[adc].offset;
+    }
+}
+
+template <class Layout>
+void Neuropixels1Decoder<Layout>::setConversion (NeuropixelsV1Band band, Real gainCorrection, float conversion)
+{
+    bands[(int) band].gainCorrection = gainCorrection;
+    bands[(int) band].conversion = conversion;
+}
+
+template <class Layout>
+void Neuropixels1Decoder<Layout>::setChannelOffsets (NeuropixelsV1Band band, const std::array<float, ChannelCount>& channelOffsets)
+{
+    auto& tables = bands[(int) band];
+
+    tables.channelOffsets.fill (0);
+
+    for (int row = 0; row < SuperFramesPerUltraFrame; row++)
+    {
+        for (int adc = 0; adc < AdcCount; adc++)
+            tables.channelOffsets[row * FrameWords + adcToFrameIndex[adc]] = channelOffsets[rawToChannel[adc][row]];
+    }
+}
+
+template <class Layout>
+void Neuropixels1Decoder<Layout>::setInstructionSet (InstructionSet instructionSet_)
+{
+    instructionSet = instructionSet_;
+
+    switch (instructionSet)
+    {
+#if ONIX_X86
+        case InstructionSet::Sse41:
+            kernel = decodeSse41<Layout>;
+            break;
+        // NB: A frame is at most 40 words, so AVX-512 would gain little over AVX2
+        case InstructionSet::Avx2:
+        case InstructionSet::Avx512:
+            instructionSet = InstructionSet::Avx2;
+            kernel = decodeAvx2<Layout>;
+            break;
+#endif
+        default:
+            instructionSet = InstructionSet::Scalar;
+            kernel = decodeScalar<Layout>;
+            break;
+    }
+}
+
+template class OnixSourcePlugin::Neuropixels1Decoder<Neuropixels1eLayout>;
+template class OnixSourcePlugin::Neuropixels1Decoder<Neuropixels1fLayout>;
@@ -0,0 +1,198 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include "../CpuFeatures.h"
+#include "../NeuropixelsComponents.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace OnixSourcePlugin
+{
+enum class NeuropixelsV1Band
+{
+    Ap,
+    Lfp
+};
+
+/**
+    Frame layout of a Neuropixels 1.0e headstage. A superframe follows the 64-bit hub clock and the probe index,
+    and the ADC thresholds and offsets are applied by the host.
+*/
+struct Neuropixels1eLayout
+{
+    static constexpr int FrameWords = NeuropixelsV1Values::FrameWordsV1e;
+    static constexpr int DataOffset = 4 + 1; // NB: 4 words [hubClock] + 1 word [probeIndex]
+    static constexpr int FirstAdcWord = 1;
+    static constexpr int AdcBlockWords = 8;
+    static constexpr int SampleShift = 0;
+    static constexpr bool CorrectsAdcs = true;
+    static constexpr bool UsesHubClock = true;
+
+    using Real = double;
+};
+
+/**
+    Frame layout of a Neuropixels 1.0f headstage. A superframe starts the frame, each sample is in the upper ten
+    bits of its word, and the ADCs are corrected by the probe.
+*/
+struct Neuropixels1fLayout
+{
+    static constexpr int FrameWords = NeuropixelsV1Values::FrameWordsV1f;
+    static constexpr int DataOffset = 0;
+    static constexpr int FirstAdcWord = 0;
+    static constexpr int AdcBlockWords = 7;
+    static constexpr int SampleShift = 5;
+    static constexpr bool CorrectsAdcs = false;
+    static constexpr bool UsesHubClock = false;
+
+    using Real = float;
+};
+
+/**
+
+    Corrects and converts the frames of a Neuropixels 1.0 superframe into the sample buffers of the AP and LFP
+    bands, for the frame layout described by Layout.
+
+    Each frame holds one sample from each ADC, at adcToFrameIndex. The ADCs are read out in groups of five, so
+    that ADC a is at word FirstAdcWord + a / 5 + (a % 5) * AdcBlockWords. A sample is shifted right by SampleShift
+    and, if the layout CorrectsAdcs, has the offset of its ADC subtracted when it is above the threshold of the
+    ADC. It is then converted as conversion * (gainCorrection * sample - midpoint) minus the offset of its channel,
+    in the precision of Layout::Real. The first frame of a superframe holds LFP samples, and the others AP
+    samples; the row of a frame selects the channels of its samples from rawToChannel.
+
+    All values that the conversion depends on are packed into arrays in the order of the words of a frame when they
+    are set, so that the kernels need neither bounds checks nor branches. The vector kernels correct and convert
+    the FrameWords words of a frame four or eight at a time, with separate multiplies and subtractions so that
+    they produce the same bits as the scalar kernel, which is the reference, and then write the samples through
+    a table of output offsets.
+
+*/
+template <class Layout>
+class Neuropixels1Decoder
+{
+public:
+    using Real = typename Layout::Real;
+
+    static constexpr int SuperFramesPerUltraFrame = 12;
+    static constexpr int FrameWords = Layout::FrameWords;
+    static constexpr int AdcCount = NeuropixelsV1Values::AdcCount;
+    static constexpr int ChannelCount = NeuropixelsV1Values::numberOfChannels;
+
+    /** Returns the index of the word of each ADC within a frame */
+    static constexpr std::array<int, AdcCount> makeAdcToFrameIndex()
+    {
+        std::array<int, AdcCount> indices {};
+
+        for (int adc = 0; adc < AdcCount; adc++)
+            indices[adc] = Layout::FirstAdcWord + adc / 5 + (adc % 5) * Layout::AdcBlockWords;
+
+        return indices;
+    }
+
+    /** Returns the channel sampled by each ADC in each row. Each pair of ADCs samples a block of 24 channels, two
+        at a time. */
+    static constexpr std::array<std::array<int, SuperFramesPerUltraFrame>, AdcCount> makeRawToChannel()
+    {
+        std::array<std::array<int, SuperFramesPerUltraFrame>, AdcCount> channels {};
+
+        for (int adc = 0; adc < AdcCount; adc++)
+        {
+            for (int row = 0; row < SuperFramesPerUltraFrame; row++)
+                channels[adc][row] = (adc / 2) * 2 * SuperFramesPerUltraFrame + adc % 2 + 2 * row;
+        }
+
+        return channels;
+    }
+
+    static constexpr std::array<int, AdcCount> adcToFrameIndex = makeAdcToFrameIndex();
+    static constexpr std::array<std::array<int, SuperFramesPerUltraFrame>, AdcCount> rawToChannel = makeRawToChannel();
+
+    /** Creates a decoder for AP and LFP sample buffers with the given number of columns in each channel row, using
+        the scalar kernel */
+    Neuropixels1Decoder (int apNumColumns, int lfpNumColumns, Real midpoint);
+
+    /** Packs the threshold and offset of each ADC. Must be called before decoding if the layout CorrectsAdcs. */
+    void setAdcCorrections (const std::vector<NeuropixelsV1Adc>& adcValues);
+
+    void setConversion (NeuropixelsV1Band band, Real gainCorrection, float conversion);
+
+    /** Packs the offset subtracted from each channel of a band, for every row */
+    void setChannelOffsets (NeuropixelsV1Band band, const std::array<float, ChannelCount>& channelOffsets);
+
+    void setInstructionSet (InstructionSet instructionSet);
+    InstructionSet getInstructionSet() const { return instructionSet; }
+
+    /** Writes the samples of one frame to samples, which points at the column of the frame in the first channel
+        row of the buffer of the band. The row is the superframe within the ultraframe for LFP frames, and the
+        frame within the superframe, less one, for AP frames. */
+    void decode (NeuropixelsV1Band band, const uint16_t* frame, int row, float* samples) const
+    {
+        kernel (*this, bands[(int) band], frame, row, samples);
+    }
+
+    struct BandTables
+    {
+        Real gainCorrection = 1;
+        Real conversion = 1;
+
+        /** Offset of the channel of each word of a frame, for each row */
+        std::array<Real, SuperFramesPerUltraFrame * FrameWords> channelOffsets {};
+
+        /** Output offset of the sample of each ADC, for each row */
+        std::array<int32_t, SuperFramesPerUltraFrame * AdcCount> outputOffsets {};
+    };
+
+    using WordTable = std::array<int32_t, FrameWords>;
+
+    /** Returns the threshold above which the offset of the ADC of each word is subtracted. Words that are not
+        samples have a threshold that no word can exceed. */
+    const WordTable& getThresholds() const { return thresholds; }
+
+    /** Returns the offset of the ADC of each word */
+    const WordTable& getOffsets() const { return offsets; }
+
+    Real getMidpoint() const { return midpoint; }
+
+private:
+    using Kernel = void (*) (const Neuropixels1Decoder&, const BandTables&, const uint16_t*, int, float*);
+
+    WordTable thresholds;
+    WordTable offsets;
+
+    const Real midpoint;
+
+    std::array<BandTables, 2> bands;
+
+    InstructionSet instructionSet = InstructionSet::Scalar;
+    Kernel kernel;
+};
+
+using Neuropixels1eDecoder = Neuropixels1Decoder<Neuropixels1eLayout>;
+using Neuropixels1fDecoder = Neuropixels1Decoder<Neuropixels1fLayout>;
+
+extern template class Neuropixels1Decoder<Neuropixels1eLayout>;
+extern template class Neuropixels1Decoder<Neuropixels1fLayout>;
+} // namespace OnixSourcePlugin
@@ -31,6 +31,8 @@ NeuropixelsV1eBackgroundUpdater::NeuropixelsV1eBackgroundUpdater (Neuropixels1e*
 
 void NeuropixelsV1eBackgroundUpdater::run()
 {
+    TraceScope trace ("NeuropixelsV1eBackgroundUpdater::run", "probe");
+
     setProgress (0);
 
     ((Neuropixels1e*) device)->resetProbe();
@@ -212,22 +214,16 @@ void Neuropixels1e::startAcquisition()
     apGain = getGainValue (getGainEnum (settings[0]->apGainIndex));
     lfpGain = getGainValue (getGainEnum (settings[0]->lfpGainIndex));
 
-    apOffsetValues.clear();
-    apOffsetValues.reserve (numberOfChannels);
-    lfpOffsetValues.clear();
-    lfpOffsetValues.reserve (numberOfChannels);
-
-    for (int i = 0; i < numberOfChannels; i++)
-    {
-        apOffsets[i] = 0;
-        lfpOffsets[i] = 0;
+    resetOffsets();
 
-        apOffsetValues.emplace_back (std::vector<float> {});
-        lfpOffsetValues.emplace_back (std::vector<float> {});
-    }
+    decoder.setAdcCorrections (adcValues);
+    decoder.setConversion (NeuropixelsV1Band::Ap, apGainCorrection, (1171.875 / apGain) * -1.0f);
+    decoder.setConversion (NeuropixelsV1Band::Lfp, lfpGainCorrection, (1171.875 / lfpGain) * -1.0f);
+    decoder.setChannelOffsets (NeuropixelsV1Band::Ap, apOffsets);
+    decoder.setChannelOffsets (NeuropixelsV1Band::Lfp, lfpOffsets);
+    decoder.setInstructionSet (CpuFeatures::getInstructionSet());
 
-    lfpOffsetCalculated = false;
-    apOffsetCalculated = false;
+    LOGD (getName(), " decoding with the ", CpuFeatures::getName (decoder.getInstructionSet()), " kernel");
 
     // WONTFIX: Soft reset inside settings.WriteShiftRegisters() above puts probe in reset set that
     // needs to be undone here
@@ -244,6 +240,9 @@ void Neuropixels1e::startAcquisition()
     ultraFrameCount = 0;
     apSampleNumber = 0;
     lfpSampleNumber = 0;
+
+    gapDetector.reset (getFramePeriodTicks (apSampleRate));
+    skippedSuperFrames = 0;
 }
 
 void Neuropixels1e::stopAcquisition()
@@ -269,81 +268,13 @@ void Neuropixels1e::addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers)
 
 void Neuropixels1e::processFrames()
 {
-    const float apConversion = (1171.875 / apGain) * -1.0f;
-    const float lfpConversion = (1171.875 / lfpGain) * -1.0f;
-
-    oni_frame_t* frame;
-    while (frameQueue.try_dequeue (frame))
-    {
-        // NB: In ONI v1.0 frame clock is when the frame is created, not necessarily when the data is received.
-        //     For local and passthrough devices, we will instead use the hub clock for the timestamp; in
-        //     ONI v2.0 this behavior may change, and frame->time can be used instead for consistency across devices.
-        auto hubClock = (uint64_t*) frame->data;
-
-        apTimestamps[superFrameCount] = deviceContext->convertTimestampToSeconds (*hubClock);
-        apSampleNumbers[superFrameCount] = apSampleNumber++;
-
-        uint16_t* dataPtr = (uint16_t*) frame->data;
-        dataPtr += dataOffset;
-
-        for (size_t i = 0; i < framesPerSuperFrame; i++)
-        {
-            if (i == 0) // LFP data
-            {
-                size_t superCountOffset = superFrameCount % superFramesPerUltraFrame;
-                if (superCountOffset == 0)
-                {
-                    lfpTimestamps[ultraFrameCount] = apTimestamps[superFrameCount];
-                    lfpSampleNumbers[ultraFrameCount] = lfpSampleNumber++;
-                }
-
-                for (int adc = 0; adc < NeuropixelsV1Values::AdcCount; adc++)
-                {
-                    auto sample = *(dataPtr + adcToFrameIndex[adc]);
-                    sample = sample > adcValues.at (adc).threshold ? sample - adcValues.at (adc).offset : sample;
-                    lfpSamples[(rawToChannel[adc][superCountOffset] * numUltraFrames) + ultraFrameCount] =
-                        lfpConversion * (lfpGainCorrection * sample - DataMidpoint) - lfpOffsets.at (rawToChannel[adc][superCountOffset]);
-                }
-            }
-            else // AP data
-            {
-                for (int adc = 0; adc < NeuropixelsV1Values::AdcCount; adc++)
-                {
-                    auto sample = *(dataPtr + adcToFrameIndex[adc] + i * NeuropixelsV1Values::FrameWordsV1e);
-                    sample = sample > adcValues.at (adc).threshold ? sample - adcValues.at (adc).offset : sample;
-                    apSamples[(rawToChannel[adc][i - 1] * superFramesPerUltraFrame * numUltraFrames) + superFrameCount] =
-                        apConversion * (apGainCorrection * sample - DataMidpoint) - apOffsets.at (rawToChannel[adc][i - 1]);
-                }
-            }
-        }
-
-        oni_destroy_frame (frame);
-
-        superFrameCount++;
-
-        if (superFrameCount % superFramesPerUltraFrame == 0)
-        {
-            ultraFrameCount++;
-        }
-
-        if (ultraFrameCount >= numUltraFrames)
-        {
-            ultraFrameCount = 0;
-            superFrameCount = 0;
-
-            lfpBuffer->addToBuffer (lfpSamples.data(), lfpSampleNumbers, lfpTimestamps, lfpEventCodes, numUltraFrames);
-            apBuffer->addToBuffer (apSamples.data(), apSampleNumbers, apTimestamps, apEventCodes, numUltraFrames * superFramesPerUltraFrame);
-
-            if (! lfpOffsetCalculated)
-                updateLfpOffsets (lfpSamples, lfpSampleNumbers[0]);
-            if (! apOffsetCalculated)
-                updateApOffsets (apSamples, apSampleNumbers[0]);
-        }
-    }
+    processSuperFrames (decoder);
 }
 
 void Neuropixels1e::writeShiftRegisters()
 {
+    TraceScope trace ("Neuropixels1e::writeShiftRegisters", "probe");
+
     if (adcValues.size() != NeuropixelsV1Values::AdcCount)
         throw error_str ("Invalid number of ADC values found.");
 
@@ -369,10 +300,12 @@ void Neuropixels1e::writeShiftRegisters()
 
     const uint32_t shiftRegisterSuccess = 1 << 7;
 
-    for (int i = 0; i < configBits.size(); i++)
+    for (int i = 0; i < (int) configBits.size(); i++)
     {
         auto srAddress = i == 0 ? (uint32_t) NeuropixelsV1ShiftRegisters::SR_CHAIN2 : (uint32_t) NeuropixelsV1ShiftRegisters::SR_CHAIN3;
 
+        TraceScope chainTrace ("Base configuration shift register", "probe", "address", srAddress);
+
         for (int j = 0; j < 2; j++)
         {
             // WONTFIX: Without this reset, the ShiftRegisterSuccess check below will always fail
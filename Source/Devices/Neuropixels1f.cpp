@@ -31,6 +31,8 @@ NeuropixelsV1fBackgroundUpdater::NeuropixelsV1fBackgroundUpdater (Neuropixels1f*
 
 void NeuropixelsV1fBackgroundUpdater::run()
 {
+    TraceScope trace ("NeuropixelsV1fBackgroundUpdater::run", "probe");
+
     setProgress (0);
 
     if (! device->parseGainCalibrationFile())
@@ -173,22 +175,16 @@ void Neuropixels1f::startAcquisition()
     apGain = getGainValue (getGainEnum (settings[0]->apGainIndex));
     lfpGain = getGainValue (getGainEnum (settings[0]->lfpGainIndex));
 
-    apOffsetValues.clear();
-    apOffsetValues.reserve (numberOfChannels);
-    lfpOffsetValues.clear();
-    lfpOffsetValues.reserve (numberOfChannels);
-
-    for (int i = 0; i < numberOfChannels; i++)
-    {
-        apOffsets[i] = 0;
-        lfpOffsets[i] = 0;
+    resetOffsets();
 
-        apOffsetValues.emplace_back (std::vector<float> {});
-        lfpOffsetValues.emplace_back (std::vector<float> {});
-    }
+    // NB: The probe corrects its ADCs, and the gain is not corrected by the host
+    decoder.setConversion (NeuropixelsV1Band::Ap, 1.0f, (1171.875 / apGain) * -1.0f);
+    decoder.setConversion (NeuropixelsV1Band::Lfp, 1.0f, (1171.875 / lfpGain) * -1.0f);
+    decoder.setChannelOffsets (NeuropixelsV1Band::Ap, apOffsets);
+    decoder.setChannelOffsets (NeuropixelsV1Band::Lfp, lfpOffsets);
+    decoder.setInstructionSet (CpuFeatures::getInstructionSet());
 
-    lfpOffsetCalculated = false;
-    apOffsetCalculated = false;
+    LOGD (getName(), " decoding with the ", CpuFeatures::getName (decoder.getInstructionSet()), " kernel");
 
     WriteByte ((uint32_t) NeuropixelsV1Registers::REC_MOD, (uint32_t) NeuropixelsV1RecordRegisterValues::ACTIVE);
 
@@ -196,6 +192,9 @@ void Neuropixels1f::startAcquisition()
     ultraFrameCount = 0;
     apSampleNumber = 0;
     lfpSampleNumber = 0;
+
+    gapDetector.reset (getFramePeriodTicks (apSampleRate));
+    skippedSuperFrames = 0;
 }
 
 void Neuropixels1f::stopAcquisition()
@@ -220,74 +219,13 @@ void Neuropixels1f::addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers)
 
 void Neuropixels1f::processFrames()
 {
-    const float apConversion = (1171.875 / apGain) * -1.0f;
-    const float lfpConversion = (1171.875 / lfpGain) * -1.0f;
-
-    oni_frame_t* frame;
-    while (frameQueue.try_dequeue (frame))
-    {
-        uint16_t* dataPtr = (uint16_t*) frame->data;
-
-        apTimestamps[superFrameCount] = deviceContext->convertTimestampToSeconds (frame->time);
-        apSampleNumbers[superFrameCount] = apSampleNumber++;
-
-        for (int i = 0; i < framesPerSuperFrame; i++)
-        {
-            if (i == 0) // LFP data
-            {
-                size_t superCountOffset = superFrameCount % superFramesPerUltraFrame;
-                if (superCountOffset == 0)
-                {
-                    lfpTimestamps[ultraFrameCount] = apTimestamps[superFrameCount];
-                    lfpSampleNumbers[ultraFrameCount] = lfpSampleNumber++;
-                }
-
-                for (int adc = 0; adc < NeuropixelsV1Values::AdcCount; adc++)
-                {
-                    size_t chanIndex = adcToChannel[adc] + superCountOffset * 2;
-                    lfpSamples[(chanIndex * numUltraFrames) + ultraFrameCount] =
-                        lfpConversion * (float (*(dataPtr + adcToFrameIndex[adc]) >> 5) - DataMidpoint) - lfpOffsets.at (chanIndex);
-                }
-            }
-            else // AP data
-            {
-                int chanOffset = 2 * (i - 1);
-                for (int adc = 0; adc < NeuropixelsV1Values::AdcCount; adc++)
-                {
-                    size_t chanIndex = adcToChannel[adc] + chanOffset;
-                    apSamples[(chanIndex * superFramesPerUltraFrame * numUltraFrames) + superFrameCount] =
-                        apConversion * (float (*(dataPtr + adcToFrameIndex[adc] + i * NeuropixelsV1Values::FrameWordsV1f) >> 5) - DataMidpoint) - apOffsets.at (chanIndex);
-                }
-            }
-        }
-
-        oni_destroy_frame (frame);
-
-        superFrameCount++;
-
-        if (superFrameCount % superFramesPerUltraFrame == 0)
-        {
-            ultraFrameCount++;
-        }
-
-        if (ultraFrameCount >= numUltraFrames)
-        {
-            ultraFrameCount = 0;
-            superFrameCount = 0;
-
-            lfpBuffer->addToBuffer (lfpSamples.data(), lfpSampleNumbers, lfpTimestamps, lfpEventCodes, numUltraFrames);
-            apBuffer->addToBuffer (apSamples.data(), apSampleNumbers, apTimestamps, apEventCodes, numUltraFrames * superFramesPerUltraFrame);
-
-            if (! lfpOffsetCalculated)
-                updateLfpOffsets (lfpSamples, lfpSampleNumbers[0]);
-            if (! apOffsetCalculated)
-                updateApOffsets (apSamples, apSampleNumbers[0]);
-        }
-    }
+    processSuperFrames (decoder);
 }
 
 void Neuropixels1f::writeShiftRegisters()
 {
+    TraceScope trace ("Neuropixels1f::writeShiftRegisters", "probe");
+
     if (adcValues.size() != NeuropixelsV1Values::AdcCount)
         throw error_str ("Invalid number of ADC values found.");
 
@@ -313,10 +251,12 @@ void Neuropixels1f::writeShiftRegisters()
 
     const uint32_t shiftRegisterSuccess = 1 << 7;
 
-    for (int i = 0; i < configBits.size(); i++)
+    for (int i = 0; i < (int) configBits.size(); i++)
     {
         auto srAddress = i == 0 ? (uint32_t) NeuropixelsV1ShiftRegisters::SR_CHAIN2 : (uint32_t) NeuropixelsV1ShiftRegisters::SR_CHAIN3;
 
+        TraceScope chainTrace ("Base configuration shift register", "probe", "address", srAddress);
+
         for (int j = 0; j < 2; j++)
         {
             auto baseBytes = toBitReversedBytes<BaseConfigurationBitCount> (configBits[i]);
@@ -46,80 +46,10 @@ public:
     static OnixDeviceType getDeviceType();
 
 private:
-    static constexpr char* STREAM_NAME_AP = "AP";
-    static constexpr char* STREAM_NAME_LFP = "LFP";
-
-    // ADC number to frame index mapping
-    static constexpr int adcToFrameIndex[] = {
-        0,
-        7,
-        14,
-        21,
-        28,
-        1,
-        8,
-        15,
-        22,
-        29,
-        2,
-        9,
-        16,
-        23,
-        30,
-        3,
-        10,
-        17,
-        24,
-        31,
-        4,
-        11,
-        18,
-        25,
-        32,
-        5,
-        12,
-        19,
-        26,
-        33,
-        6,
-        13
-    };
-
-    // ADC to muxed channel mapping
-    static constexpr size_t adcToChannel[] = {
-        0,
-        1,
-        24,
-        25,
-        48,
-        49,
-        72,
-        73,
-        96,
-        97,
-        120,
-        121,
-        144,
-        145,
-        168,
-        169,
-        192,
-        193,
-        216,
-        217,
-        240,
-        241,
-        264,
-        265,
-        288,
-        289,
-        312,
-        313,
-        336,
-        337,
-        360,
-        361
-    };
+    static constexpr const char* STREAM_NAME_AP = "AP";
+    static constexpr const char* STREAM_NAME_LFP = "LFP";
+
+    Neuropixels1fDecoder decoder { superFramesPerUltraFrame * numUltraFrames, numUltraFrames, DataMidpoint };
 
     JUCE_LEAK_DETECTOR (Neuropixels1f);
 };
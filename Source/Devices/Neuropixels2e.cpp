@@ -25,9 +25,9 @@
 using namespace OnixSourcePlugin;
 
 Neuropixels2e::Neuropixels2e (std::string name, std::string hubName, const oni_dev_idx_t deviceIdx_, std::shared_ptr<Onix1> ctx_)
-    : OnixDevice (name, hubName, Neuropixels2e::getDeviceType(), deviceIdx_, ctx_, true),
-      I2CRegisterContext (ProbeI2CAddress, deviceIdx_, ctx_),
-      INeuropixel (NeuropixelsV2eValues::numberOfSettings, NeuropixelsV2eValues::quadShankCount)
+    : INeuropixel (NeuropixelsV2eValues::numberOfSettings, NeuropixelsV2eValues::quadShankCount),
+      OnixDevice (name, hubName, Neuropixels2e::getDeviceType(), deviceIdx_, ctx_, true),
+      I2CRegisterContext (ProbeI2CAddress, deviceIdx_, ctx_)
 {
     frameCount.fill (0);
     sampleNumber.fill (0);
@@ -544,6 +544,18 @@ void Neuropixels2e::startAcquisition()
 {
     frameCount.fill (0);
     sampleNumber.fill (0);
+
+    for (auto& gapDetector : gapDetectors)
+        gapDetector.reset (getFramePeriodTicks (sampleRate));
+
+    decoder.setInstructionSet (CpuFeatures::getInstructionSet());
+
+    // NB: Without SSE the transpose costs more than the tile saves, so the samples are written to the
+    //     channel-major buffers directly
+    useTiles = decoder.getInstructionSet() >= InstructionSet::Sse41;
+    decoder.setChannelStride (useTiles ? 1 : numFrames);
+
+    LOGD (getName(), " decoding with the ", CpuFeatures::getName (decoder.getInstructionSet()), " kernel");
 }
 
 void Neuropixels2e::stopAcquisition()
@@ -574,45 +586,49 @@ void Neuropixels2e::addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers)
 
 void Neuropixels2e::processFrames()
 {
-    oni_frame_t* frame;
-    while (frameQueue.try_dequeue (frame))
+    // NB: Claim a run of superframes at once, so the queue and the latency probe are updated once per run
+    std::array<oni_frame_t*, MaxFramesPerDequeue> frames;
+    size_t numFramesDequeued;
+
+    while ((numFramesDequeued = dequeueFrames (frames.data(), frames.size())) > 0)
     {
-        uint16_t* dataPtr = (uint16_t*) frame->data;
+        for (size_t f = 0; f < numFramesDequeued; f++)
+        {
+            oni_frame_t* frame = frames[f];
 
-        uint16_t probeIndex = *(dataPtr + 4);
-        uint16_t* amplifierData = dataPtr + 9;
+            uint16_t* dataPtr = (uint16_t*) frame->data;
 
-        sampleNumbers[probeIndex][frameCount[probeIndex]] = sampleNumber[probeIndex]++;
+            uint16_t probeIndex = *(dataPtr + 4);
+            uint16_t* amplifierData = dataPtr + 9;
 
-        // NB: In ONI v1.0 frame clock is when the frame is created, not necessarily when the data is received.
-        //     For local and passthrough devices, we will instead use the hub clock for the timestamp; in
-        //     ONI v2.0 this behavior may change, and frame->time can be used instead for consistency across devices.
-        auto hubClock = (uint64_t*) frame->data;
+            // NB: In ONI v1.0 frame clock is when the frame is created, not necessarily when the data is received.
+            //     For local and passthrough devices, we will instead use the hub clock for the timestamp; in
+            //     ONI v2.0 this behavior may change, and frame->time can be used instead for consistency across devices.
+            auto hubClock = (uint64_t*) frame->data;
 
-        timestamps[probeIndex][frameCount[probeIndex]] = deviceContext->convertTimestampToSeconds (*hubClock);
+            sampleNumber[probeIndex] += checkForGap (gapDetectors[probeIndex], *hubClock);
+            sampleNumbers[probeIndex][frameCount[probeIndex]] = sampleNumber[probeIndex]++;
 
-        for (int i = 0; i < FramesPerSuperFrame; i++)
-        {
-            auto adcDataOffset = i * FrameWords;
+            timestamps[probeIndex][frameCount[probeIndex]] = deviceContext->convertTimestampToSeconds (*hubClock);
 
-            for (int j = 0; j < AdcsPerProbe; j++)
+            float* column = useTiles ? tiles[probeIndex].getColumn (frameCount[probeIndex]) : samples[probeIndex].data() + frameCount[probeIndex];
+            decoder.decode (amplifierData, gainCorrection[probeIndex], DataMidpoint, column);
+
+            frameCount[probeIndex]++;
+
+            if (frameCount[probeIndex] >= numFrames)
             {
-                const size_t channelIndex = rawToChannel[j][i];
+                if (useTiles)
+                    tiles[probeIndex].transposeInto (samples[probeIndex].data(), numFrames);
 
-                samples[probeIndex][channelIndex * numFrames + frameCount[probeIndex]] =
-                    (float) (*(amplifierData + adcIndices[j] + adcDataOffset)) * gainCorrection[probeIndex] + DataMidpoint;
+                TraceScope trace ("DataBuffer::addToBuffer", "buffer", "samples", numFrames);
+                amplifierBuffer[probeIndex]->addToBuffer (samples[probeIndex].data(), sampleNumbers[probeIndex].data(), timestamps[probeIndex].data(), eventCodes[probeIndex].data(), numFrames);
+                recordBufferWrite (numFrames);
+                frameCount[probeIndex] = 0;
             }
-        }
 
-        frameCount[probeIndex]++;
-
-        if (frameCount[probeIndex] >= numFrames)
-        {
-            amplifierBuffer[probeIndex]->addToBuffer (samples[probeIndex].data(), sampleNumbers[probeIndex].data(), timestamps[probeIndex].data(), eventCodes[probeIndex].data(), numFrames);
-            frameCount[probeIndex] = 0;
+            deviceContext->destroyFrame (frame);
         }
-
-        oni_destroy_frame (frame);
     }
 }
 
@@ -629,7 +645,7 @@ void Neuropixels2e::writeConfiguration (ProbeSettings* settings)
     writeShiftRegister (SR_CHAIN4, shankBits[3]);
 }
 
-template <int N>
+template <size_t N>
 void Neuropixels2e::writeShiftRegister (uint32_t srAddress, std::bitset<N> bits)
 {
     std::vector<unsigned char> bytes = toBitReversedBytes<N> (bits);
@@ -675,7 +691,7 @@ std::string Neuropixels2e::getShankName (uint32_t shiftRegisterAddress)
 
 void Neuropixels2e::setGainCorrectionFile (int index, std::string filename)
 {
-    if (index < gainCorrectionFilePath.size())
+    if (index < (int) gainCorrectionFilePath.size())
     {
         gainCorrectionFilePath[index] = filename;
     }
@@ -683,7 +699,7 @@ void Neuropixels2e::setGainCorrectionFile (int index, std::string filename)
 
 std::string Neuropixels2e::getGainCorrectionFile (int index)
 {
-    if (index < gainCorrectionFilePath.size())
+    if (index < (int) gainCorrectionFilePath.size())
     {
         return gainCorrectionFilePath[index];
     }
@@ -786,7 +802,7 @@ Neuropixels2e::ShankBitsArray Neuropixels2e::makeShankBits (NeuropixelsV2Referen
 
 void Neuropixels2e::setSettings (ProbeSettings* settings_, int index)
 {
-    if (index >= settings.size())
+    if (index >= (int) settings.size())
     {
         LOGE ("Invalid index given when trying to update settings.");
         return;
@@ -0,0 +1,209 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "Neuropixels2eDecoder.h"
+
+#if ONIX_X86
+#include <immintrin.h>
+#endif
+
+using namespace OnixSourcePlugin;
+
+namespace
+{
+using Decoder = Neuropixels2eDecoder;
+
+static_assert (Decoder::SpanWords <= Decoder::FrameWords, "The vector kernels must not read past the last frame of a superframe");
+static_assert (Decoder::SpanWords % 16 == 0, "The vector kernels convert the span in groups of sixteen words");
+static_assert ([]
+               {
+                   for (int index : Decoder::adcIndices)
+                   {
+                       if (index < 0 || index >= Decoder::SpanWords)
+                           return false;
+                   }
+                   return true;
+               }(),
+               "Every ADC word must be in the span converted by the vector kernels");
+
+void decodeScalar (const Decoder& decoder, const uint16_t* amplifierData, float gain, float offset, float* samples)
+{
+    const int channelStride = decoder.getChannelStride();
+
+    for (int i = 0; i < Decoder::FramesPerSuperFrame; i++)
+    {
+        auto adcDataOffset = i * Decoder::FrameWords;
+
+        for (int j = 0; j < Decoder::AdcsPerProbe; j++)
+        {
+            const size_t channelIndex = Decoder::rawToChannel[j][i];
+
+            samples[channelIndex * channelStride] = (float) (*(amplifierData + Decoder::adcIndices[j] + adcDataOffset)) * gain + offset;
+        }
+    }
+}
+
+#if ONIX_X86
+
+/** Writes the ADC samples among the converted span of frame i through the output table */
+inline void writeFrame (const Decoder& decoder, int i, const float* values, float* samples)
+{
+    const int32_t* offsets = decoder.getOutputOffsets().data() + i * Decoder::AdcsPerProbe;
+
+    for (int j = 0; j < Decoder::AdcsPerProbe; j++)
+        samples[offsets[j]] = values[Decoder::adcIndices[j]];
+}
+
+ONIX_TARGET ("sse4.1")
+void decodeSse41 (const Decoder& decoder, const uint16_t* amplifierData, float gain, float offset, float* samples)
+{
+    const __m128 gainVector = _mm_set1_ps (gain);
+    const __m128 offsetVector = _mm_set1_ps (offset);
+
+    alignas (16) float values[Decoder::SpanWords];
+
+    for (int i = 0; i < Decoder::FramesPerSuperFrame; i++)
+    {
+        const uint16_t* words = amplifierData + i * Decoder::FrameWords;
+
+        for (int w = 0; w < Decoder::SpanWords; w += 4)
+        {
+            const __m128i integers = _mm_cvtepu16_epi32 (_mm_loadl_epi64 ((const __m128i*) (words + w)));
+            _mm_store_ps (values + w, _mm_add_ps (_mm_mul_ps (_mm_cvtepi32_ps (integers), gainVector), offsetVector));
+        }
+
+        writeFrame (decoder, i, values, samples);
+    }
+}
+
+ONIX_TARGET ("avx2")
+void decodeAvx2 (const Decoder& decoder, const uint16_t* amplifierData, float gain, float offset, float* samples)
+{
+    const __m256 gainVector = _mm256_set1_ps (gain);
+    const __m256 offsetVector = _mm256_set1_ps (offset);
+
+    alignas (32) float values[Decoder::SpanWords];
+
+    for (int i = 0; i < Decoder::FramesPerSuperFrame; i++)
+    {
+        const uint16_t* words = amplifierData + i * Decoder::FrameWords;
+
+        for (int w = 0; w < Decoder::SpanWords; w += 8)
+        {
+            const __m256i integers = _mm256_cvtepu16_epi32 (_mm_loadu_si128 ((const __m128i*) (words + w)));
+            _mm256_store_ps (values + w, _mm256_add_ps (_mm256_mul_ps (_mm256_cvtepi32_ps (integers), gainVector), offsetVector));
+        }
+
+        writeFrame (decoder, i, values, samples);
+    }
+}
+
+// NB: GCC 12 warns that its own AVX-512 conversion intrinsics read an uninitialized value (GCC bug 105593)
+#if defined(__GNUC__) && ! defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+
+ONIX_TARGET ("avx512f")
+void decodeAvx512 (const Decoder& decoder, const uint16_t* amplifierData, float gain, float offset, float* samples)
+{
+    const __m512 gainVector = _mm512_set1_ps (gain);
+    const __m512 offsetVector = _mm512_set1_ps (offset);
+
+    const __mmask16 sampleMasks[] = { Decoder::getSpanSampleMask (0), Decoder::getSpanSampleMask (1) };
+
+    const int32_t* spanOffsets = decoder.getSpanOffsets().data();
+
+    for (int i = 0; i < Decoder::FramesPerSuperFrame; i++)
+    {
+        const uint16_t* words = amplifierData + i * Decoder::FrameWords;
+
+        for (int w = 0; w < Decoder::SpanWords; w += 16)
+        {
+            const __m512i integers = _mm512_cvtepu16_epi32 (_mm256_loadu_si256 ((const __m256i*) (words + w)));
+
+            // NB: AVX-512 implies FMA, and compilers would fuse a plain multiply and add, which rounds once instead
+            //     of twice. A multiply with explicit rounding is never fused.
+            const __m512 scaled = _mm512_mul_round_ps (_mm512_cvtepi32_ps (integers), gainVector, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            const __m512 values = _mm512_add_ps (scaled, offsetVector);
+
+            // NB: The words between ADC samples are masked out, so their zero offsets are never written
+            const __m512i offsets = _mm512_loadu_si512 (spanOffsets + i * Decoder::SpanWords + w);
+            _mm512_mask_i32scatter_ps (samples, sampleMasks[w / 16], offsets, values, sizeof (float));
+        }
+    }
+}
+
+#if defined(__GNUC__) && ! defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+} // namespace
+
+Neuropixels2eDecoder::Neuropixels2eDecoder (int channelStride_)
+{
+    setChannelStride (channelStride_);
+    setInstructionSet (InstructionSet::Scalar);
+}
+
+void Neuropixels2eDecoder::setChannelStride (int channelStride_)
+{
+    channelStride = channelStride_;
+
+    spanOffsets.fill (0);
+
+    for (int i = 0; i < FramesPerSuperFrame; i++)
+    {
+        for (int j = 0; j < AdcsPerProbe; j++)
+        {
+            const int32_t outputOffset = rawToChannel[j][i] * channelStride;
+
+            outputOffsets[i * AdcsPerProbe + j] = outputOffset;
+            spanOffsets[i * SpanWords + adcIndices[j]] = outputOffset;
+        }
+    }
+}
+
+void Neuropixels2eDecoder::setInstructionSet (InstructionSet instructionSet_)
+{
+    instructionSet = instructionSet_;
+
+    switch (instructionSet)
+    {
+#if ONIX_X86
+        case InstructionSet::Sse41:
+            kernel = decodeSse41;
+            break;
+        case InstructionSet::Avx2:
+            kernel = decodeAvx2;
+            break;
+        case InstructionSet::Avx512:
+            kernel = decodeAvx512;
+            break;
+#endif
+        default:
+            instructionSet = InstructionSet::Scalar;
+            kernel = decodeScalar;
+            break;
+    }
+}
@@ -0,0 +1,172 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include "../CpuFeatures.h"
+
+#include <array>
+#include <cstdint>
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Decodes the amplifier data of a Neuropixels 2.0e superframe into the sample buffer of a probe.
+
+    A superframe holds FramesPerSuperFrame frames of FrameWords words, and each frame holds one sample from each
+    of the AdcsPerProbe ADCs at adcIndices. Which channel an ADC sampled depends on the frame, as given by
+    rawToChannel. Every sample is scaled as (float) word * gain + offset, and written channelStride floats apart
+    for consecutive channels.
+
+    The scalar kernel is the reference. The vector kernels convert and scale the first SpanWords words of a frame,
+    which include every ADC word, in groups of four, eight or sixteen, and then write the ADC samples through a
+    table of output offsets built when the decoder is created. They use a separate multiply and add, as the scalar
+    kernel does, so that every kernel produces the same bits. The kernel is chosen by setInstructionSet(),
+    normally with the result of CpuFeatures::getInstructionSet().
+
+*/
+class Neuropixels2eDecoder
+{
+public:
+    static constexpr int FramesPerSuperFrame = 16;
+    static constexpr int AdcsPerProbe = 24;
+    static constexpr int FrameWords = 36; // TRASH TRASH TRASH 0 ADC0 ADC8 ADC16 0 ADC1 ADC9 ADC17 0 ... ADC7 ADC15 ADC23 0
+
+    /** Number of words at the start of each frame that the vector kernels convert */
+    static constexpr int SpanWords = 32;
+
+    static constexpr std::array<int, AdcsPerProbe> adcIndices = {
+        0,
+        1,
+        2,
+        4,
+        5,
+        6,
+        8,
+        9,
+        10,
+        12,
+        13,
+        14,
+        16,
+        17,
+        18,
+        20,
+        21,
+        22,
+        24,
+        25,
+        26,
+        28,
+        29,
+        30
+    };
+
+    static constexpr std::array<std::array<int, FramesPerSuperFrame>, AdcsPerProbe> rawToChannel = {
+        {
+         { 0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30 }, // Data Index 9, ADC 0
+            { 128, 130, 132, 134, 136, 138, 140, 142, 144, 146, 148, 150, 152, 154, 156, 158 }, // Data Index 10, ADC 8
+            { 256, 258, 260, 262, 264, 266, 268, 270, 272, 274, 276, 278, 280, 282, 284, 286 }, // Data Index 11, ADC 16
+
+            { 1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31 }, // Data Index 13, ADC 1
+            { 129, 131, 133, 135, 137, 139, 141, 143, 145, 147, 149, 151, 153, 155, 157, 159 }, // Data Index 14, ADC 9
+            { 257, 259, 261, 263, 265, 267, 269, 271, 273, 275, 277, 279, 281, 283, 285, 287 }, // Data Index 15, ADC 17
+
+            { 32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62 }, // Data Index 17, ADC 2
+            { 160, 162, 164, 166, 168, 170, 172, 174, 176, 178, 180, 182, 184, 186, 188, 190 }, // Data Index 18, ADC 10
+            { 288, 290, 292, 294, 296, 298, 300, 302, 304, 306, 308, 310, 312, 314, 316, 318 }, // Data Index 19, ADC 18
+
+            { 33, 35, 37, 39, 41, 43, 45, 47, 49, 51, 53, 55, 57, 59, 61, 63 }, // Data Index 21, ADC 3
+            { 161, 163, 165, 167, 169, 171, 173, 175, 177, 179, 181, 183, 185, 187, 189, 191 }, // Data Index 22, ADC 11
+            { 289, 291, 293, 295, 297, 299, 301, 303, 305, 307, 309, 311, 313, 315, 317, 319 }, // Data Index 23, ADC 19
+
+            { 64, 66, 68, 70, 72, 74, 76, 78, 80, 82, 84, 86, 88, 90, 92, 94 }, // Data Index 25, ADC 4
+            { 192, 194, 196, 198, 200, 202, 204, 206, 208, 210, 212, 214, 216, 218, 220, 222 }, // Data Index 26, ADC 12
+            { 320, 322, 324, 326, 328, 330, 332, 334, 336, 338, 340, 342, 344, 346, 348, 350 }, // Data Index 27, ADC 20
+
+            { 65, 67, 69, 71, 73, 75, 77, 79, 81, 83, 85, 87, 89, 91, 93, 95 }, // Data Index 29, ADC 5
+            { 193, 195, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221, 223 }, // Data Index 30, ADC 13
+            { 321, 323, 325, 327, 329, 331, 333, 335, 337, 339, 341, 343, 345, 347, 349, 351 }, // Data Index 31, ADC 21
+
+            { 96, 98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124, 126 }, // Data Index 33, ADC 6
+            { 224, 226, 228, 230, 232, 234, 236, 238, 240, 242, 244, 246, 248, 250, 252, 254 }, // Data Index 34, ADC 14
+            { 352, 354, 356, 358, 360, 362, 364, 366, 368, 370, 372, 374, 376, 378, 380, 382 }, // Data Index 35, ADC 22
+
+            { 97, 99, 101, 103, 105, 107, 109, 111, 113, 115, 117, 119, 121, 123, 125, 127 }, // Data Index 37, ADC 7
+            { 225, 227, 229, 231, 233, 235, 237, 239, 241, 243, 245, 247, 249, 251, 253, 255 }, // Data Index 38, ADC 15
+            { 353, 355, 357, 359, 361, 363, 365, 367, 369, 371, 373, 375, 377, 379, 381, 383 }, // Data Index 39, ADC 23
+        }
+    };
+
+    /** Output offsets of the samples of each frame, in the order of adcIndices */
+    using OutputTable = std::array<int32_t, FramesPerSuperFrame * AdcsPerProbe>;
+
+    /** Output offsets of the first SpanWords words of each frame, with zero for the words that are not samples */
+    using SpanTable = std::array<int32_t, FramesPerSuperFrame * SpanWords>;
+
+    /** Creates a decoder that writes channel c at c * channelStride, using the scalar kernel */
+    explicit Neuropixels2eDecoder (int channelStride);
+
+    /** Rebuilds the output tables to write channel c at c * channelStride */
+    void setChannelStride (int channelStride);
+
+    void setInstructionSet (InstructionSet instructionSet);
+    InstructionSet getInstructionSet() const { return instructionSet; }
+
+    /** Writes the samples of one superframe to samples, which points at the sample of the first channel */
+    void decode (const uint16_t* amplifierData, float gain, float offset, float* samples) const
+    {
+        kernel (*this, amplifierData, gain, offset, samples);
+    }
+
+    int getChannelStride() const { return channelStride; }
+    const OutputTable& getOutputOffsets() const { return outputOffsets; }
+    const SpanTable& getSpanOffsets() const { return spanOffsets; }
+
+    /** Returns a mask with one bit for each of the words SpanWords / 2 * half to SpanWords / 2 * (half + 1) of a
+        frame, set if the word is an ADC sample */
+    static constexpr uint16_t getSpanSampleMask (int half)
+    {
+        uint16_t mask = 0;
+
+        for (int index : adcIndices)
+        {
+            if (index / (SpanWords / 2) == half)
+                mask |= (uint16_t) (1 << (index % (SpanWords / 2)));
+        }
+
+        return mask;
+    }
+
+private:
+    using Kernel = void (*) (const Neuropixels2eDecoder&, const uint16_t*, float, float, float*);
+
+    int channelStride;
+
+    OutputTable outputOffsets;
+    SpanTable spanOffsets;
+
+    InstructionSet instructionSet = InstructionSet::Scalar;
+    Kernel kernel;
+};
+} // namespace OnixSourcePlugin
@@ -46,7 +46,7 @@ NeuropixelsProbeMetadata::NeuropixelsProbeMetadata (I2CRegisterContext* flex, On
         if (rc != ONI_ESUCCESS)
             throw error_t (rc);
 
-        for (int i = 0; i < probeSnBytes.size(); i++)
+        for (int i = 0; i < (int) probeSnBytes.size(); i++)
         {
             if (probeSnBytes[i] <= 0xFF)
             {
@@ -76,7 +76,7 @@ NeuropixelsProbeMetadata::NeuropixelsProbeMetadata (I2CRegisterContext* flex, On
 
         flexVersion = std::to_string (version) + "." + std::to_string (revision);
     }
-    catch (const error_t e)
+    catch (const error_t& e)
     {
         if (e.num() == ONI_EREADFAILURE)
             return;
@@ -136,7 +136,7 @@ std::string NeuropixelsProbeMetadata::getProbeTypeString(std::string partNumber)
         return "Invalid part number";
 }
 
-const uint64_t NeuropixelsProbeMetadata::getProbeSerialNumber() const
+uint64_t NeuropixelsProbeMetadata::getProbeSerialNumber() const
 {
     return probeSerialNumber;
 }
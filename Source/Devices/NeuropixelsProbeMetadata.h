@@ -34,7 +34,7 @@ public:
     NeuropixelsProbeMetadata() = default;
     NeuropixelsProbeMetadata (I2CRegisterContext* flex, OnixDeviceType type);
 
-    const uint64_t getProbeSerialNumber() const;
+    uint64_t getProbeSerialNumber() const;
     const std::string getProbePartNumber() const;
     const std::string getFlexPartNumber() const;
     const std::string getFlexVersion() const;
@@ -78,13 +78,14 @@ void OutputClock::startAcquisition()
 {
 }
 
-void OutputClock::addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers)
+void OutputClock::addSourceBuffers (OwnedArray<DataBuffer>&)
 {
 }
 
-void OutputClock::addFrame (oni_frame_t* frame)
+void OutputClock::addFrames (oni_frame_t* const* frames, size_t count, int64_t)
 {
-    oni_destroy_frame (frame);
+    for (size_t i = 0; i < count; i++)
+        deviceContext->destroyFrame (frames[i]);
 }
 
 void OutputClock::processFrames()
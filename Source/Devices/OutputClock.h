@@ -49,9 +49,12 @@ public:
     bool updateSettings() override;
     void startAcquisition() override;
     void addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers) override;
-    void addFrame (oni_frame_t* frame) override;
+    void addFrames (oni_frame_t* const* frames, size_t count, int64_t readTime) override;
     void processFrames() override;
 
+    /** Frames from the output clock are destroyed as they arrive, so none are queued */
+    double getFramesPerSecond() const override { return 0.0; }
+
     double getFrequencyHz() const;
     void setFrequencyHz (double frequency);
 
@@ -199,6 +199,8 @@ void PolledBno055::startAcquisition()
 
 void PolledBno055::run()
 {
+    LOGC (getName(), " polling thread policy: ", threadPolicy.applyToCurrentThread());
+
     while (! threadShouldExit())
     {
         time_point now = std::chrono::steady_clock::now();
@@ -223,9 +225,10 @@ void PolledBno055::stopAcquisition()
         stopThread (500);
 }
 
-void PolledBno055::addFrame (oni_frame_t* frame)
+void PolledBno055::addFrames (oni_frame_t* const* frames, size_t count, int64_t)
 {
-    oni_destroy_frame (frame);
+    for (size_t i = 0; i < count; i++)
+        deviceContext->destroyFrame (frames[i]);
 }
 
 void PolledBno055::addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers)
@@ -314,7 +317,9 @@ void PolledBno055::pollFrame()
 
     if (currentFrame >= NumFrames)
     {
+        TraceScope trace ("DataBuffer::addToBuffer", "buffer", "samples", NumFrames);
         bnoBuffer->addToBuffer (bnoSamples.data(), sampleNumbers, bnoTimestamps, eventCodes, NumFrames);
+        recordBufferWrite (NumFrames);
         currentFrame = 0;
     }
 }
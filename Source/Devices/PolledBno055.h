@@ -26,6 +26,7 @@
 
 #include "../I2CRegisterContext.h"
 #include "../OnixDevice.h"
+#include "../ThreadPolicy.h"
 #include "DS90UB9x.h"
 #include "PortController.h"
 
@@ -45,8 +46,11 @@ public:
     bool updateSettings() override;
     void startAcquisition() override;
     void stopAcquisition() override;
-    void addFrame (oni_frame_t*) override;
+    void addFrames (oni_frame_t* const* frames, size_t count, int64_t readTime) override;
     void processFrames() override;
+
+    /** Samples are polled over I2C instead of streamed, so no frames are queued */
+    double getFramesPerSecond() const override { return 0.0; }
     void pollFrame();
     void addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers) override;
 
@@ -75,6 +79,9 @@ public:
     void setBnoAxisMap (Bno055AxisMap map);
     void setBnoAxisSign (uint32_t sign);
 
+    /** Sets the affinity and scheduling policy applied when the polling thread starts */
+    void setThreadPolicy (ThreadPolicy policy) { threadPolicy = policy; }
+
 private:
     using time_point = std::chrono::time_point<std::chrono::steady_clock>;
 
@@ -114,6 +121,8 @@ private:
 
     time_point previousTime;
 
+    ThreadPolicy threadPolicy;
+
     int16_t readInt16 (uint32_t);
     static int16_t getInt16FromUint32 (uint32_t, bool);
 
@@ -21,6 +21,9 @@
 */
 
 #include "PortController.h"
+#include "../AsyncLogger.h"
+
+#include <cmath>
 
 using namespace OnixSourcePlugin;
 
@@ -72,8 +75,25 @@ bool PortController::updateSettings()
     return getLinkFlags() == 0;
 }
 
-void PortController::addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers)
+void PortController::addSourceBuffers (OwnedArray<DataBuffer>&)
+{
+}
+
+void PortController::registerMetrics (MetricsRegistry& registry)
 {
+    OnixDevice::registerMetrics (registry);
+
+    const auto prefix = getInstanceName() + ".";
+
+    // NB: getLinkFlags shows a message box if the register cannot be read, which an unattended log must not do
+    registry.addGauge (prefix + "link_flags", [this]
+                       {
+                           oni_reg_val_t linkFlags;
+                           int rc = deviceContext->readRegister (deviceIdx, (uint32_t) PortControllerRegister::LINKFLAGS, &linkFlags);
+                           return rc == ONI_ESUCCESS ? (double) linkFlags : std::nan ("");
+                       });
+    registry.addGauge (prefix + "lock_lost", [this]
+                       { return errorFlag ? 1.0 : 0.0; });
 }
 
 std::string PortController::getPortNameString() const
@@ -104,7 +124,7 @@ void PortController::startAcquisition()
 void PortController::processFrames()
 {
     oni_frame_t* frame;
-    while (frameQueue.try_dequeue (frame))
+    while (dequeueFrame (frame))
     {
         int8_t* dataPtr = (int8_t*) frame->data;
 
@@ -114,9 +134,9 @@ void PortController::processFrames()
 
         errorFlag = errorFlag || ((uint32_t) data & LINKSTATE_SL) == 0;
 
-        oni_destroy_frame (frame);
+        deviceContext->destroyFrame (frame);
 
-        LOGE ("Port status changed for " + getName() + ".");
+        AsyncLogger::log (AsyncLogger::Level::Error, "Port status changed.", getInternedName());
     }
 }
 
@@ -145,13 +165,15 @@ DiscoveryParameters PortController::getHeadstageDiscoveryParameters (std::string
 
 bool PortController::configureVoltage (double voltage)
 {
+    TraceScope trace ("PortController::configureVoltage", "port", "volts", voltage);
+
     if (voltage == defaultVoltage)
     {
         if (discoveryParameters == DiscoveryParameters() || discoveryParameters.voltageIncrement <= 0)
             return false;
 
         ConfigureVoltageWithProgressBar progressBar = ConfigureVoltageWithProgressBar (discoveryParameters, this);
-        progressBar.runThread();
+        Onix1::getStatusReporter()->runTask (progressBar);
 
         bool result = progressBar.getResult();
 
@@ -177,6 +199,8 @@ bool PortController::configureVoltage (double voltage)
 
 void PortController::setVoltageOverride (double voltage, bool waitToSettle)
 {
+    TraceScope trace ("PortController::setVoltageOverride", "port", "volts", voltage);
+
     if (voltage < 0.0 && voltage > 7.0)
     {
         LOGE ("Invalid voltage value. Tried to set the port to " + std::to_string (voltage) + " V.");
@@ -195,6 +219,8 @@ void PortController::setVoltageOverride (double voltage, bool waitToSettle)
 
 void PortController::setVoltage (double voltage)
 {
+    TraceScope trace ("PortController::setVoltage", "port", "volts", voltage);
+
     if (voltage < 0.0 && voltage > 7.0)
     {
         LOGE ("Invalid voltage value. Tried to set the port to " + std::to_string (voltage) + " V.");
@@ -217,6 +243,8 @@ void PortController::setVoltage (double voltage)
 
 bool PortController::checkLinkState() const
 {
+    TraceScope trace ("PortController::checkLinkState", "port");
+
     oni_reg_val_t linkState;
     int rc = deviceContext->readRegister ((oni_dev_idx_t) port, (oni_reg_addr_t) PortControllerRegister::LINKSTATE, &linkState);
 
@@ -91,6 +91,10 @@ public:
     void startAcquisition() override;
     void processFrames() override;
     void addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers) override;
+    void registerMetrics (MetricsRegistry& registry) override;
+
+    /** Frames only arrive when the link state changes, so the queue needs no room beyond one block read */
+    double getFramesPerSecond() const override { return 0.0; }
 
     void updateDiscoveryParameters (DiscoveryParameters parameters);
 
@@ -138,11 +142,11 @@ private:
     JUCE_LEAK_DETECTOR (PortController);
 };
 
-class ConfigureVoltageWithProgressBar : public ThreadWithProgressWindow
+class ConfigureVoltageWithProgressBar : public ProgressTask
 {
 public:
     ConfigureVoltageWithProgressBar (DiscoveryParameters params, PortController* port)
-        : ThreadWithProgressWindow ("Configuring voltage on " + port->getPortNameString(), true, false)
+        : ProgressTask ("Configuring voltage on " + port->getPortNameString())
     {
         m_params = params;
         m_port = port;
@@ -0,0 +1,824 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "EmulatorDriver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+#include "../Devices/DS90UB9x.h"
+#include "../Onix1.h"
+
+using namespace OnixSourcePlugin;
+
+namespace
+{
+// NB: IDs from the ONIX device registry. The plugin locates devices by index, and only checks the ID of passthrough devices.
+constexpr oni_dev_id_t Bno055Id = 9, Neuropixels1Id = 11, DigitalIOId = 18, OutputClockId = 20, AnalogIOId = 22, PortControllerId = 23, MemoryMonitorId = 28, HarpSyncInputId = 30;
+
+// NB: Mirrors the register maps and constants of the device classes, which are not all visible outside of them
+constexpr oni_dev_idx_t PortControllerIndexA = 1, PortControllerIndexB = 2, OutputClockIndex = 5, AnalogIOIndex = 6, DigitalIOIndex = 7, PassthroughIndexA = 8, MemoryMonitorIndex = 10, HarpSyncInputIndex = 12;
+constexpr oni_reg_addr_t LinkStateRegister = 5, LinkFlagsRegister = 7, DigitalIOBaseFreqRegister = 5, OutputClockBaseFreqRegister = 6, MemoryMonitorClockRegister = 2, MemoryMonitorTotalRegister = 3;
+constexpr oni_reg_val_t LinkStateLocked = 0x3;
+
+constexpr uint32_t HeadstageEepromAddress = 0x51, HeadstageIdOffset = 18;
+constexpr uint32_t FlexEepromAddress = 0x50, Neuropixels1ProbeAddress = 0x70, Neuropixels2ProbeAddress = 0x10;
+constexpr uint32_t Neuropixels1StatusRegister = 0x08, Neuropixels2StatusRegister = 0x09, ShiftRegisterSuccess = 1 << 7;
+
+constexpr uint32_t MemoryMonitorTotalWords = 1 << 28;
+
+constexpr size_t FrameHeaderSize = sizeof (oni_fifo_time_t) + 2 * sizeof (oni_fifo_dat_t);
+
+constexpr double Pi = 3.14159265358979323846;
+
+/** Sample of a slow sine wave, used to give each payload variant a recognizable waveform */
+int16_t waveform (int variant, int channel, double amplitude)
+{
+    return (int16_t) std::lround (amplitude * std::sin (2.0 * Pi * (variant + 3 * channel) / 64.0));
+}
+
+// NB: Payload layouts match the processFrames method of the device classes. The hub clock, where present, is
+//     written over the first four words of each frame when it is produced.
+
+void fillAnalogIOPayload (uint8_t* payload, int variant)
+{
+    auto data = (int16_t*) payload + 4;
+    for (int i = 0; i < 12; i++)
+        data[i] = waveform (variant, i, 8000.0);
+}
+
+void fillDigitalIOPayload (uint8_t* payload, int variant)
+{
+    auto data = (uint16_t*) payload;
+    data[4] = (uint16_t) ((variant / 8) & 0xFF); // NB: Digital inputs
+    data[5] = 0; // NB: Buttons
+}
+
+void fillMemoryMonitorPayload (uint8_t* payload, int variant)
+{
+    auto data = (uint32_t*) payload;
+    data[2] = MemoryMonitorTotalWords / 100 * (1 + variant % 4);
+}
+
+void fillBno055Payload (uint8_t* payload, int variant)
+{
+    auto data = (int16_t*) payload + 4;
+    for (int i = 0; i < 14; i++)
+        data[i] = waveform (variant, i, 1000.0);
+}
+
+void fillNeuropixels1fPayload (uint8_t* payload, int variant)
+{
+    auto data = (uint16_t*) payload;
+    for (int i = 0; i < 13 * 36; i++)
+        data[i] = (uint16_t) ((512 + waveform (variant, i % 36, 40.0)) << 5);
+}
+
+void fillNeuropixels1ePayload (uint8_t* payload, int variant)
+{
+    auto data = (uint16_t*) payload;
+    data[4] = 0; // NB: Probe index
+    for (int i = 0; i < 13 * 40; i++)
+        data[5 + i] = (uint16_t) (512 + waveform (variant, i % 40, 40.0));
+}
+
+void fillNeuropixels2ePayload (uint8_t* payload, int variant, uint16_t probe)
+{
+    auto data = (uint16_t*) payload;
+    data[4] = probe;
+    for (int i = 0; i < 16 * 36; i++)
+        data[9 + i] = (uint16_t) (2048 + waveform (variant, i % 36, 100.0));
+}
+
+/** Orders a heap of stream indices so that the stream with the earliest next frame is on top */
+template <typename Streams>
+auto laterStream (const Streams& streams)
+{
+    return [&streams] (size_t a, size_t b)
+    { return streams[a].nextTick > streams[b].nextTick; };
+}
+} // namespace
+
+EmulatorDriver::EmulatorDriver (EmulatorSettings settings_)
+    : settings (settings_)
+{
+}
+
+EmulatorDriver::~EmulatorDriver()
+{
+    clearPendingFrames();
+}
+
+EmulatorSettings EmulatorDriver::parseSettings (const std::string& driverName)
+{
+    EmulatorSettings result;
+
+    auto separator = driverName.find (':');
+    if (separator == std::string::npos)
+    {
+        if (driverName != Name)
+            throw error_str ("Unknown emulator driver name '" + driverName + "'.");
+
+        return result;
+    }
+
+    std::stringstream options (driverName.substr (separator + 1));
+    std::string option;
+
+    while (std::getline (options, option, ','))
+    {
+        auto equals = option.find ('=');
+        if (equals == std::string::npos)
+            throw error_str ("Emulator option '" + option + "' is not of the form key=value.");
+
+        auto key = option.substr (0, equals);
+        auto value = option.substr (equals + 1);
+
+        if (key == "A" || key == "B")
+        {
+            EmulatedHeadstage headstage;
+
+            if (value == "none")
+                headstage = EmulatedHeadstage::None;
+            else if (value == "np1e")
+                headstage = EmulatedHeadstage::Neuropixels1e;
+            else if (value == "np1f")
+                headstage = EmulatedHeadstage::Neuropixels1f;
+            else if (value == "np2e")
+                headstage = EmulatedHeadstage::Neuropixels2e;
+            else
+                throw error_str ("Unknown emulated headstage '" + value + "'. Expected none, np1e, np1f, or np2e.");
+
+            result.ports[key == "A" ? 0 : 1] = headstage;
+        }
+        else if (key == "extra")
+        {
+            try
+            {
+                result.extraHeadstages = std::stoi (value);
+            }
+            catch (const std::exception&)
+            {
+                throw error_str ("Invalid number of extra headstages '" + value + "'.");
+            }
+
+            if (result.extraHeadstages < 0 || result.extraHeadstages > EmulatorSettings::MaxExtraHeadstages)
+                throw error_str ("The number of extra headstages must be between 0 and " + std::to_string (EmulatorSettings::MaxExtraHeadstages) + ".");
+        }
+        else if (key == "rate")
+        {
+            try
+            {
+                result.rate = std::stod (value);
+            }
+            catch (const std::exception&)
+            {
+                throw error_str ("Invalid emulator rate '" + value + "'.");
+            }
+
+            if (result.rate < 0.0)
+                throw error_str ("The emulator rate must not be negative.");
+        }
+        else if (key == "drop")
+        {
+            try
+            {
+                result.dropInterval = std::stoi (value);
+            }
+            catch (const std::exception&)
+            {
+                throw error_str ("Invalid emulator drop interval '" + value + "'.");
+            }
+
+            if (result.dropInterval < 0 || result.dropInterval == 1)
+                throw error_str ("The emulator drop interval must be 0, to keep every frame, or at least 2.");
+        }
+        else
+        {
+            throw error_str ("Unknown emulator option '" + key + "'.");
+        }
+    }
+
+    return result;
+}
+
+std::array<EmulatedHeadstage, 2> EmulatorDriver::getHeadstages (const std::vector<oni_device_t>& deviceTable)
+{
+    std::array<EmulatedHeadstage, 2> headstages = { EmulatedHeadstage::None, EmulatedHeadstage::None };
+
+    for (const auto& device : deviceTable)
+    {
+        for (int port = 0; port < (int) headstages.size(); port++)
+        {
+            const oni_dev_idx_t hubIndex = (oni_dev_idx_t) (port + 1) << 8;
+
+            if (device.idx == hubIndex && device.id == Neuropixels1Id)
+                headstages[port] = EmulatedHeadstage::Neuropixels1f;
+            else if (device.idx == PassthroughIndexA + port && device.id == ONIX_DS90UB9RAW)
+                headstages[port] = device.read_size == 1170 ? EmulatedHeadstage::Neuropixels2e : EmulatedHeadstage::Neuropixels1e;
+        }
+    }
+
+    return headstages;
+}
+
+int EmulatorDriver::init (int hostIndex_)
+{
+    const std::lock_guard<std::mutex> lock (stateLock);
+
+    hostIndex = hostIndex_;
+    rebuildDeviceTable();
+
+    return ONI_ESUCCESS;
+}
+
+EmulatorDriver::FrameStream EmulatorDriver::createStream (oni_dev_idx_t deviceIndex, uint32_t dataSize, double frequencyHz, bool hasHubClock, PayloadGenerator generator, int counterWord)
+{
+    FrameStream stream;
+
+    stream.deviceIndex = deviceIndex;
+    stream.dataSize = dataSize;
+    stream.periodTicks = AcquisitionClockHz / frequencyHz;
+    stream.hasHubClock = hasHubClock;
+    stream.counterWord = counterWord;
+
+    stream.payloads.resize (NumPayloads);
+
+    for (int i = 0; i < NumPayloads; i++)
+    {
+        stream.payloads[i].resize (dataSize, 0);
+        generator (stream.payloads[i].data(), i);
+    }
+
+    return stream;
+}
+
+EmulatorDriver::EmulatedDevice& EmulatorDriver::addDevice (oni_dev_idx_t index, oni_dev_id_t id, uint32_t readSize, oni_reg_addr_t enableRegister)
+{
+    EmulatedDevice device;
+
+    device.device = { index, id, 1, readSize, 0 };
+    device.enableRegister = enableRegister;
+
+    return devices[index] = std::move (device);
+}
+
+void EmulatorDriver::rebuildDeviceTable()
+{
+    devices.clear();
+
+    // NB: Breakout board
+    registers[{ ONIX_HUB_DEV_IDX, ONIX_HUB_HARDWAREID }] = ONIX_HUB_FMCHOST;
+    registers[{ ONIX_HUB_DEV_IDX, ONIX_HUB_FIRMWAREVER }] = 0x0200;
+
+    addDevice (PortControllerIndexA, PortControllerId, 0);
+    addDevice (PortControllerIndexB, PortControllerId, 0);
+
+    addDevice (OutputClockIndex, OutputClockId, 0);
+    registers[{ OutputClockIndex, OutputClockBaseFreqRegister }] = AcquisitionClockHz;
+
+    addDevice (AnalogIOIndex, AnalogIOId, 32).streams.push_back (createStream (AnalogIOIndex, 32, 100e3, true, fillAnalogIOPayload));
+
+    addDevice (DigitalIOIndex, DigitalIOId, 12).streams.push_back (createStream (DigitalIOIndex, 12, 25e3, true, fillDigitalIOPayload));
+    registers[{ DigitalIOIndex, DigitalIOBaseFreqRegister }] = AcquisitionClockHz;
+
+    addDevice (MemoryMonitorIndex, MemoryMonitorId, 12).streams.push_back (createStream (MemoryMonitorIndex, 12, 100.0, true, fillMemoryMonitorPayload));
+    registers[{ MemoryMonitorIndex, MemoryMonitorClockRegister }] = AcquisitionClockHz;
+    registers[{ MemoryMonitorIndex, MemoryMonitorTotalRegister }] = MemoryMonitorTotalWords;
+
+    // NB: The Harp time in seconds is the frame count, written into the third 32-bit word
+    addDevice (HarpSyncInputIndex, HarpSyncInputId, 12).streams.push_back (createStream (HarpSyncInputIndex, 12, 1.0, true, [] (uint8_t*, int) {}, 2));
+
+    for (int port = 0; port < (int) settings.ports.size(); port++)
+    {
+        // NB: ONIX_OPT_PASSTHROUGH uses bit 0 for port A, and bit 2 for port B
+        addHeadstage (port, settings.ports[port], (passthrough & (1u << (2 * port))) != 0);
+    }
+
+    // NB: Extra headstages continue the hub numbering after port B, and have no port controller
+    for (int i = 0; i < settings.extraHeadstages; i++)
+    {
+        const int hub = (int) settings.ports.size() + i;
+
+        addNeuropixels1fHub ((oni_dev_idx_t) (hub + 1) << 8, 0x1000 + 0x10 * hub);
+    }
+
+    for (const auto& [hubIndex, hub] : settings.hubs)
+    {
+        registers[{ (oni_dev_idx_t) hubIndex + ONIX_HUB_DEV_IDX, ONIX_HUB_HARDWAREID }] = hub.first;
+        registers[{ (oni_dev_idx_t) hubIndex + ONIX_HUB_DEV_IDX, ONIX_HUB_FIRMWAREVER }] = hub.second;
+    }
+}
+
+void EmulatorDriver::addHeadstage (int port, EmulatedHeadstage headstage, bool passthroughEnabled)
+{
+    const oni_dev_idx_t portController = port == 0 ? PortControllerIndexA : PortControllerIndexB;
+    const oni_dev_idx_t hubIndex = (oni_dev_idx_t) (port + 1) << 8;
+    const oni_dev_idx_t passthroughIndex = PassthroughIndexA + port;
+
+    registers[{ portController, LinkStateRegister }] = headstage == EmulatedHeadstage::None ? 0 : LinkStateLocked;
+    registers[{ portController, LinkFlagsRegister }] = 0;
+
+    const uint64_t serialNumber = 0x1000 + 0x10 * port;
+
+    if (headstage == EmulatedHeadstage::Neuropixels1f && ! passthroughEnabled)
+    {
+        addNeuropixels1fHub (hubIndex, serialNumber);
+    }
+    else if ((headstage == EmulatedHeadstage::Neuropixels1e || headstage == EmulatedHeadstage::Neuropixels2e) && passthroughEnabled)
+    {
+        const bool isNeuropixels2 = headstage == EmulatedHeadstage::Neuropixels2e;
+        const uint32_t hsid = isNeuropixels2 ? ONIX_HUB_HSNP2E : ONIX_HUB_HSNP1ET;
+
+        auto& device = addDevice (passthroughIndex, ONIX_DS90UB9RAW, isNeuropixels2 ? 1170 : 1050, DS90UB9x::ENABLE);
+        device.hasI2CBridge = true;
+
+        writeI2C (passthroughIndex, HeadstageEepromAddress, HeadstageIdOffset, { (uint8_t) hsid, (uint8_t) (hsid >> 8), (uint8_t) (hsid >> 16), (uint8_t) (hsid >> 24) });
+
+        if (isNeuropixels2)
+        {
+            device.hasProbeSelect = true;
+
+            for (uint16_t probe = 0; probe < 2; probe++)
+            {
+                device.streams.push_back (createStream (passthroughIndex, 1170, 30e3, true, [probe] (uint8_t* payload, int variant)
+                                                        { fillNeuropixels2ePayload (payload, variant, probe); }));
+
+                writeProbeMetadata (passthroughIndex, true, serialNumber + probe, "NP2014", probe);
+            }
+
+            writeI2C (passthroughIndex, Neuropixels2ProbeAddress, Neuropixels2StatusRegister, { ShiftRegisterSuccess });
+        }
+        else
+        {
+            device.streams.push_back (createStream (passthroughIndex, 1050, 30e3, true, fillNeuropixels1ePayload));
+
+            writeProbeMetadata (passthroughIndex, false, serialNumber, "PRB_1_4_0480_1");
+            writeI2C (passthroughIndex, Neuropixels1ProbeAddress, Neuropixels1StatusRegister, { ShiftRegisterSuccess });
+        }
+    }
+}
+
+void EmulatorDriver::addNeuropixels1fHub (oni_dev_idx_t hubIndex, uint64_t serialNumber)
+{
+    registers[{ hubIndex + ONIX_HUB_DEV_IDX, ONIX_HUB_HARDWAREID }] = ONIX_HUB_HSNP;
+
+    for (oni_dev_idx_t probe = 0; probe < 2; probe++)
+    {
+        auto& device = addDevice (hubIndex + probe, Neuropixels1Id, 936, DS90UB9x::ENABLE);
+        device.hasI2CBridge = true;
+        device.streams.push_back (createStream (hubIndex + probe, 936, 30e3, false, fillNeuropixels1fPayload));
+
+        writeProbeMetadata (hubIndex + probe, false, serialNumber + probe, "PRB_1_4_0480_1");
+        writeI2C (hubIndex + probe, Neuropixels1ProbeAddress, Neuropixels1StatusRegister, { ShiftRegisterSuccess });
+    }
+
+    addDevice (hubIndex + 2, Bno055Id, 36).streams.push_back (createStream (hubIndex + 2, 36, 100.0, true, fillBno055Payload));
+}
+
+void EmulatorDriver::writeI2C (oni_dev_idx_t deviceIndex, uint32_t i2cAddress, uint32_t offset, const std::vector<uint8_t>& bytes, uint32_t bank)
+{
+    for (size_t i = 0; i < bytes.size(); i++)
+        i2cMemory[{ deviceIndex, i2cAddress | (bank << 8), offset + (uint32_t) i }] = bytes[i];
+}
+
+void EmulatorDriver::writeProbeMetadata (oni_dev_idx_t deviceIndex, bool isNeuropixels2, uint64_t serialNumber, const std::string& partNumber, uint32_t bank)
+{
+    // NB: Offsets of the probe serial number, flex version, flex revision, flex part number, and probe part number
+    const uint32_t serialNumberOffset = 0;
+    const uint32_t flexVersionOffset = isNeuropixels2 ? 0x10 : 10;
+    const uint32_t flexPartNumberOffset = isNeuropixels2 ? 0x20 : 20;
+    const uint32_t probePartNumberOffset = isNeuropixels2 ? 0x40 : 40;
+
+    std::vector<uint8_t> serialBytes;
+    for (int i = 0; i < (int) sizeof (serialNumber); i++)
+        serialBytes.push_back ((uint8_t) (serialNumber >> (8 * i)));
+
+    const std::string flexPartNumber = isNeuropixels2 ? "NP2_FLEX_0" : "NP1_FLEX_0";
+
+    writeI2C (deviceIndex, FlexEepromAddress, serialNumberOffset, serialBytes, bank);
+    writeI2C (deviceIndex, FlexEepromAddress, flexVersionOffset, { 1, 0 }, bank);
+    writeI2C (deviceIndex, FlexEepromAddress, flexPartNumberOffset, std::vector<uint8_t> (flexPartNumber.begin(), flexPartNumber.end()), bank);
+    writeI2C (deviceIndex, FlexEepromAddress, probePartNumberOffset, std::vector<uint8_t> (partNumber.begin(), partNumber.end()), bank);
+}
+
+uint32_t EmulatorDriver::getI2CBank (const EmulatedDevice& device, uint32_t i2cAddress)
+{
+    if (! device.hasProbeSelect || i2cAddress != FlexEepromAddress)
+        return 0;
+
+    // NB: NP2e headstages route the flex EEPROM of the selected probe through a serializer GPIO, and the
+    //     most significant bit of the selection written by Neuropixels2e::selectProbe picks probe B
+    auto key = std::make_tuple (device.device.idx, (uint32_t) DS90UB9x::SER_ADDR, (uint32_t) DS90UB9x::DS90UB9xSerializerI2CRegister::GPIO32);
+    auto it = i2cMemory.find (key);
+
+    return it != i2cMemory.end() ? (it->second >> 7) & 0x1 : 0;
+}
+
+uint64_t EmulatorDriver::getAcquisitionCounter() const
+{
+    if (! running.load())
+        return stoppedTicks;
+
+    if (settings.rate <= 0.0)
+        return lastFrameTicks.load();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - runStartTime;
+
+    return runStartTicks + (uint64_t) (elapsed.count() * settings.rate * AcquisitionClockHz);
+}
+
+int EmulatorDriver::getOption (int option, void* value, size_t* size)
+{
+    const std::lock_guard<std::mutex> lock (stateLock);
+
+    auto writeValue = [value, size] (auto optionValue)
+    {
+        if (*size < sizeof (optionValue))
+            return (int) ONI_EINVALARG;
+
+        std::memcpy (value, &optionValue, sizeof (optionValue));
+        *size = sizeof (optionValue);
+
+        return (int) ONI_ESUCCESS;
+    };
+
+    switch (option)
+    {
+        case ONI_OPT_DEVICETABLE:
+        {
+            if (*size < devices.size() * sizeof (oni_device_t))
+                return ONI_EINVALARG;
+
+            auto table = (oni_device_t*) value;
+            for (const auto& [index, device] : devices)
+                *table++ = device.device;
+
+            *size = devices.size() * sizeof (oni_device_t);
+
+            return ONI_ESUCCESS;
+        }
+        case ONI_OPT_NUMDEVICES:
+            return writeValue ((oni_size_t) devices.size());
+        case ONI_OPT_RUNNING:
+            return writeValue ((oni_reg_val_t) (running.load() ? 1 : 0));
+        case ONI_OPT_SYSCLKHZ:
+        case ONI_OPT_ACQCLKHZ:
+            return writeValue ((oni_size_t) AcquisitionClockHz);
+        case ONI_OPT_HWADDRESS:
+            return writeValue ((int) hostIndex);
+        case ONI_OPT_MAXREADFRAMESIZE:
+        {
+            oni_size_t maxReadFrameSize = 0;
+            for (const auto& [index, device] : devices)
+                maxReadFrameSize = std::max (maxReadFrameSize, device.device.read_size);
+
+            return writeValue (maxReadFrameSize);
+        }
+        case ONI_OPT_MAXWRITEFRAMESIZE:
+            return writeValue ((oni_size_t) 0);
+        case ONI_OPT_BLOCKREADSIZE:
+            return writeValue ((oni_size_t) blockReadSize);
+        case ONI_OPT_BLOCKWRITESIZE:
+            return writeValue ((oni_size_t) blockWriteSize);
+        case ONIX_OPT_PASSTHROUGH:
+            return writeValue ((oni_reg_val_t) passthrough);
+        default:
+            return ONI_EINVALARG;
+    }
+}
+
+int EmulatorDriver::setOption (int option, const void* value, size_t size)
+{
+    if (size < sizeof (uint32_t))
+        return ONI_EINVALARG;
+
+    uint32_t optionValue;
+    std::memcpy (&optionValue, value, sizeof (optionValue));
+
+    const std::lock_guard<std::mutex> lock (stateLock);
+
+    switch (option)
+    {
+        case ONI_OPT_RUNNING:
+            if (optionValue != 0)
+                startAcquisition (false);
+            else
+                stopAcquisition();
+            return ONI_ESUCCESS;
+        case ONI_OPT_RESET:
+            stopAcquisition();
+            rebuildDeviceTable();
+            return ONI_ESUCCESS;
+        case ONI_OPT_RESETACQCOUNTER:
+            // NB: 1 resets the counter, and 2 resets the counter and starts acquisition
+            if (optionValue == 2)
+                startAcquisition (true);
+            else if (optionValue == 1)
+                stoppedTicks = 0;
+            return ONI_ESUCCESS;
+        case ONI_OPT_BLOCKREADSIZE:
+        case ONI_OPT_BLOCKWRITESIZE:
+        {
+            if (running.load() || optionValue == 0 || optionValue % 4 != 0)
+                return ONI_EINVALARG;
+
+            if (option == ONI_OPT_BLOCKWRITESIZE)
+            {
+                blockWriteSize = optionValue;
+                return ONI_ESUCCESS;
+            }
+
+            for (const auto& [index, device] : devices)
+            {
+                if (optionValue < device.device.read_size)
+                    return ONI_EINVALARG;
+            }
+
+            blockReadSize = optionValue;
+            return ONI_ESUCCESS;
+        }
+        case ONIX_OPT_PASSTHROUGH:
+            // NB: As on the hardware, the device table only changes on the next reset
+            passthrough = optionValue;
+            return ONI_ESUCCESS;
+        default:
+            return ONI_EINVALARG;
+    }
+}
+
+int EmulatorDriver::readRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress, oni_reg_val_t* value)
+{
+    const std::lock_guard<std::mutex> lock (stateLock);
+
+    auto device = devices.find (devIndex);
+
+    // NB: Registers at or above 0x8000 belong to the device itself, everything else is an encoded I2C transaction
+    if (device != devices.end() && device->second.hasI2CBridge && (registerAddress < 0x8000 || registerAddress >= 0x10000))
+    {
+        const uint32_t i2cAddress = registerAddress & 0x7F;
+        const uint32_t offset = (registerAddress >> 7) & 0x1FFFFF;
+        const uint32_t numBytes = ((registerAddress >> 28) & 0x3) + 1;
+        const uint32_t bank = getI2CBank (device->second, i2cAddress);
+
+        *value = 0;
+
+        for (uint32_t i = 0; i < numBytes; i++)
+        {
+            auto byte = i2cMemory.find ({ devIndex, i2cAddress | (bank << 8), offset + i });
+            if (byte != i2cMemory.end())
+                *value |= (oni_reg_val_t) byte->second << (8 * i);
+        }
+
+        return ONI_ESUCCESS;
+    }
+
+    if (device != devices.end() && device->second.hasI2CBridge && (registerAddress == DS90UB9x::LASTI2CL || registerAddress == DS90UB9x::LASTI2CH))
+    {
+        auto counter = getAcquisitionCounter();
+        *value = (oni_reg_val_t) (registerAddress == DS90UB9x::LASTI2CL ? counter : counter >> 32);
+
+        return ONI_ESUCCESS;
+    }
+
+    if (device == devices.end() && devIndex % 256 != ONIX_HUB_DEV_IDX)
+        return ONI_EINVALARG;
+
+    auto it = registers.find ({ devIndex, registerAddress });
+    *value = it != registers.end() ? it->second : 0;
+
+    return ONI_ESUCCESS;
+}
+
+int EmulatorDriver::writeRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress, oni_reg_val_t value)
+{
+    const std::lock_guard<std::mutex> lock (stateLock);
+
+    auto device = devices.find (devIndex);
+
+    if (device == devices.end())
+        return ONI_EINVALARG;
+
+    if (device->second.hasI2CBridge && (registerAddress < 0x8000 || registerAddress >= 0x10000))
+    {
+        const uint32_t i2cAddress = registerAddress & 0x7F;
+        const uint32_t offset = (registerAddress >> 7) & 0x1FFFFF;
+
+        i2cMemory[{ devIndex, i2cAddress | (getI2CBank (device->second, i2cAddress) << 8), offset }] = (uint8_t) value;
+
+        return ONI_ESUCCESS;
+    }
+
+    registers[{ devIndex, registerAddress }] = value;
+
+    return ONI_ESUCCESS;
+}
+
+void EmulatorDriver::startAcquisition (bool resetCounter)
+{
+    if (running.load() && ! resetCounter)
+        return;
+
+    runStartTicks = resetCounter ? 0 : getAcquisitionCounter();
+    runStartTime = std::chrono::steady_clock::now();
+    lastFrameTicks = runStartTicks;
+
+    runCount++;
+    running = true;
+}
+
+void EmulatorDriver::stopAcquisition()
+{
+    if (! running.load())
+        return;
+
+    stoppedTicks = getAcquisitionCounter();
+    running = false;
+}
+
+oni_frame_t* EmulatorDriver::createFrame (uint64_t time, oni_dev_idx_t deviceIndex, uint32_t dataSize)
+{
+    // NB: The payload is allocated together with the frame, directly after it
+    auto buffer = new uint8_t[sizeof (oni_frame_t) + dataSize];
+
+    return new (buffer) oni_frame_t { time, deviceIndex, dataSize, (decltype (oni_frame_t::data)) (buffer + sizeof (oni_frame_t)) };
+}
+
+void EmulatorDriver::destroyFrame (oni_frame_t* frame)
+{
+    delete[] reinterpret_cast<uint8_t*> (frame);
+}
+
+void EmulatorDriver::clearPendingFrames()
+{
+    for (auto frame : pendingFrames)
+        destroyFrame (frame);
+
+    pendingFrames.clear();
+}
+
+bool EmulatorDriver::isDeviceEnabled (oni_dev_idx_t deviceIndex) const
+{
+    auto device = devices.find (deviceIndex);
+    if (device == devices.end())
+        return false;
+
+    auto enable = registers.find ({ deviceIndex, device->second.enableRegister });
+
+    return enable != registers.end() && enable->second != 0;
+}
+
+void EmulatorDriver::waitUntilStopped() const
+{
+    while (running.load())
+        std::this_thread::sleep_for (std::chrono::milliseconds (10));
+}
+
+bool EmulatorDriver::waitUntilDue (uint64_t lastTick) const
+{
+    if (settings.rate <= 0.0)
+        return true;
+
+    // NB: The hardware only delivers a block once it is full, so every frame waits for the last one to be produced
+    const auto due = activeStartTime + std::chrono::duration_cast<std::chrono::steady_clock::duration> (std::chrono::duration<double> ((lastTick - activeStartTicks) / (settings.rate * AcquisitionClockHz)));
+
+    while (std::chrono::steady_clock::now() < due)
+    {
+        if (! running.load())
+            return false;
+
+        std::this_thread::sleep_until (std::min (due, std::chrono::steady_clock::now() + std::chrono::milliseconds (10)));
+    }
+
+    return true;
+}
+
+void EmulatorDriver::beginRun()
+{
+    activeStreams.clear();
+    streamSchedule.clear();
+
+    for (const auto& [index, device] : devices)
+    {
+        if (! isDeviceEnabled (index))
+            continue;
+
+        for (auto stream : device.streams)
+        {
+            stream.nextTick = (double) runStartTicks + stream.periodTicks;
+            activeStreams.push_back (std::move (stream));
+        }
+    }
+
+    for (size_t i = 0; i < activeStreams.size(); i++)
+        streamSchedule.push_back (i);
+
+    std::make_heap (streamSchedule.begin(), streamSchedule.end(), laterStream (activeStreams));
+}
+
+bool EmulatorDriver::fillBlock()
+{
+    if (activeStreams.empty())
+    {
+        // NB: With no enabled devices the hardware never fills a block
+        waitUntilStopped();
+        return false;
+    }
+
+    size_t numBytes = 0;
+    uint64_t lastTick = 0;
+
+    const auto compare = laterStream (activeStreams);
+
+    while (numBytes < activeBlockReadSize)
+    {
+        // NB: Every stream is visited once per frame period, so a heap keeps the cost per frame low when many
+        //     headstages are emulated
+        std::pop_heap (streamSchedule.begin(), streamSchedule.end(), compare);
+        auto& stream = activeStreams[streamSchedule.back()];
+
+        lastTick = (uint64_t) stream.nextTick;
+
+        if (settings.dropInterval > 0 && (stream.sequence + 1) % settings.dropInterval == 0)
+        {
+            stream.sequence++;
+            stream.nextTick += stream.periodTicks;
+
+            std::push_heap (streamSchedule.begin(), streamSchedule.end(), compare);
+            continue;
+        }
+
+        auto frame = createFrame (lastTick, stream.deviceIndex, stream.dataSize);
+        std::memcpy (frame->data, stream.payloads[stream.sequence % stream.payloads.size()].data(), stream.dataSize);
+
+        if (stream.hasHubClock)
+            std::memcpy (frame->data, &lastTick, sizeof (lastTick));
+
+        if (stream.counterWord >= 0)
+            ((uint32_t*) frame->data)[stream.counterWord] = (uint32_t) stream.sequence;
+
+        stream.sequence++;
+        stream.nextTick += stream.periodTicks;
+
+        std::push_heap (streamSchedule.begin(), streamSchedule.end(), compare);
+
+        pendingFrames.push_back (frame);
+        numBytes += FrameHeaderSize + stream.dataSize;
+    }
+
+    lastFrameTicks = lastTick;
+
+    return waitUntilDue (lastTick);
+}
+
+int EmulatorDriver::readFrame (oni_frame_t** frame)
+{
+    if (! running.load())
+        return ONI_EREADFAILURE;
+
+    const auto run = runCount.load();
+
+    if (run != activeRun)
+    {
+        clearPendingFrames();
+
+        const std::lock_guard<std::mutex> lock (stateLock);
+
+        activeRun = run;
+        activeBlockReadSize = blockReadSize;
+        activeStartTime = runStartTime;
+        activeStartTicks = runStartTicks;
+
+        beginRun();
+    }
+
+    if (pendingFrames.empty() && ! fillBlock())
+        return ONI_EREADFAILURE;
+
+    *frame = pendingFrames.front();
+    pendingFrames.pop_front();
+
+    return (int) (*frame)->data_sz;
+}
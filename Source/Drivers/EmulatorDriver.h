@@ -0,0 +1,224 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include <DataThreadHeaders.h>
+
+#include "OnixDriver.h"
+
+namespace OnixSourcePlugin
+{
+enum class EmulatedHeadstage
+{
+    None,
+    Neuropixels1e,
+    Neuropixels1f,
+    Neuropixels2e
+};
+
+struct EmulatorSettings
+{
+    std::array<EmulatedHeadstage, 2> ports = { EmulatedHeadstage::Neuropixels1f, EmulatedHeadstage::Neuropixels2e };
+
+    /** Number of NP1f headstages added on emulated hubs after port B, which do not exist on the hardware. Used to
+        measure how acquisition scales with the number of headstages behind one context. */
+    int extraHeadstages = 0;
+
+    /** Speed of the emulated clock relative to real time. A value of 0 generates frames as fast as they are read. */
+    double rate = 1.0;
+
+    /** If non-zero, every dropInterval-th frame of each stream is left out while its clock keeps running, as if
+        the hardware had lost it. Used to exercise the detection of missing frames. */
+    int dropInterval = 0;
+
+    /** Hardware ID and firmware version reported by each hub, keyed by hub index, in place of the emulated ones.
+        Used to replay the hub configuration recorded in a capture. */
+    std::map<int, std::pair<uint32_t, uint32_t>> hubs;
+
+    static constexpr int MaxExtraHeadstages = 30;
+};
+
+/**
+
+    In-process stand-in for an ONIX PCIe host, used to develop and profile the plugin without hardware.
+
+    Presents the device table of a breakout board with the configured headstage on each port, answers the
+    register and I2C reads needed to discover and configure each device, and generates frames in the same byte
+    layout as the hardware at the nominal rate of each device. Headstages using passthrough (NP1e, NP2e) only
+    appear on ports with passthrough enabled, and NP1f only appears on ports without it.
+
+    Selected with a driver name of the form "emulator[:A=np1f,B=np2e,extra=0,rate=1.0,drop=0]". Port values are
+    none, np1e, np1f and np2e; extra adds NP1f headstages on hubs beyond port B; rate scales the emulated clock
+    relative to real time, where 0 runs unthrottled; drop leaves out every Nth frame of each stream.
+
+    Configuration registers are stored and read back, but not interpreted; frame contents are synthetic.
+
+*/
+class EmulatorDriver : public OnixDriver
+{
+public:
+    EmulatorDriver (EmulatorSettings settings);
+
+    ~EmulatorDriver() override;
+
+    /** Prefix of every driver name that selects the emulator */
+    static constexpr const char* Name = "emulator";
+
+    /** Parses a driver name of the form "emulator[:key=value,...]". Throws error_str if the name cannot be parsed. */
+    static EmulatorSettings parseSettings (const std::string& driverName);
+
+    int init (int hostIndex) override;
+
+    int getOption (int option, void* value, size_t* size) override;
+
+    int setOption (int option, const void* value, size_t size) override;
+
+    int readRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress, oni_reg_val_t* value) override;
+
+    int writeRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress, oni_reg_val_t value) override;
+
+    int readFrame (oni_frame_t** frame) override;
+
+    void destroyFrame (oni_frame_t* frame) override;
+
+    static constexpr uint32_t AcquisitionClockHz = 250000000;
+
+    /** Returns the headstage on each port that produces the given device table. Ports with devices that
+        cannot be emulated are returned as EmulatedHeadstage::None. */
+    static std::array<EmulatedHeadstage, 2> getHeadstages (const std::vector<oni_device_t>& deviceTable);
+
+    /** Allocates a frame with room for dataSize bytes of data, which can be released with destroyFrame */
+    static oni_frame_t* createFrame (uint64_t time, oni_dev_idx_t deviceIndex, uint32_t dataSize);
+
+protected:
+    std::atomic<bool> running = false;
+    std::atomic<uint64_t> lastFrameTicks = 0;
+
+    // NB: Only accessed by the thread reading frames
+    std::deque<oni_frame_t*> pendingFrames;
+    uint32_t activeBlockReadSize = 0;
+    uint64_t activeStartTicks = 0;
+
+    /** Called from readFrame with stateLock held when a new acquisition run starts, before the first block is filled */
+    virtual void beginRun();
+
+    /** Appends the next block of frames to pendingFrames, and waits until the block is due. Returns false if
+        acquisition was stopped before a block could be delivered. */
+    virtual bool fillBlock();
+
+    /** Returns true if the device at the given index exists and is enabled. Must be called with stateLock held. */
+    bool isDeviceEnabled (oni_dev_idx_t deviceIndex) const;
+
+    /** Waits until the block ending with a frame at the given time would be delivered by the hardware. Returns
+        false if acquisition was stopped while waiting. */
+    bool waitUntilDue (uint64_t lastTick) const;
+
+    /** Blocks until acquisition is stopped, the same as the hardware when no frames are produced */
+    void waitUntilStopped() const;
+
+private:
+    /** Periodic frame source for one device, or for one probe when several share a device index */
+    struct FrameStream
+    {
+        oni_dev_idx_t deviceIndex;
+        uint32_t dataSize;
+        double periodTicks;
+        bool hasHubClock;
+        int counterWord;
+        std::vector<std::vector<uint8_t>> payloads;
+
+        double nextTick = 0.0;
+        uint64_t sequence = 0;
+    };
+
+    struct EmulatedDevice
+    {
+        oni_device_t device;
+        oni_reg_addr_t enableRegister;
+        bool hasI2CBridge = false;
+        bool hasProbeSelect = false;
+        std::vector<FrameStream> streams;
+    };
+
+    const EmulatorSettings settings;
+
+    int hostIndex = -1;
+
+    std::mutex stateLock;
+
+    std::map<oni_dev_idx_t, EmulatedDevice> devices;
+    std::map<std::pair<oni_dev_idx_t, oni_reg_addr_t>, oni_reg_val_t> registers;
+    std::map<std::tuple<oni_dev_idx_t, uint32_t, uint32_t>, uint8_t> i2cMemory;
+
+    uint32_t passthrough = 0;
+    uint32_t blockReadSize = 4096;
+    uint32_t blockWriteSize = 4096;
+
+    std::atomic<uint64_t> runCount = 0;
+    std::chrono::steady_clock::time_point runStartTime;
+    uint64_t runStartTicks = 0;
+    uint64_t stoppedTicks = 0;
+
+    // NB: Only accessed by the thread reading frames
+    uint64_t activeRun = 0;
+    std::vector<FrameStream> activeStreams;
+    std::vector<size_t> streamSchedule; // NB: Heap of indices into activeStreams, with the earliest next tick on top
+    std::chrono::steady_clock::time_point activeStartTime;
+
+    // NB: Methods below that touch the device table or registers must be called with stateLock held
+    void rebuildDeviceTable();
+    EmulatedDevice& addDevice (oni_dev_idx_t index, oni_dev_id_t id, uint32_t readSize, oni_reg_addr_t enableRegister = 0);
+    void addHeadstage (int port, EmulatedHeadstage headstage, bool passthroughEnabled);
+    void addNeuropixels1fHub (oni_dev_idx_t hubIndex, uint64_t serialNumber);
+
+    void writeI2C (oni_dev_idx_t deviceIndex, uint32_t i2cAddress, uint32_t offset, const std::vector<uint8_t>& bytes, uint32_t bank = 0);
+    void writeProbeMetadata (oni_dev_idx_t deviceIndex, bool isNeuropixels2, uint64_t serialNumber, const std::string& partNumber, uint32_t bank = 0);
+
+    uint32_t getI2CBank (const EmulatedDevice& device, uint32_t i2cAddress);
+    uint64_t getAcquisitionCounter() const;
+
+    void startAcquisition (bool resetCounter);
+    void stopAcquisition();
+
+    void clearPendingFrames();
+
+    using PayloadGenerator = std::function<void (uint8_t* payload, int variant)>;
+
+    static FrameStream createStream (oni_dev_idx_t deviceIndex, uint32_t dataSize, double frequencyHz, bool hasHubClock, PayloadGenerator generator, int counterWord = -1);
+
+    /** Number of precomputed payloads cycled through by each stream */
+    static constexpr int NumPayloads = 64;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EmulatorDriver);
+};
+} // namespace OnixSourcePlugin
@@ -0,0 +1,76 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LiboniDriver.h"
+
+#include <cerrno>
+#include <system_error>
+
+using namespace OnixSourcePlugin;
+
+LiboniDriver::LiboniDriver (const std::string& driverName)
+{
+    ctx_ = oni_create_ctx (driverName.c_str());
+
+    if (ctx_ == nullptr)
+        throw std::system_error (errno, std::system_category());
+}
+
+LiboniDriver::~LiboniDriver()
+{
+    oni_destroy_ctx (ctx_);
+}
+
+int LiboniDriver::init (int hostIndex)
+{
+    return oni_init_ctx (ctx_, hostIndex);
+}
+
+int LiboniDriver::getOption (int option, void* value, size_t* size)
+{
+    return oni_get_opt (ctx_, option, value, size);
+}
+
+int LiboniDriver::setOption (int option, const void* value, size_t size)
+{
+    return oni_set_opt (ctx_, option, value, size);
+}
+
+int LiboniDriver::readRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress, oni_reg_val_t* value)
+{
+    return oni_read_reg (ctx_, devIndex, registerAddress, value);
+}
+
+int LiboniDriver::writeRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress, oni_reg_val_t value)
+{
+    return oni_write_reg (ctx_, devIndex, registerAddress, value);
+}
+
+int LiboniDriver::readFrame (oni_frame_t** frame)
+{
+    return oni_read_frame (ctx_, frame);
+}
+
+void LiboniDriver::destroyFrame (oni_frame_t* frame)
+{
+    oni_destroy_frame (frame);
+}
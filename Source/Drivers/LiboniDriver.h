@@ -0,0 +1,60 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include "OnixDriver.h"
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Driver that forwards every call to liboni, which loads the hardware translation library for the given
+    driver name (e.g. "riffa" for the ONIX PCIe host)
+
+*/
+class LiboniDriver : public OnixDriver
+{
+public:
+    /** Constructor. Throws std::system_error if liboni cannot create a context with the given driver. */
+    LiboniDriver (const std::string& driverName);
+
+    ~LiboniDriver() override;
+
+    int init (int hostIndex) override;
+
+    int getOption (int option, void* value, size_t* size) override;
+
+    int setOption (int option, const void* value, size_t size) override;
+
+    int readRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress, oni_reg_val_t* value) override;
+
+    int writeRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress, oni_reg_val_t value) override;
+
+    int readFrame (oni_frame_t** frame) override;
+
+    void destroyFrame (oni_frame_t* frame) override;
+
+private:
+    oni_ctx ctx_;
+};
+} // namespace OnixSourcePlugin
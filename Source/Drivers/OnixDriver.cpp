@@ -0,0 +1,40 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "OnixDriver.h"
+
+#include "EmulatorDriver.h"
+#include "LiboniDriver.h"
+#include "ReplayDriver.h"
+
+using namespace OnixSourcePlugin;
+
+std::unique_ptr<OnixDriver> OnixDriver::create (const std::string& driverName)
+{
+    if (driverName.rfind (EmulatorDriver::Name, 0) == 0)
+        return std::make_unique<EmulatorDriver> (EmulatorDriver::parseSettings (driverName));
+
+    if (driverName.rfind (ReplayDriver::Name, 0) == 0)
+        return std::make_unique<ReplayDriver> (ReplayDriver::parseSettings (driverName));
+
+    return std::make_unique<LiboniDriver> (driverName);
+}
@@ -0,0 +1,65 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <oni.h>
+#include <string>
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Backend used by Onix1 to talk to the hardware. Each method mirrors the liboni function of the same
+    name, and returns ONI error codes.
+
+    Frames returned by readFrame must be released with destroyFrame on the same driver, since frames
+    from different backends are not allocated the same way.
+
+*/
+class OnixDriver
+{
+public:
+    virtual ~OnixDriver() = default;
+
+    virtual int init (int hostIndex) = 0;
+
+    virtual int getOption (int option, void* value, size_t* size) = 0;
+
+    virtual int setOption (int option, const void* value, size_t size) = 0;
+
+    virtual int readRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress, oni_reg_val_t* value) = 0;
+
+    virtual int writeRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress, oni_reg_val_t value) = 0;
+
+    virtual int readFrame (oni_frame_t** frame) = 0;
+
+    virtual void destroyFrame (oni_frame_t* frame) = 0;
+
+    /** Creates the backend for the given driver name. Names starting with EmulatorDriver::Name select the
+        in-process emulator, names starting with ReplayDriver::Name replay a capture file, and all other names are passed to liboni to load the matching driver library.
+        Throws std::system_error if the driver could not be loaded. */
+    static std::unique_ptr<OnixDriver> create (const std::string& driverName);
+};
+} // namespace OnixSourcePlugin
@@ -0,0 +1,294 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ReplayDriver.h"
+
+#include <cstring>
+
+#include "../Onix1.h"
+
+using namespace OnixSourcePlugin;
+
+namespace
+{
+EmulatorSettings getEmulatorSettings (const std::vector<oni_device_t>& deviceTable, const FrameCapture::HubInfo& hubs, double rate)
+{
+    EmulatorSettings settings;
+
+    settings.ports = EmulatorDriver::getHeadstages (deviceTable);
+    settings.hubs = hubs;
+    settings.rate = rate;
+
+    return settings;
+}
+} // namespace
+
+ReplayDriver::ReplayDriver (ReplaySettings settings_)
+    : ReplayDriver (settings_, readHeader (File::getCurrentWorkingDirectory().getChildFile (settings_.fileName)))
+{
+}
+
+ReplayDriver::ReplayDriver (ReplaySettings settings_, CaptureHeader header_)
+    : EmulatorDriver (getEmulatorSettings (header_.devices, header_.hubs, settings_.rate)), replaySettings (settings_), header (std::move (header_))
+{
+    if (header.droppedFrames > 0)
+        LOGC ("The capture file ", header.file.getFullPathName(), " is missing ", header.droppedFrames, " frames that were dropped while it was written.");
+}
+
+ReplaySettings ReplayDriver::parseSettings (const std::string& driverName)
+{
+    ReplaySettings result;
+
+    auto separator = driverName.find (':');
+    if (separator == std::string::npos || separator + 1 == driverName.size())
+        throw error_str ("The replay driver needs a capture file, as in '" + std::string (Name) + ":<file>'.");
+
+    std::string fileName = driverName.substr (separator + 1);
+
+    // NB: Options are only taken from the end of the name, so that file names may contain commas
+    while (true)
+    {
+        auto comma = fileName.rfind (',');
+        if (comma == std::string::npos)
+            break;
+
+        auto option = fileName.substr (comma + 1);
+        auto equals = option.find ('=');
+        if (equals == std::string::npos)
+            break;
+
+        auto key = option.substr (0, equals);
+        auto value = option.substr (equals + 1);
+
+        if (key == "rate")
+        {
+            try
+            {
+                result.rate = std::stod (value);
+            }
+            catch (const std::exception&)
+            {
+                throw error_str ("Invalid replay rate '" + value + "'.");
+            }
+
+            if (result.rate < 0.0)
+                throw error_str ("The replay rate must not be negative.");
+        }
+        else if (key == "loop")
+        {
+            if (value != "0" && value != "1")
+                throw error_str ("Invalid replay loop value '" + value + "'. Expected 0 or 1.");
+
+            result.loop = value == "1";
+        }
+        else
+        {
+            break;
+        }
+
+        fileName.erase (comma);
+    }
+
+    result.fileName = fileName;
+
+    return result;
+}
+
+ReplayDriver::CaptureHeader ReplayDriver::readHeader (const File& file)
+{
+    const std::string path = file.getFullPathName().toStdString();
+
+    if (! file.existsAsFile())
+        throw error_str ("The capture file " + path + " does not exist.");
+
+    FileInputStream stream (file);
+
+    if (stream.failedToOpen())
+        throw error_str ("Unable to open the capture file " + path + ": " + stream.getStatus().getErrorMessage().toStdString());
+
+    char magic[sizeof (FrameCapture::Magic)];
+
+    if (stream.read (magic, sizeof (magic)) != (int) sizeof (magic) || std::memcmp (magic, FrameCapture::Magic, sizeof (magic)) != 0)
+        throw error_str (path + " is not an ONIX capture file.");
+
+    const auto version = (uint32_t) stream.readInt();
+
+    if (version != FrameCapture::FormatVersion)
+        throw error_str ("The capture file " + path + " uses format version " + std::to_string (version) + ", but only version " + std::to_string (FrameCapture::FormatVersion) + " can be replayed.");
+
+    CaptureHeader header;
+
+    header.file = file;
+    header.acquisitionClockHz = (uint32_t) stream.readInt();
+    header.droppedFrames = (uint64_t) stream.readInt64();
+
+    // NB: Limits that no real header reaches, to reject corrupted files before allocating
+    constexpr uint32_t MaxDevices = 1 << 16, MaxHubs = 1 << 8;
+
+    const auto numDevices = (uint32_t) stream.readInt();
+
+    if (numDevices > MaxDevices)
+        throw error_str ("The device table of the capture file " + path + " is corrupted.");
+
+    for (uint32_t i = 0; i < numDevices; i++)
+    {
+        oni_device_t device;
+
+        device.idx = (oni_dev_idx_t) stream.readInt();
+        device.id = (oni_dev_id_t) stream.readInt();
+        device.version = (oni_size_t) stream.readInt();
+        device.read_size = (oni_size_t) stream.readInt();
+        device.write_size = (oni_size_t) stream.readInt();
+
+        header.devices.push_back (device);
+    }
+
+    const auto numHubs = (uint32_t) stream.readInt();
+
+    if (numHubs > MaxHubs)
+        throw error_str ("The hub table of the capture file " + path + " is corrupted.");
+
+    for (uint32_t i = 0; i < numHubs; i++)
+    {
+        const int hubIndex = stream.readInt();
+        const auto hubId = (uint32_t) stream.readInt();
+        const auto firmwareVersion = (uint32_t) stream.readInt();
+
+        header.hubs[hubIndex] = { hubId, firmwareVersion };
+    }
+
+    if (stream.isExhausted() || header.acquisitionClockHz == 0)
+        throw error_str ("The capture file " + path + " is truncated or corrupted.");
+
+    header.dataStart = stream.getPosition();
+
+    return header;
+}
+
+void ReplayDriver::rewind()
+{
+    input->setPosition (header.dataStart);
+
+    firstFrame = true;
+    framesInPass = 0;
+}
+
+void ReplayDriver::beginRun()
+{
+    enabledDevices.clear();
+
+    for (const auto& device : header.devices)
+    {
+        if (isDeviceEnabled (device.idx))
+            enabledDevices.insert (device.idx);
+    }
+
+    if (input == nullptr)
+    {
+        fileStream = std::make_unique<FileInputStream> (header.file);
+        input = std::make_unique<BufferedInputStream> (fileStream.get(), ReadBufferSize, false);
+    }
+
+    rewind();
+
+    endOfCapture = false;
+    passStartTicks = activeStartTicks;
+    lastTick = activeStartTicks;
+}
+
+bool ReplayDriver::fillBlock()
+{
+    if (endOfCapture || enabledDevices.empty())
+    {
+        waitUntilStopped();
+        return false;
+    }
+
+    const double ticksPerCaptureTick = (double) AcquisitionClockHz / header.acquisitionClockHz;
+
+    size_t numBytes = 0;
+
+    while (numBytes < activeBlockReadSize)
+    {
+        uint8_t record[Onix1::FrameHeaderSize];
+
+        if (input->read (record, sizeof (record)) != (int) sizeof (record))
+        {
+            if (replaySettings.loop && framesInPass > 0 && running.load())
+            {
+                // NB: The next pass starts one tick after the last frame, so that frame times keep increasing
+                passStartTicks = lastTick + 1;
+                rewind();
+                continue;
+            }
+
+            LOGC ("Reached the end of the capture file ", header.file.getFullPathName());
+            endOfCapture = true;
+            break;
+        }
+
+        uint64_t time;
+        uint32_t deviceIndex, dataSize;
+
+        std::memcpy (&time, record, sizeof (time));
+        std::memcpy (&deviceIndex, record + sizeof (time), sizeof (deviceIndex));
+        std::memcpy (&dataSize, record + sizeof (time) + sizeof (deviceIndex), sizeof (dataSize));
+
+        if (firstFrame)
+        {
+            firstFrameTime = time;
+            firstFrame = false;
+        }
+
+        if (enabledDevices.count (deviceIndex) == 0)
+        {
+            input->skipNextBytes (dataSize);
+            continue;
+        }
+
+        lastTick = passStartTicks + (uint64_t) ((time > firstFrameTime ? time - firstFrameTime : 0) * ticksPerCaptureTick);
+
+        auto frame = createFrame (lastTick, deviceIndex, dataSize);
+
+        if (input->read (frame->data, (int) dataSize) != (int) dataSize)
+        {
+            // NB: A capture that was not closed can end in a partial frame, which is treated as the end of the file
+            destroyFrame (frame);
+            input->setPosition (input->getTotalLength());
+            continue;
+        }
+
+        pendingFrames.push_back (frame);
+        numBytes += Onix1::FrameHeaderSize + dataSize;
+        framesInPass++;
+    }
+
+    if (pendingFrames.empty())
+    {
+        waitUntilStopped();
+        return false;
+    }
+
+    lastFrameTicks = lastTick;
+
+    return waitUntilDue (lastTick);
+}
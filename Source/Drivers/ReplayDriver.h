@@ -0,0 +1,116 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../FrameCapture.h"
+#include "EmulatorDriver.h"
+
+namespace OnixSourcePlugin
+{
+struct ReplaySettings
+{
+    std::string fileName;
+
+    /** Speed of playback relative to the recorded acquisition clock. A value of 0 replays frames as fast as they are read. */
+    double rate = 1.0;
+
+    /** Restart from the beginning of the capture when its end is reached */
+    bool loop = true;
+};
+
+/**
+
+    Replays a capture file written by FrameCapture through the normal frame reading path, so that decoding
+    can be profiled or a field problem reproduced without the hardware.
+
+    Configuration is answered by the emulator, with the headstages that produce the device table stored in
+    the capture and the hub IDs and firmware versions recorded with it, and frames are read from the file
+    instead of being generated. Frames are delivered in blocks
+    of the configured block read size, and only for devices that are enabled. Frame times are rebased onto the
+    acquisition counter of the emulator; hub clocks within the payloads are replayed as recorded.
+
+    Selected with a driver name of the form "replay:<file>[,rate=1.0][,loop=1]". A rate of 1 paces frames by
+    their recorded time, and a rate of 0 replays them as fast as they are read, to measure the maximum
+    decoding throughput of the plugin.
+
+*/
+class ReplayDriver : public EmulatorDriver
+{
+public:
+    ReplayDriver (ReplaySettings settings);
+
+    /** Prefix of every driver name that selects the replay driver */
+    static constexpr const char* Name = "replay";
+
+    /** Parses a driver name of the form "replay:<file>[,key=value...]". Throws error_str if the name cannot be parsed. */
+    static ReplaySettings parseSettings (const std::string& driverName);
+
+protected:
+    void beginRun() override;
+
+    bool fillBlock() override;
+
+private:
+    struct CaptureHeader
+    {
+        File file;
+        uint32_t acquisitionClockHz = 0;
+        uint64_t droppedFrames = 0;
+        std::vector<oni_device_t> devices;
+        FrameCapture::HubInfo hubs;
+        int64 dataStart = 0;
+    };
+
+    ReplayDriver (ReplaySettings settings, CaptureHeader header);
+
+    /** Reads the header of a capture file. Throws error_str if the file cannot be read. */
+    static CaptureHeader readHeader (const File& file);
+
+    const ReplaySettings replaySettings;
+    const CaptureHeader header;
+
+    // NB: Only accessed by the thread reading frames
+    std::unique_ptr<FileInputStream> fileStream;
+    std::unique_ptr<BufferedInputStream> input;
+    std::unordered_set<oni_dev_idx_t> enabledDevices;
+    bool endOfCapture = false;
+    bool firstFrame = true;
+    uint64_t firstFrameTime = 0;
+    uint64_t passStartTicks = 0;
+    uint64_t framesInPass = 0;
+    uint64_t lastTick = 0;
+
+    /** Moves back to the first frame of the capture */
+    void rewind();
+
+    /** Size of the buffer used to read the capture file */
+    static constexpr int ReadBufferSize = 4 * 1024 * 1024;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReplayDriver);
+};
+} // namespace OnixSourcePlugin
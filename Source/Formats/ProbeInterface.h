@@ -29,7 +29,7 @@ namespace OnixSourcePlugin
 class ProbeInterfaceJson
 {
 public:
-    static constexpr char* FileExtension = ".json";
+    static constexpr const char* FileExtension = ".json";
 
     /** Given a directory and a file name, with no extension, return a filepath that follows the format: <recordingDirectory>/<name>.json*/
     static File createFileName (File recordingDirectory, std::string name)
@@ -308,4 +308,33 @@ public:
         return true;
     }
 };
+
+template <int ch, int e>
+bool INeuropixel<ch, e>::saveProbeInterfaceFile (File recordingDirectory, std::string streamName, int probeIndex)
+{
+    if (streamName != "")
+    {
+        File filename = ProbeInterfaceJson::createFileName (recordingDirectory, streamName);
+
+        LOGC ("Saving " + filename.getFullPathName());
+
+        try
+        {
+            ProbeInterfaceJson::writeProbeSettingsToJson (filename, settings[probeIndex].get());
+        }
+        catch (const error_str& error)
+        {
+            Onix1::showWarningMessageBoxAsync ("Unable to Save Probe JSON File", error.what());
+            return false;
+        }
+    }
+    else
+    {
+        Onix1::showWarningMessageBoxAsync ("No Valid Stream",
+                                           "Could not find a valid data stream when writing the Probe Interface file.");
+        return false;
+    }
+
+    return true;
+}
 } // namespace OnixSourcePlugin
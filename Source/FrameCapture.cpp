@@ -0,0 +1,238 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "FrameCapture.h"
+
+using namespace OnixSourcePlugin;
+
+FrameCapture::FrameCapture (File file_, size_t bufferSize)
+    : Thread ("FrameCapture"), file (file_)
+{
+    buffer.resize (bufferSize);
+}
+
+FrameCapture::~FrameCapture()
+{
+    close();
+}
+
+bool FrameCapture::open (const device_map_t& deviceTable, const HubInfo& hubs, uint32_t acquisitionClockHz)
+{
+    if (file.getParentDirectory().createDirectory().failed())
+    {
+        LOGE ("Unable to create the capture directory ", file.getParentDirectory().getFullPathName());
+        return false;
+    }
+
+    stream = std::make_unique<FileOutputStream> (file, StreamBufferSize);
+
+    if (stream->failedToOpen() || ! stream->setPosition (0) || ! stream->truncate().wasOk())
+    {
+        LOGE ("Unable to open the capture file ", file.getFullPathName(), ": ", stream->getStatus().getErrorMessage());
+        stream.reset();
+        return false;
+    }
+
+    stream->write (Magic, sizeof (Magic));
+    stream->writeInt ((int) FormatVersion);
+    stream->writeInt ((int) acquisitionClockHz);
+
+    droppedFramesPosition = stream->getPosition();
+    stream->writeInt64 (0);
+
+    stream->writeInt ((int) deviceTable.size());
+
+    for (const auto& [index, device] : deviceTable)
+    {
+        stream->writeInt ((int) device.idx);
+        stream->writeInt ((int) device.id);
+        stream->writeInt ((int) device.version);
+        stream->writeInt ((int) device.read_size);
+        stream->writeInt ((int) device.write_size);
+    }
+
+    stream->writeInt ((int) hubs.size());
+
+    for (const auto& [hubIndex, hub] : hubs)
+    {
+        stream->writeInt (hubIndex);
+        stream->writeInt ((int) hub.first);
+        stream->writeInt ((int) hub.second);
+    }
+
+    bytesWritten = (uint64_t) stream->getPosition();
+
+    return true;
+}
+
+void FrameCapture::copyIntoBuffer (uint64_t position, const void* data, size_t numBytes)
+{
+    const size_t offset = position % buffer.size();
+    const size_t firstPart = std::min (numBytes, buffer.size() - offset);
+
+    std::memcpy (buffer.data() + offset, data, firstPart);
+
+    if (firstPart < numBytes)
+        std::memcpy (buffer.data(), (const uint8_t*) data + firstPart, numBytes - firstPart);
+}
+
+void FrameCapture::copyFromBuffer (uint64_t position, void* data, size_t numBytes) const
+{
+    const size_t offset = position % buffer.size();
+    const size_t firstPart = std::min (numBytes, buffer.size() - offset);
+
+    std::memcpy (data, buffer.data() + offset, firstPart);
+
+    if (firstPart < numBytes)
+        std::memcpy ((uint8_t*) data + firstPart, buffer.data(), numBytes - firstPart);
+}
+
+void FrameCapture::captureFrames (oni_frame_t* const* frames, int numFrames)
+{
+    if (failed.load (std::memory_order_relaxed))
+    {
+        droppedFrames.store (droppedFrames.load (std::memory_order_relaxed) + numFrames, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t position = writePosition.load (std::memory_order_relaxed);
+    const uint64_t freeSpace = buffer.size() - (position - readPosition.load (std::memory_order_acquire));
+
+    uint64_t used = 0;
+    uint64_t dropped = 0;
+
+    for (int i = 0; i < numFrames; i++)
+    {
+        const oni_frame_t* frame = frames[i];
+        const size_t recordSize = Onix1::FrameHeaderSize + frame->data_sz;
+
+        if (used + recordSize > freeSpace)
+        {
+            dropped++;
+            continue;
+        }
+
+        // NB: Same layout as the frame header that precedes each frame in a block read
+        uint8_t header[Onix1::FrameHeaderSize];
+        std::memcpy (header, &frame->time, sizeof (oni_fifo_time_t));
+        std::memcpy (header + sizeof (oni_fifo_time_t), &frame->dev_idx, sizeof (oni_fifo_dat_t));
+        std::memcpy (header + sizeof (oni_fifo_time_t) + sizeof (oni_fifo_dat_t), &frame->data_sz, sizeof (oni_fifo_dat_t));
+
+        copyIntoBuffer (position + used, header, sizeof (header));
+        copyIntoBuffer (position + used + sizeof (header), frame->data, frame->data_sz);
+
+        used += recordSize;
+    }
+
+    writePosition.store (position + used, std::memory_order_release);
+
+    capturedFrames.store (capturedFrames.load (std::memory_order_relaxed) + (numFrames - dropped), std::memory_order_relaxed);
+
+    if (dropped > 0)
+        droppedFrames.store (droppedFrames.load (std::memory_order_relaxed) + dropped, std::memory_order_relaxed);
+}
+
+void FrameCapture::discardRecords (uint64_t start, uint64_t end, uint64_t firstLostByte)
+{
+    uint64_t numLost = 0;
+
+    // NB: The ring buffer only holds whole records, so they can be walked from their headers
+    for (uint64_t position = start; position < end;)
+    {
+        oni_fifo_dat_t dataSize;
+        copyFromBuffer (position + sizeof (oni_fifo_time_t) + sizeof (oni_fifo_dat_t), &dataSize, sizeof (dataSize));
+
+        position += Onix1::FrameHeaderSize + dataSize;
+
+        if (position > firstLostByte)
+            numLost++;
+    }
+
+    lostFrames.store (lostFrames.load (std::memory_order_relaxed) + numLost, std::memory_order_relaxed);
+    readPosition.store (end, std::memory_order_release);
+}
+
+size_t FrameCapture::drainBuffer()
+{
+    const uint64_t start = readPosition.load (std::memory_order_relaxed);
+    const uint64_t end = writePosition.load (std::memory_order_acquire);
+
+    if (failed.load (std::memory_order_relaxed))
+    {
+        discardRecords (start, end, start);
+        return (size_t) (end - start);
+    }
+
+    uint64_t position = start;
+
+    while (position < end)
+    {
+        const size_t offset = position % buffer.size();
+        const size_t numBytes = (size_t) std::min<uint64_t> (end - position, buffer.size() - offset);
+
+        if (! stream->write (buffer.data() + offset, numBytes))
+        {
+            LOGE ("Unable to write to the capture file ", file.getFullPathName(), ": ", stream->getStatus().getErrorMessage(), ". Capturing has stopped.");
+
+            // NB: Nothing more is written after a failed write, so that a partial record can only be at the end of
+            //     the file, where it is read as the end of the capture. Frames still in the ring buffer are discarded
+            //     so that the reader keeps making progress.
+            failed.store (true, std::memory_order_relaxed);
+            discardRecords (start, end, position);
+            break;
+        }
+
+        position += numBytes;
+    }
+
+    readPosition.store (end, std::memory_order_release);
+    bytesWritten.store (bytesWritten.load (std::memory_order_relaxed) + (position - start), std::memory_order_relaxed);
+
+    return (size_t) (end - start);
+}
+
+void FrameCapture::run()
+{
+    LOGC (ThreadPolicy::getThreadName (AcquisitionThread::FrameCapture), " thread policy: ", threadPolicy.applyToCurrentThread());
+
+    while (! threadShouldExit())
+    {
+        if (drainBuffer() == 0)
+            wait (WriterPollMilliseconds);
+    }
+}
+
+void FrameCapture::close()
+{
+    if (stream == nullptr)
+        return;
+
+    stopThread (-1);
+
+    drainBuffer();
+
+    if (stream->setPosition (droppedFramesPosition))
+        stream->writeInt64 ((int64) getDroppedFrameCount());
+
+    stream->flush();
+    stream.reset();
+}
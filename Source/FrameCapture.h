@@ -0,0 +1,155 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <DataThreadHeaders.h>
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include "Onix1.h"
+#include "ThreadPolicy.h"
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Copies every frame read from the hardware into a binary capture file, using a background writer thread.
+
+    Frames are copied into a preallocated ring buffer by the frame reader, and written to disk by this thread,
+    so that a slow disk never blocks acquisition. If the ring buffer is full, the frames are dropped from the
+    capture (but not from acquisition) and counted. If a write to the file fails, capturing stops: no further
+    records are written, so the file ends with the last record written before the error, and every frame that
+    did not reach the file is counted as dropped.
+
+    The file is little-endian, and starts with a header describing the session:
+
+        char[8]     magic, "ONIXRAW\0"
+        uint32      format version
+        uint32      acquisition clock frequency in Hz
+        uint64      number of frames dropped from the capture, written when the capture is closed
+        uint32      number of devices, followed by one entry per device:
+                        uint32 idx, uint32 id, uint32 version, uint32 read_size, uint32 write_size
+        uint32      number of hubs, followed by one entry per hub:
+                        uint32 hub index, uint32 hub ID, uint32 firmware version
+
+    followed by one record per frame, in the order they were read:
+
+        uint64      time
+        uint32      dev_idx
+        uint32      data_sz
+        uint8[]     data, data_sz bytes
+
+*/
+class FrameCapture : public Thread
+{
+public:
+    /** Hub index mapped to the hub ID and firmware version */
+    using HubInfo = std::map<int, std::pair<uint32_t, uint32_t>>;
+
+    FrameCapture (File file, size_t bufferSize = DefaultBufferSize);
+
+    ~FrameCapture();
+
+    /** Creates the file and writes the header. Returns false if the file could not be created. */
+    bool open (const device_map_t& deviceTable, const HubInfo& hubs, uint32_t acquisitionClockHz);
+
+    /** Copies the given frames into the ring buffer. Never blocks; frames that do not fit are dropped.
+        Must only be called from one thread at a time. */
+    void captureFrames (oni_frame_t* const* frames, int numFrames);
+
+    /** Stops the writer thread once the ring buffer has been written to disk, and closes the file. Must be
+        called after the thread calling captureFrames has stopped. */
+    void close();
+
+    void run() override;
+
+    /** Sets the affinity and scheduling policy applied when the thread starts */
+    void setThreadPolicy (ThreadPolicy policy) { threadPolicy = policy; }
+
+    File getFile() const { return file; }
+
+    uint64_t getCapturedFrameCount() const { return capturedFrames.load (std::memory_order_relaxed) - lostFrames.load (std::memory_order_relaxed); }
+
+    uint64_t getDroppedFrameCount() const { return droppedFrames.load (std::memory_order_relaxed) + lostFrames.load (std::memory_order_relaxed); }
+
+    /** Returns true if capturing stopped because the file could not be written */
+    bool hasFailed() const { return failed.load (std::memory_order_relaxed); }
+
+    uint64_t getBytesWritten() const { return bytesWritten.load (std::memory_order_relaxed); }
+
+    /** Large enough to absorb half a second of disk stalls with two NP2e headstages at full rate */
+    static constexpr size_t DefaultBufferSize = 128 * 1024 * 1024;
+
+    static constexpr char Magic[8] = { 'O', 'N', 'I', 'X', 'R', 'A', 'W', '\0' };
+
+    static constexpr uint32_t FormatVersion = 1;
+
+    /** File extension used for capture files */
+    static constexpr const char* FileExtension = ".onixraw";
+
+private:
+    const File file;
+
+    std::unique_ptr<FileOutputStream> stream;
+
+    std::vector<uint8_t> buffer;
+
+    // NB: Total bytes ever written to and read from the ring buffer; only the reader thread advances
+    //     writePosition, and only the writer thread advances readPosition
+    std::atomic<uint64_t> writePosition = 0;
+    std::atomic<uint64_t> readPosition = 0;
+
+    // NB: capturedFrames and droppedFrames are only written by the reader thread, and lostFrames, which counts
+    //     frames that were copied into the ring buffer but never reached the file, only by the writer thread
+    std::atomic<uint64_t> capturedFrames = 0;
+    std::atomic<uint64_t> droppedFrames = 0;
+    std::atomic<uint64_t> lostFrames = 0;
+    std::atomic<uint64_t> bytesWritten = 0;
+
+    std::atomic<bool> failed = false;
+
+    int64 droppedFramesPosition = 0;
+
+    ThreadPolicy threadPolicy;
+
+    void copyIntoBuffer (uint64_t position, const void* data, size_t numBytes);
+
+    void copyFromBuffer (uint64_t position, void* data, size_t numBytes) const;
+
+    /** Discards the records from start to end in the ring buffer, counting those that end after firstLostByte as lost */
+    void discardRecords (uint64_t start, uint64_t end, uint64_t firstLostByte);
+
+    /** Writes everything currently in the ring buffer to the file. Returns the number of bytes written. */
+    size_t drainBuffer();
+
+    /** Time the writer thread sleeps when the ring buffer is empty */
+    static constexpr int WriterPollMilliseconds = 5;
+
+    /** Size of the buffer used by the file stream */
+    static constexpr size_t StreamBufferSize = 4 * 1024 * 1024;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameCapture);
+};
+} // namespace OnixSourcePlugin
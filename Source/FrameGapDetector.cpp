@@ -0,0 +1,42 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "FrameGapDetector.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace OnixSourcePlugin;
+
+void FrameGapDetector::reset (double periodTicks_)
+{
+    periodTicks = periodTicks_;
+    gapThresholdTicks = periodTicks > 0.0 ? (uint64_t) (periodTicks * 1.5) : std::numeric_limits<uint64_t>::max();
+    lastClock = NoClock;
+}
+
+uint32_t FrameGapDetector::getMissingFrames (uint64_t elapsedTicks) const
+{
+    const double periods = std::round ((double) elapsedTicks / periodTicks);
+
+    return (uint32_t) std::clamp (periods - 1.0, 1.0, (double) std::numeric_limits<uint32_t>::max());
+}
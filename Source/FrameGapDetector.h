@@ -0,0 +1,71 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Detects frames missing from a stream by checking that the clock of each frame is one frame period after the
+    clock of the previous frame.
+
+    Frames can go missing before they reach the host, or be dropped by the host when a frame queue overflows.
+    Either way the decoders would otherwise number the samples that follow as if they were continuous. A gap is
+    reported when the clock advances by more than one and a half periods, which tolerates jitter in the period
+    while still catching a single missing frame. Each stream that has its own clock needs its own detector, and
+    a detector is only used from the thread that decodes its stream.
+
+*/
+class FrameGapDetector
+{
+public:
+    /** Sets the number of clock ticks expected between consecutive frames, and forgets the previous frame. A
+        period of zero disables gap detection. */
+    void reset (double periodTicks);
+
+    /** Returns the number of frames missing between the previous frame and this one, judged by their clocks */
+    uint32_t checkFrame (uint64_t clock)
+    {
+        const uint64_t previous = lastClock;
+        lastClock = clock;
+
+        // NB: A clock that did not advance is not a gap; it is left to the timestamps to show
+        if (previous == NoClock || clock <= previous || clock - previous <= gapThresholdTicks)
+            return 0;
+
+        return getMissingFrames (clock - previous);
+    }
+
+private:
+    static constexpr uint64_t NoClock = std::numeric_limits<uint64_t>::max();
+
+    double periodTicks = 0.0;
+    uint64_t gapThresholdTicks = std::numeric_limits<uint64_t>::max();
+    uint64_t lastClock = NoClock;
+
+    uint32_t getMissingFrames (uint64_t elapsedTicks) const;
+};
+} // namespace OnixSourcePlugin
@@ -21,47 +21,173 @@
 */
 
 #include "FrameReader.h"
+#include "AsyncLogger.h"
+#include "TraceRecorder.h"
 
 using namespace OnixSourcePlugin;
 
-FrameReader::FrameReader (OnixDeviceVector sources_, std::shared_ptr<Onix1> ctx_)
-    : Thread ("FrameReader")
+FrameReader::FrameReader (OnixDeviceVector sources_, FrameDispatchTable dispatchTable_, std::shared_ptr<Onix1> ctx_, bool decodeInReaderThread_)
+    : Thread ("FrameReader"), decodeInReaderThread (decodeInReaderThread_)
 {
     sources = sources_;
+    dispatchTable = dispatchTable_;
     context = ctx_;
 }
 
+FrameDispatchTable FrameReader::createDispatchTable (const OnixDeviceVector& sources)
+{
+    oni_dev_idx_t maxIndex = 0;
+
+    for (const auto& source : sources)
+    {
+        maxIndex = std::max (maxIndex, source->getDeviceIdx (true));
+    }
+
+    FrameDispatchTable table (sources.empty() ? 0 : (size_t) maxIndex + 1, nullptr);
+
+    for (const auto& source : sources)
+    {
+        auto index = source->getDeviceIdx (true);
+
+        if (table[index] != nullptr)
+        {
+            LOGE ("Device index ", index, " is claimed by both ", table[index]->getName(), " and ", source->getName(), ". Frames will only be sent to ", table[index]->getName(), ".");
+            continue;
+        }
+
+        table[index] = source.get();
+    }
+
+    return table;
+}
+
+uint64_t FrameReader::getUnknownFrameCount() const
+{
+    return unknownFrameCount.load (std::memory_order_relaxed);
+}
+
+void FrameReader::registerMetrics (MetricsRegistry& registry)
+{
+    registry.addCounter ("reader.frames_read", [this]
+                         { return getFramesRead(); });
+    registry.addCounter ("reader.reads", [this]
+                         { return readCount.load (std::memory_order_relaxed); });
+    registry.addCounter ("reader.unknown_frames", [this]
+                         { return getUnknownFrameCount(); });
+}
+
+oni_dev_idx_t FrameReader::getLastUnknownIndex() const
+{
+    return lastUnknownIndex.load (std::memory_order_relaxed);
+}
+
+bool FrameReader::waitForFrames (std::chrono::microseconds timeout)
+{
+    if (! framesAvailable.wait (timeout.count()))
+        return false;
+
+    // NB: All frames dispatched so far are about to be processed, so collapse any signals that accumulated
+    //     while the consumer was busy instead of waking up once per batch
+    while (framesAvailable.tryWait())
+    {
+    }
+
+    return true;
+}
+
+void FrameReader::wakeWaitingThread()
+{
+    framesAvailable.signal();
+}
+
 void FrameReader::run()
 {
+    const size_t tableSize = dispatchTable.size();
+
+    LOGC (ThreadPolicy::getThreadName (AcquisitionThread::FrameReader), " thread policy: ", threadPolicy.applyToCurrentThread());
+
+    if (context->resetBlockReadState() != ONI_ESUCCESS)
+    {
+        LOGE ("Unable to read the block read size. Frames will be read one at a time.");
+    }
+
+    std::array<oni_frame_t*, MaxFramesPerRead> frames;
+
     while (! threadShouldExit())
     {
-        oni_frame_t* frame = context->readFrame();
+        auto readStart = std::chrono::steady_clock::now();
+
+        int numFrames = context->readFrames (frames.data(), frames.size(), ReadTimeout);
+
+        const int64_t readTime = LatencyProbe::now();
 
-        if (frame == nullptr)
+        if (numFrames <= 0)
         {
+            // NB: Reads fail once the hardware is stopped at the end of acquisition, which is not an error
             if (threadShouldExit())
                 return;
 
-            CoreServices::sendStatusMessage ("Unable to read data frames. Stopping acquisition...");
-            CoreServices::setAcquisitionStatus (false);
+            AsyncLogger::log (AsyncLogger::Level::Error, "Unable to read a frame", nullptr, oni_error_str (numFrames));
+
+            auto statusReporter = Onix1::getStatusReporter();
+            statusReporter->showStatus ("Unable to read data frames. Stopping acquisition...");
+            statusReporter->requestStopAcquisition();
             return;
         }
 
-        bool destroyFrame = true;
+        framesRead.store (framesRead.load (std::memory_order_relaxed) + numFrames, std::memory_order_relaxed);
+        readCount.store (readCount.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 
-        for (const auto& source : sources)
+        if (blockReadSizeTuner != nullptr)
         {
-            if (source->compareIndex (frame->dev_idx))
-            {
-                source->addFrame (frame);
-                destroyFrame = false;
-                break;
-            }
+            size_t numBytes = 0;
+
+            for (int i = 0; i < numFrames; i++)
+                numBytes += Onix1::FrameHeaderSize + frames[i]->data_sz;
+
+            blockReadSizeTuner->recordRead (std::chrono::steady_clock::now() - readStart, numBytes);
         }
 
-        if (destroyFrame)
+        // NB: Frames must be captured before they are dispatched, since devices may destroy them immediately
+        if (frameCapture != nullptr)
+            frameCapture->captureFrames (frames.data(), numFrames);
+
+        TraceScope trace ("FrameReader::dispatch", "reader", "frames", numFrames);
+
+        auto getDevice = [&] (const oni_frame_t* frame)
+        { return frame->dev_idx < tableSize ? dispatchTable[frame->dev_idx] : nullptr; };
+
+        int runStart = 0;
+
+        while (runStart < numFrames)
         {
-            oni_destroy_frame (frame);
+            OnixDevice* device = getDevice (frames[runStart]);
+
+            if (device == nullptr)
+            {
+                unknownFrameCount.fetch_add (1, std::memory_order_relaxed);
+                lastUnknownIndex.store (frames[runStart]->dev_idx, std::memory_order_relaxed);
+                context->destroyFrame (frames[runStart++]);
+                continue;
+            }
+
+            int runEnd = runStart + 1;
+
+            while (runEnd < numFrames && getDevice (frames[runEnd]) == device)
+                runEnd++;
+
+            // NB: Each run of consecutive frames from one device is queued with a single update of the ring
+            device->addFrames (frames.data() + runStart, runEnd - runStart, readTime);
+
+            // NB: In low-latency mode, each run is decoded as soon as it is queued, so it reaches its DataBuffer
+            //     without waiting for the rest of the batch
+            if (decodeInReaderThread)
+                device->processQueuedFrames();
+
+            runStart = runEnd;
         }
+
+        if (! decodeInReaderThread)
+            framesAvailable.signal();
     }
 }
@@ -24,22 +24,94 @@
 
 #include <DataThreadHeaders.h>
 
+#include "BlockReadSizeTuner.h"
+#include "FrameCapture.h"
 #include "OnixDevice.h"
+#include "Queue/atomicops.h"
+#include "ThreadPolicy.h"
 #include "oni.h"
 
 namespace OnixSourcePlugin
 {
+/** Dense lookup table that maps the device index of an incoming frame directly to the device that consumes it */
+using FrameDispatchTable = std::vector<OnixDevice*>;
+
 class FrameReader : public Thread
 {
 public:
-    FrameReader (OnixDeviceVector sources_, std::shared_ptr<Onix1>);
+    /** Constructor. If decodeInReaderThread is true, each device decodes its frames on this thread as soon as a
+        run of consecutive frames for it has been read, instead of waiting for the DataThread to call processFrames.
+        The frames still pass through the frame queue of the device, because every device decodes by dequeueing
+        from it; with one thread on both ends this costs a pair of uncontended stores per frame, and keeps a single
+        decode path for all modes. */
+    FrameReader (OnixDeviceVector sources_, FrameDispatchTable dispatchTable_, std::shared_ptr<Onix1>, bool decodeInReaderThread = false);
 
     void run() override;
 
+    /** Creates a dispatch table indexed by the device index found in each frame. Passthrough devices are
+        keyed by their passthrough index, since that is the index their frames arrive with. */
+    static FrameDispatchTable createDispatchTable (const OnixDeviceVector& sources);
+
+    /** Returns the number of frames that were destroyed because no device was registered for their index */
+    uint64_t getUnknownFrameCount() const;
+
+    /** Returns the device index of the most recent frame that had no registered device */
+    oni_dev_idx_t getLastUnknownIndex() const;
+
+    /** Returns the number of frames read from the context, including unknown frames */
+    uint64_t getFramesRead() const { return framesRead.load (std::memory_order_relaxed); }
+
+    /** Adds the frame counts of this reader to the registry. The reader must outlive the registry. */
+    void registerMetrics (MetricsRegistry& registry);
+
+    /** Blocks until frames have been added to a device since the last call, or until the timeout elapses.
+        Returns true if frames are available. */
+    bool waitForFrames (std::chrono::microseconds timeout);
+
+    /** Wakes up any thread blocked in waitForFrames, for instance when acquisition is stopping */
+    void wakeWaitingThread();
+
+    /** Returns true if devices decode their frames on this thread, as fixed when the reader was constructed */
+    bool isDecodingInReaderThread() const { return decodeInReaderThread; }
+
+    /** Sets the affinity and scheduling policy applied when the thread starts */
+    void setThreadPolicy (ThreadPolicy policy) { threadPolicy = policy; }
+
+    /** Sets a tuner that is given the duration and size of each batch read. Must be called before the thread starts. */
+    void setBlockReadSizeTuner (BlockReadSizeTuner* tuner) { blockReadSizeTuner = tuner; }
+
+    /** Sets a capture that is given a copy of every frame read. Must be called before the thread starts. */
+    void setFrameCapture (FrameCapture* capture) { frameCapture = capture; }
+
+    /** Maximum number of frames read from the context in a single batch */
+    static constexpr size_t MaxFramesPerRead = 256;
+
+    /** Maximum time spent collecting a batch once the first frame of the batch has been read */
+    static constexpr std::chrono::microseconds ReadTimeout { 1000 };
+
 private:
     OnixDeviceVector sources;
+    FrameDispatchTable dispatchTable;
     std::shared_ptr<Onix1> context;
 
+    const bool decodeInReaderThread;
+
+    ThreadPolicy threadPolicy;
+
+    BlockReadSizeTuner* blockReadSizeTuner = nullptr;
+
+    FrameCapture* frameCapture = nullptr;
+
+    std::atomic<uint64_t> unknownFrameCount = 0;
+    std::atomic<oni_dev_idx_t> lastUnknownIndex = 0;
+
+    // NB: Only written by the reader thread
+    std::atomic<uint64_t> framesRead = 0;
+    std::atomic<uint64_t> readCount = 0;
+
+    /** Signalled once for every batch of frames dispatched to devices */
+    moodycamel::spsc_sema::LightweightSemaphore framesAvailable;
+
     JUCE_LEAK_DETECTOR (FrameReader);
 };
 } // namespace OnixSourcePlugin
@@ -0,0 +1,149 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "FrameRing.h"
+
+using namespace OnixSourcePlugin;
+
+FrameRing::FrameRing (size_t minimumCapacity)
+{
+    allocate (minimumCapacity);
+}
+
+void FrameRing::allocate (size_t minimumCapacity)
+{
+    size_t newCapacity = 1;
+
+    while (newCapacity < minimumCapacity)
+        newCapacity <<= 1;
+
+    buffer.assign (newCapacity, nullptr);
+    readTimes.assign (newCapacity, 0);
+    capacity = newCapacity;
+    mask = newCapacity - 1;
+
+    readPosition.store (0);
+    writePosition.store (0);
+
+    resetCounters();
+}
+
+size_t FrameRing::enqueueBulk (oni_frame_t* const* frames, size_t count, int64_t readTime)
+{
+    const size_t write = writePosition.load (std::memory_order_relaxed);
+    const size_t size = write - readPosition.load (std::memory_order_acquire);
+    const size_t numToWrite = std::min (count, capacity - size);
+
+    for (size_t i = 0; i < numToWrite; i++)
+    {
+        buffer[(write + i) & mask] = frames[i];
+        readTimes[(write + i) & mask] = readTime;
+    }
+
+    writePosition.store (write + numToWrite, std::memory_order_release);
+
+    if (numToWrite < count)
+        overflowCount.fetch_add (count - numToWrite, std::memory_order_relaxed);
+
+    updateHighWaterMark (size + numToWrite);
+
+    return numToWrite;
+}
+
+bool FrameRing::tryDequeue (oni_frame_t*& frame)
+{
+    int64_t readTime;
+
+    return tryDequeue (frame, readTime);
+}
+
+bool FrameRing::tryDequeue (oni_frame_t*& frame, int64_t& readTime)
+{
+    const size_t read = readPosition.load (std::memory_order_relaxed);
+
+    if (read == writePosition.load (std::memory_order_acquire))
+        return false;
+
+    frame = buffer[read & mask];
+    readTime = readTimes[read & mask];
+    readPosition.store (read + 1, std::memory_order_release);
+
+    return true;
+}
+
+size_t FrameRing::dequeueBulk (oni_frame_t** frames, size_t maxCount, int64_t& firstReadTime)
+{
+    const size_t read = readPosition.load (std::memory_order_relaxed);
+    const size_t numToRead = std::min (maxCount, writePosition.load (std::memory_order_acquire) - read);
+
+    if (numToRead == 0)
+        return 0;
+
+    for (size_t i = 0; i < numToRead; i++)
+        frames[i] = buffer[(read + i) & mask];
+
+    firstReadTime = readTimes[read & mask];
+    readPosition.store (read + numToRead, std::memory_order_release);
+
+    return numToRead;
+}
+
+oni_frame_t* FrameRing::peek() const
+{
+    const size_t read = readPosition.load (std::memory_order_relaxed);
+
+    if (read == writePosition.load (std::memory_order_acquire))
+        return nullptr;
+
+    return buffer[read & mask];
+}
+
+size_t FrameRing::sizeApprox() const
+{
+    // NB: Load the read position first, since it can never pass the write position
+    const size_t read = readPosition.load (std::memory_order_acquire);
+
+    return writePosition.load (std::memory_order_acquire) - read;
+}
+
+size_t FrameRing::getHighWaterMark() const
+{
+    return highWaterMark.load (std::memory_order_relaxed);
+}
+
+uint64_t FrameRing::getOverflowCount() const
+{
+    return overflowCount.load (std::memory_order_relaxed);
+}
+
+void FrameRing::resetCounters()
+{
+    highWaterMark.store (0, std::memory_order_relaxed);
+    overflowCount.store (0, std::memory_order_relaxed);
+}
+
+void FrameRing::updateHighWaterMark (size_t size)
+{
+    // NB: Only the producer writes the high-water mark, so a plain load and store is sufficient
+    if (size > highWaterMark.load (std::memory_order_relaxed))
+        highWaterMark.store (size, std::memory_order_relaxed);
+}
@@ -0,0 +1,105 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <oni.h>
+#include <vector>
+
+#include <DataThreadHeaders.h>
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Fixed-capacity, single-producer single-consumer ring of frame pointers.
+
+    Storage is allocated up front by allocate(), so enqueueing on the FrameReader thread never allocates.
+    When the ring is full, the frames that do not fit are rejected and counted as overflows; it is up
+    to the caller to destroy them.
+
+*/
+class FrameRing
+{
+public:
+    /** Constructor. Capacity is rounded up to the next power of two. */
+    FrameRing (size_t minimumCapacity = DefaultCapacity);
+
+    /** Reallocates the ring so it can hold at least the given number of frames, and resets all counters.
+        Not thread-safe; only call this while neither the producer nor the consumer is running. Any frames
+        still in the ring are discarded without being destroyed. */
+    void allocate (size_t minimumCapacity);
+
+    /** Adds up to count frames in order, all read at readTime, and returns how many were added. Frames that
+        did not fit are counted as overflows. */
+    size_t enqueueBulk (oni_frame_t* const* frames, size_t count, int64_t readTime = 0);
+
+    /** Removes a single frame. Returns false if the ring is empty. */
+    bool tryDequeue (oni_frame_t*& frame);
+
+    /** Removes a single frame and the host time at which it was read. Returns false if the ring is empty. */
+    bool tryDequeue (oni_frame_t*& frame, int64_t& readTime);
+
+    /** Removes up to maxCount frames in order with a single update of the ring, and returns how many were removed.
+        If any were removed, firstReadTime is set to the host time at which the first of them was read. */
+    size_t dequeueBulk (oni_frame_t** frames, size_t maxCount, int64_t& firstReadTime);
+
+    /** Returns the frame at the front of the ring without removing it, or nullptr if the ring is empty. Consumer only. */
+    oni_frame_t* peek() const;
+
+    /** Returns the number of frames in the ring; exact only when called from the producer or the consumer. */
+    size_t sizeApprox() const;
+
+    size_t getCapacity() const { return capacity; }
+
+    /** Returns the largest number of frames that were held in the ring at once since the last reset */
+    size_t getHighWaterMark() const;
+
+    /** Returns the number of frames that could not be added because the ring was full */
+    uint64_t getOverflowCount() const;
+
+    void resetCounters();
+
+    static constexpr size_t DefaultCapacity = 32;
+
+private:
+    std::vector<oni_frame_t*> buffer;
+    std::vector<int64_t> readTimes;
+    size_t capacity = 0;
+    size_t mask = 0;
+
+    // NB: Positions increase monotonically and are wrapped with the mask. Each one is written by a single
+    //     thread, and kept on its own cache line so the producer and consumer do not contend.
+    alignas (64) std::atomic<size_t> readPosition = 0;
+    alignas (64) std::atomic<size_t> writePosition = 0;
+
+    alignas (64) std::atomic<size_t> highWaterMark = 0;
+    std::atomic<uint64_t> overflowCount = 0;
+
+    void updateHighWaterMark (size_t size);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FrameRing);
+};
+} // namespace OnixSourcePlugin
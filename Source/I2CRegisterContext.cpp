@@ -111,4 +111,6 @@ int I2CRegisterContext::set933I2cRate (double rate)
     rc = WriteByte ((uint32_t) DS90UB9x::DS90UB933SerializerI2CRegister::SclLow, sclTimes);
     if (rc != ONI_ESUCCESS)
         return rc;
+
+    return ONI_ESUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,203 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LatencyProbe.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+using namespace OnixSourcePlugin;
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+int LatencyHistogram::getBucketIndex (int64_t nanoseconds)
+{
+    if (nanoseconds < SubBucketCount)
+        return (int) std::max<int64_t> (nanoseconds, 0);
+
+    if (nanoseconds >= (int64_t (1) << MaxValueBits))
+        return NumBuckets - 1;
+
+    int highestBit = 63;
+    while (! (nanoseconds & (int64_t (1) << highestBit)))
+        highestBit--;
+
+    // NB: The top SubBucketBits bits select a linear sub-bucket within the power of two containing the value
+    const int shift = highestBit - (SubBucketBits - 1);
+    const int subBucket = (int) (nanoseconds >> shift) - SubBucketHalfCount;
+
+    return SubBucketCount + (shift - 1) * SubBucketHalfCount + subBucket;
+}
+
+int64_t LatencyHistogram::getBucketUpperBound (int index)
+{
+    if (index < SubBucketCount)
+        return index;
+
+    const int shift = (index - SubBucketCount) / SubBucketHalfCount + 1;
+    const int64_t subBucket = (index - SubBucketCount) % SubBucketHalfCount + SubBucketHalfCount;
+
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record (int64_t nanoseconds)
+{
+    nanoseconds = std::max<int64_t> (nanoseconds, 0);
+
+    counts[getBucketIndex (nanoseconds)].fetch_add (1, std::memory_order_relaxed);
+
+    sum.fetch_add (nanoseconds, std::memory_order_relaxed);
+
+    // NB: There is a single writer, so plain loads and stores are sufficient for the extrema
+    if (nanoseconds < min.load (std::memory_order_relaxed))
+        min.store (nanoseconds, std::memory_order_relaxed);
+
+    if (nanoseconds > max.load (std::memory_order_relaxed))
+        max.store (nanoseconds, std::memory_order_relaxed);
+
+    count.fetch_add (1, std::memory_order_release);
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& bucket : counts)
+        bucket.store (0, std::memory_order_relaxed);
+
+    count.store (0, std::memory_order_relaxed);
+    sum.store (0, std::memory_order_relaxed);
+    min.store (std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+    max.store (0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+    return count.load (std::memory_order_acquire);
+}
+
+int64_t LatencyHistogram::getMin() const
+{
+    return getCount() == 0 ? 0 : min.load (std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::getMax() const
+{
+    return max.load (std::memory_order_relaxed);
+}
+
+double LatencyHistogram::getMean() const
+{
+    const uint64_t n = getCount();
+
+    return n == 0 ? 0.0 : (double) sum.load (std::memory_order_relaxed) / n;
+}
+
+int64_t LatencyHistogram::getPercentile (double percentile) const
+{
+    const uint64_t n = getCount();
+
+    if (n == 0)
+        return 0;
+
+    const uint64_t target = std::max<uint64_t> (1, (uint64_t) std::ceil (std::clamp (percentile, 0.0, 100.0) / 100.0 * n));
+
+    uint64_t cumulative = 0;
+
+    for (int i = 0; i < NumBuckets; i++)
+    {
+        cumulative += counts[i].load (std::memory_order_relaxed);
+
+        if (cumulative >= target)
+            return std::min (getBucketUpperBound (i), getMax());
+    }
+
+    return getMax();
+}
+
+std::string LatencyHistogram::getSummary() const
+{
+    std::ostringstream ss;
+    ss.precision (1);
+    ss << std::fixed;
+
+    ss << "n=" << getCount()
+       << " mean=" << getMean() * 1e-3
+       << " p50=" << getPercentile (50.0) * 1e-3
+       << " p99=" << getPercentile (99.0) * 1e-3
+       << " p99.9=" << getPercentile (99.9) * 1e-3
+       << " max=" << getMax() * 1e-3 << " us";
+
+    return ss.str();
+}
+
+int64_t LatencyProbe::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LatencyProbe::recordDequeue (int64_t readTime)
+{
+    lastReadTime = readTime;
+    lastDequeueTime = now();
+
+    histograms[(size_t) Stage::ReadToDequeue].record (lastDequeueTime - readTime);
+}
+
+void LatencyProbe::recordBufferWrite()
+{
+    if (lastReadTime == 0)
+        return;
+
+    const int64_t bufferTime = now();
+
+    histograms[(size_t) Stage::DequeueToBuffer].record (bufferTime - lastDequeueTime);
+    histograms[(size_t) Stage::ReadToBuffer].record (bufferTime - lastReadTime);
+}
+
+void LatencyProbe::reset()
+{
+    for (auto& histogram : histograms)
+        histogram.reset();
+
+    lastReadTime = 0;
+    lastDequeueTime = 0;
+}
+
+std::string LatencyProbe::getStageName (Stage stage)
+{
+    switch (stage)
+    {
+        case Stage::ReadToDequeue:
+            return "read to dequeue";
+        case Stage::DequeueToBuffer:
+            return "dequeue to buffer";
+        case Stage::ReadToBuffer:
+            return "read to buffer";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,133 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <DataThreadHeaders.h>
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Histogram of latencies in nanoseconds, with logarithmic buckets that are each subdivided linearly,
+    in the style of an HDR histogram. Every value is recorded with a relative error below 1 / SubBucketHalfCount.
+
+    Values are recorded by a single thread, and can be read from any thread while recording.
+
+*/
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    /** Adds a latency in nanoseconds. Negative values are recorded as zero. */
+    void record (int64_t nanoseconds);
+
+    /** Clears all recorded values. Not thread-safe with respect to record(). */
+    void reset();
+
+    uint64_t getCount() const;
+
+    int64_t getMin() const;
+    int64_t getMax() const;
+    double getMean() const;
+
+    /** Returns the value below which the given percentage (0-100) of recorded values fall, in nanoseconds */
+    int64_t getPercentile (double percentile) const;
+
+    /** Returns a single-line summary with the count, mean, median, tail percentiles and maximum */
+    std::string getSummary() const;
+
+    static constexpr int SubBucketBits = 5;
+    static constexpr int SubBucketCount = 1 << SubBucketBits;
+    static constexpr int SubBucketHalfCount = SubBucketCount / 2;
+
+    /** Values at or above 2^MaxValueBits nanoseconds (about 18 minutes) are recorded in the last bucket */
+    static constexpr int MaxValueBits = 40;
+
+    static constexpr int NumBuckets = SubBucketCount + (MaxValueBits - SubBucketBits) * SubBucketHalfCount;
+
+    static int getBucketIndex (int64_t nanoseconds);
+
+    /** Returns the largest value that is recorded in the given bucket */
+    static int64_t getBucketUpperBound (int index);
+
+private:
+    std::array<std::atomic<uint64_t>, NumBuckets> counts;
+
+    std::atomic<uint64_t> count = 0;
+    std::atomic<int64_t> sum = 0;
+    std::atomic<int64_t> min;
+    std::atomic<int64_t> max = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LatencyHistogram);
+};
+
+/**
+
+    Measures how long frames from a single device take to move through the acquisition pipeline, using the
+    host monotonic clock. Each frame is stamped when it is returned by the driver, then its latency is
+    recorded when it is dequeued for decoding, and again when the decoded samples are added to a DataBuffer.
+
+    Dequeue and buffer times are recorded on the thread that decodes the device.
+
+*/
+class LatencyProbe
+{
+public:
+    enum class Stage : uint32_t
+    {
+        ReadToDequeue = 0,
+        DequeueToBuffer,
+        ReadToBuffer,
+        Count
+    };
+
+    /** Returns the current host monotonic time in nanoseconds */
+    static int64_t now();
+
+    /** Records that a frame read at readTime has been dequeued */
+    void recordDequeue (int64_t readTime);
+
+    /** Records that the samples from the most recently dequeued frame have been added to a DataBuffer */
+    void recordBufferWrite();
+
+    const LatencyHistogram& getHistogram (Stage stage) const { return histograms[(size_t) stage]; }
+
+    void reset();
+
+    static std::string getStageName (Stage stage);
+
+private:
+    std::array<LatencyHistogram, (size_t) Stage::Count> histograms;
+
+    int64_t lastReadTime = 0;
+    int64_t lastDequeueTime = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LatencyProbe);
+};
+} // namespace OnixSourcePlugin
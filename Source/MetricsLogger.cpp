@@ -0,0 +1,141 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "MetricsLogger.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace OnixSourcePlugin;
+
+MetricsLogger::MetricsLogger (File file_, const MetricsRegistry& registry_, std::chrono::milliseconds interval_)
+    : Thread ("MetricsLogger"), file (file_), registry (registry_), interval (interval_), format (getFormat (file_))
+{
+}
+
+MetricsLogger::~MetricsLogger()
+{
+    close();
+}
+
+MetricsLogger::Format MetricsLogger::getFormat (const File& file)
+{
+    return file.getFileExtension() == NdJsonFileExtension ? Format::NdJson : Format::Csv;
+}
+
+bool MetricsLogger::open()
+{
+    if (file.getParentDirectory().createDirectory().failed())
+    {
+        LOGE ("Unable to create the metrics directory ", file.getParentDirectory().getFullPathName());
+        return false;
+    }
+
+    stream = std::make_unique<FileOutputStream> (file);
+
+    if (stream->failedToOpen())
+    {
+        LOGE ("Unable to open the metrics file ", file.getFullPathName(), ": ", stream->getStatus().getErrorMessage());
+        stream.reset();
+        return false;
+    }
+
+    // NB: Snapshots are appended, so restarting acquisition with the same file keeps the earlier snapshots
+    if (format == Format::Csv && stream->getPosition() == 0)
+    {
+        std::string header = "time,elapsed";
+
+        for (const auto& metric : registry.getMetrics())
+            header += "," + metric.name;
+
+        header += "\n";
+        stream->write (header.data(), header.size());
+        stream->flush();
+    }
+
+    startTime = std::chrono::steady_clock::now();
+
+    return true;
+}
+
+void MetricsLogger::close()
+{
+    if (stream == nullptr)
+        return;
+
+    stopThread (1000);
+
+    writeSnapshot();
+
+    stream.reset();
+}
+
+void MetricsLogger::run()
+{
+    while (! threadShouldExit())
+    {
+        wait ((int) interval.count());
+
+        if (threadShouldExit())
+            break;
+
+        writeSnapshot();
+    }
+}
+
+void MetricsLogger::writeSnapshot()
+{
+    const auto values = registry.takeSnapshot();
+    const auto& metrics = registry.getMetrics();
+
+    const auto time = Time::getCurrentTime().toISO8601 (true).toStdString();
+    const double elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now() - startTime).count();
+
+    char number[32];
+    std::snprintf (number, sizeof (number), "%.3f", elapsed);
+
+    std::string line = format == Format::NdJson ? "{\"time\":\"" + time + "\",\"elapsed\":" + number
+                                                : time + "," + number;
+
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        // NB: Counters are written as integers so that large counts keep every digit
+        if (std::isnan (values[i]))
+            number[0] = '\0';
+        else if (metrics[i].type == MetricsRegistry::Type::Counter)
+            std::snprintf (number, sizeof (number), "%.0f", values[i]);
+        else
+            std::snprintf (number, sizeof (number), "%.6g", values[i]);
+
+        if (format == Format::NdJson)
+            line += ",\"" + metrics[i].name + "\":" + (number[0] == '\0' ? "null" : number);
+        else
+            line += std::string (",") + number;
+    }
+
+    line += format == Format::NdJson ? "}\n" : "\n";
+
+    stream->write (line.data(), line.size());
+    stream->flush();
+
+    snapshotCount++;
+}
@@ -0,0 +1,100 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <DataThreadHeaders.h>
+
+#include <chrono>
+#include <memory>
+
+#include "MetricsRegistry.h"
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Appends a snapshot of every metric in a MetricsRegistry to a file at a fixed interval, from a low-priority
+    thread, so that long unattended sessions can be reviewed afterwards.
+
+    Files ending in .ndjson are written as newline-delimited JSON, with one object per snapshot:
+
+        {"time":"2025-01-01T12:00:00.000+01:00","elapsed":10.0,"<metric>":<value>,...}
+
+    Any other file is written as CSV, with a header row naming each metric followed by one row per snapshot:
+
+        time,elapsed,<metric>,...
+
+    time is the local wall-clock time of the snapshot, and elapsed the number of seconds since the thread
+    started. A final snapshot is written when the thread is stopped.
+
+*/
+class MetricsLogger : public Thread
+{
+public:
+    enum class Format
+    {
+        Csv,
+        NdJson
+    };
+
+    /** The registry must not change, and must outlive the thread */
+    MetricsLogger (File file, const MetricsRegistry& registry, std::chrono::milliseconds interval);
+
+    ~MetricsLogger();
+
+    /** Creates the file and writes the CSV header. Returns false if the file could not be created. */
+    bool open();
+
+    /** Stops the thread, writes a last snapshot, and closes the file */
+    void close();
+
+    void run() override;
+
+    File getFile() const { return file; }
+
+    int getSnapshotCount() const { return snapshotCount; }
+
+    static Format getFormat (const File& file);
+
+    static constexpr const char* CsvFileExtension = ".csv";
+    static constexpr const char* NdJsonFileExtension = ".ndjson";
+
+    static constexpr int DefaultIntervalSeconds = 10;
+
+private:
+    const File file;
+    const MetricsRegistry& registry;
+    const std::chrono::milliseconds interval;
+    const Format format;
+
+    std::unique_ptr<FileOutputStream> stream;
+
+    std::chrono::steady_clock::time_point startTime;
+
+    int snapshotCount = 0;
+
+    void writeSnapshot();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MetricsLogger);
+};
+} // namespace OnixSourcePlugin
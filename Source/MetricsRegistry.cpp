@@ -0,0 +1,60 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "MetricsRegistry.h"
+
+using namespace OnixSourcePlugin;
+
+void MetricsRegistry::addCounter (std::string name, std::function<uint64_t()> read)
+{
+    metrics.push_back ({ name, Type::Counter, [read]
+                         { return (double) read(); } });
+}
+
+void MetricsRegistry::addGauge (std::string name, std::function<double()> read)
+{
+    metrics.push_back ({ name, Type::Gauge, read });
+}
+
+std::vector<double> MetricsRegistry::takeSnapshot() const
+{
+    std::vector<double> values;
+    values.reserve (metrics.size());
+
+    for (const auto& metric : metrics)
+        values.push_back (metric.read());
+
+    return values;
+}
+
+std::string MetricsRegistry::getTypeName (Type type)
+{
+    switch (type)
+    {
+        case Type::Counter:
+            return "counter";
+        case Type::Gauge:
+            return "gauge";
+        default:
+            return "";
+    }
+}
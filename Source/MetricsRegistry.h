@@ -0,0 +1,76 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <DataThreadHeaders.h>
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Named counters and gauges that are sampled periodically, for example by MetricsLogger.
+
+    Metrics are read through a function when a snapshot is taken, so recording them costs nothing beyond the
+    counters that the acquisition threads already keep. Counters only increase during an acquisition, while
+    gauges are instantaneous values. Metrics must all be added before the first snapshot, and the functions
+    must be safe to call from the thread that takes snapshots.
+
+*/
+class MetricsRegistry
+{
+public:
+    enum class Type
+    {
+        Counter,
+        Gauge
+    };
+
+    struct Metric
+    {
+        std::string name;
+        Type type;
+        std::function<double()> read;
+    };
+
+    void addCounter (std::string name, std::function<uint64_t()> read);
+
+    void addGauge (std::string name, std::function<double()> read);
+
+    const std::vector<Metric>& getMetrics() const { return metrics; }
+
+    /** Reads every metric, in the order they were added */
+    std::vector<double> takeSnapshot() const;
+
+    static std::string getTypeName (Type type);
+
+private:
+    std::vector<Metric> metrics;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MetricsRegistry);
+};
+} // namespace OnixSourcePlugin
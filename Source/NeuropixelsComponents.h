@@ -301,7 +301,7 @@ struct ProbeSettings
 
     void selectElectrodes (std::vector<int> electrodes)
     {
-        for (int i = 0; i < electrodes.size(); i++)
+        for (int i = 0; i < (int) electrodes.size(); i++)
         {
             selectElectrode (electrodes[i]);
         }
@@ -314,7 +314,7 @@ struct ProbeSettings
         int shank = electrodeMetadata[electrode].shank;
         int global_index = electrodeMetadata[electrode].global_index;
 
-        for (int j = 0; j < electrodeMetadata.size(); j++)
+        for (int j = 0; j < (int) electrodeMetadata.size(); j++)
         {
             if (electrodeMetadata[j].channel == channel)
             {
@@ -357,12 +357,12 @@ struct ProbeSettings
     ProbeMetadata probeMetadata;
 };
 
-template <int N>
+template <size_t N>
 std::vector<unsigned char> toBitReversedBytes (std::bitset<N> bits)
 {
     std::vector<unsigned char> bytes ((bits.size() - 1) / 8 + 1);
 
-    for (int i = 0; i < bytes.size(); i++)
+    for (int i = 0; i < (int) bytes.size(); i++)
     {
         for (int j = 0; j < 8; j++)
         {
@@ -401,33 +401,9 @@ public:
     virtual std::string getFlexVersion (int index) = 0;
     virtual std::vector<int> selectElectrodeConfiguration (int electrodeConfigurationIndex, ProbeType probeType) = 0;
 
-    bool saveProbeInterfaceFile (File recordingDirectory, std::string streamName, int probeIndex = 0)
-    {
-        if (streamName != "")
-        {
-            File filename = ProbeInterfaceJson::createFileName (recordingDirectory, streamName);
-
-            LOGC ("Saving " + filename.getFullPathName());
-
-            try
-            {
-                ProbeInterfaceJson::writeProbeSettingsToJson (filename, settings[probeIndex].get());
-            }
-            catch (const error_str& e)
-            {
-                Onix1::showWarningMessageBoxAsync ("Unable to Save Probe JSON File", e.what());
-                return false;
-            }
-        }
-        else
-        {
-            Onix1::showWarningMessageBoxAsync ("No Valid Stream",
-                                               "Could not find a valid data stream when writing the Probe Interface file.");
-            return false;
-        }
-
-        return true;
-    }
+    /** Writes the settings of the given probe to a Probe Interface JSON file. Defined in Formats/ProbeInterface.h,
+        after ProbeInterfaceJson. */
+    bool saveProbeInterfaceFile (File recordingDirectory, std::string streamName, int probeIndex = 0);
 };
 
 static constexpr int shankConfigurationBitCount = 968;
@@ -436,7 +412,7 @@ static constexpr int BaseConfigurationBitCount = 2448;
 using ShankBitset = std::bitset<shankConfigurationBitCount>;
 using ConfigBitsArray = std::array<std::bitset<BaseConfigurationBitCount>, 2>;
 
-static class NeuropixelsV1
+class NeuropixelsV1
 {
 public:
     ShankBitset static makeShankBits (NeuropixelsV1Reference reference, std::vector<int> channelMap)
@@ -565,7 +541,7 @@ public:
     }
 };
 
-static class NeuropixelsHelpers
+class NeuropixelsHelpers
 {
 public:
     /** Set all channel metadata, starting with the last (most recently added) channel and working backwards over all selected electrodes */
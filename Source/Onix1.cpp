@@ -21,19 +21,22 @@
 */
 
 #include "Onix1.h"
+#include "AsyncLogger.h"
 
 #include "OnixDevice.h"
+#include "TraceRecorder.h"
 
 using namespace OnixSourcePlugin;
 
-Onix1::Onix1 (int hostIndex)
-{
-    ctx_ = oni_create_ctx ("riffa");
+std::shared_ptr<StatusReporter> Onix1::statusReporter;
+std::mutex Onix1::statusReporterLock;
 
-    if (ctx_ == nullptr)
-        throw std::system_error (errno, std::system_category());
+Onix1::Onix1 (std::string driverName_, int hostIndex)
+    : driverName (driverName_)
+{
+    driver = OnixDriver::create (driverName);
 
-    int rc = oni_init_ctx (ctx_, hostIndex);
+    int rc = driver->init (hostIndex);
 
     if (rc != ONI_ESUCCESS)
         throw error_t (rc);
@@ -45,7 +48,13 @@ Onix1::Onix1 (int hostIndex)
 
 Onix1::~Onix1()
 {
-    oni_destroy_ctx (ctx_);
+}
+
+std::string Onix1::getDefaultDriverName()
+{
+    auto name = std::getenv ("ONIX_SOURCE_DRIVER");
+
+    return name != nullptr && *name != '\0' ? name : "riffa";
 }
 
 int Onix1::getDeviceTable (device_map_t* deviceTable)
@@ -90,10 +99,10 @@ std::map<int, int> Onix1::getHubIds (device_map_t deviceTable) const
 
     auto offsets = OnixDevice::getUniqueOffsets (deviceIndices, false);
 
-    for (int i = 0; i < offsets.size(); i++)
+    for (int i = 0; i < (int) offsets.size(); i++)
     {
         oni_reg_val_t hubId = 0;
-        int rc = oni_read_reg (ctx_, offsets[i] + ONIX_HUB_DEV_IDX, (uint32_t) ONIX_HUB_HARDWAREID, &hubId);
+        int rc = readRegister (offsets[i] + ONIX_HUB_DEV_IDX, (uint32_t) ONIX_HUB_HARDWAREID, &hubId);
         if (rc != ONI_ESUCCESS)
         {
             LOGE ("Unable to read the hub device index for the hub at index ", offsets[i]);
@@ -123,9 +132,9 @@ int Onix1::get_opt_ (int option, void* value, size_t* size) const
 {
     const ScopedLock lock (registerLock);
 
-    int rc = oni_get_opt (ctx_, option, value, size);
+    int rc = driver->getOption (option, value, size);
     if (rc != ONI_ESUCCESS)
-        LOGE (oni_error_str (rc));
+        AsyncLogger::log (AsyncLogger::Level::Error, "Unable to get option", nullptr, oni_error_str (rc), option);
     return rc;
 }
 
@@ -133,9 +142,9 @@ int Onix1::readRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress,
 {
     const ScopedLock lock (registerLock);
 
-    int rc = oni_read_reg (ctx_, devIndex, registerAddress, value);
+    int rc = driver->readRegister (devIndex, registerAddress, value);
     if (rc != ONI_ESUCCESS)
-        LOGE (oni_error_str (rc));
+        AsyncLogger::log (AsyncLogger::Level::Error, "Unable to read a register of device", nullptr, oni_error_str (rc), devIndex);
     return rc;
 }
 
@@ -143,9 +152,9 @@ int Onix1::writeRegister (oni_dev_idx_t devIndex, oni_reg_addr_t registerAddress
 {
     const ScopedLock lock (registerLock);
 
-    int rc = oni_write_reg (ctx_, devIndex, registerAddress, value);
+    int rc = driver->writeRegister (devIndex, registerAddress, value);
     if (rc != ONI_ESUCCESS)
-        LOGE (oni_error_str (rc));
+        AsyncLogger::log (AsyncLogger::Level::Error, "Unable to write a register of device", nullptr, oni_error_str (rc), devIndex);
     return rc;
 }
 
@@ -168,25 +177,113 @@ double Onix1::convertTimestampToSeconds (uint64_t timestamp) const
 
 oni_frame_t* Onix1::readFrame() const
 {
+    TraceScope trace ("Onix1::readFrame", "oni");
+
     const ScopedLock lock (frameLock);
 
     oni_frame_t* frame = nullptr;
-    int rc = oni_read_frame (ctx_, &frame);
+    int rc = driver->readFrame (&frame);
     if (rc < ONI_ESUCCESS)
     {
-        LOGE (oni_error_str (rc));
+        AsyncLogger::log (AsyncLogger::Level::Error, "Unable to read a frame", nullptr, oni_error_str (rc));
         return nullptr;
     }
 
     return frame;
 }
 
+void Onix1::destroyFrame (oni_frame_t* frame) const
+{
+    driver->destroyFrame (frame);
+}
+
+int Onix1::resetBlockReadState()
+{
+    const ScopedLock lock (frameLock);
+
+    bytesRemainingInBlock = 0;
+
+    oni_size_t value;
+    int rc = getOption (ONI_OPT_BLOCKREADSIZE, &value);
+    if (rc != ONI_ESUCCESS)
+        return rc;
+
+    blockReadSize = value;
+
+    rc = getOption (ONI_OPT_MAXREADFRAMESIZE, &value);
+    if (rc != ONI_ESUCCESS)
+        return rc;
+
+    maxReadFrameSize = value;
+
+    return ONI_ESUCCESS;
+}
+
+void Onix1::consumeBlockBytes (size_t numBytes)
+{
+    if (bytesRemainingInBlock < numBytes)
+        bytesRemainingInBlock = blockReadSize;
+
+    bytesRemainingInBlock -= std::min (numBytes, bytesRemainingInBlock);
+}
+
+int Onix1::readFrames (oni_frame_t** frames, size_t maxFrames, std::chrono::microseconds timeout)
+{
+    if (maxFrames == 0)
+        return 0;
+
+    TraceScope trace ("Onix1::readFrames", "oni");
+
+    const ScopedLock lock (frameLock);
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    size_t numFrames = 0;
+
+    while (numFrames < maxFrames)
+    {
+        oni_frame_t* frame = nullptr;
+        int rc = driver->readFrame (&frame);
+        if (rc < ONI_ESUCCESS)
+        {
+            // NB: Return the frames that were already read; the error will be seen again on the next call
+            return numFrames > 0 ? (int) numFrames : rc;
+        }
+
+        frames[numFrames++] = frame;
+
+        consumeBlockBytes (FrameHeaderSize);
+        consumeBlockBytes (frame->data_sz);
+
+        // NB: Stop before the next frame could need a new block, since that read blocks until the hardware
+        //     has produced a full block and would delay every frame already in this batch
+        if (bytesRemainingInBlock < FrameHeaderSize + maxReadFrameSize || std::chrono::steady_clock::now() >= deadline)
+            break;
+    }
+
+    trace.setArgument ("frames", (double) numFrames);
+
+    return (int) numFrames;
+}
+
 void Onix1::showWarningMessageBoxAsync (std::string title, std::string error_msg)
 {
-    LOGD (error_msg);
-    MessageManager::callAsync ([title, error_msg]
-                               { AlertWindow::showMessageBoxAsync (
-                                     MessageBoxIconType::WarningIcon,
-                                     title,
-                                     error_msg); });
+    getStatusReporter()->showWarning (title, error_msg);
+}
+
+std::shared_ptr<StatusReporter> Onix1::getStatusReporter()
+{
+    const std::lock_guard<std::mutex> lock (statusReporterLock);
+
+    if (statusReporter == nullptr)
+        statusReporter = std::make_shared<LogStatusReporter>();
+
+    return statusReporter;
+}
+
+void Onix1::setStatusReporter (std::shared_ptr<StatusReporter> reporter)
+{
+    const std::lock_guard<std::mutex> lock (statusReporterLock);
+
+    statusReporter = reporter;
 }
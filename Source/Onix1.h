@@ -22,21 +22,26 @@
 
 #pragma once
 
+#include <chrono>
 #include <exception>
+#include <mutex>
 #include <oni.h>
 #include <onix.h>
 #include <system_error>
 
 #include <DataThreadHeaders.h>
 
+#include "Drivers/OnixDriver.h"
+#include "StatusReporter.h"
+
 #include "../../plugin-GUI/Source/Utils/Utils.h"
 
 namespace OnixSourcePlugin
 {
-constexpr char* NEUROPIXELSV1F_HEADSTAGE_NAME = "Neuropixels 1.0f Headstage";
-constexpr char* NEUROPIXELSV1E_HEADSTAGE_NAME = "Neuropixels 1.0e Headstage";
-constexpr char* NEUROPIXELSV2E_HEADSTAGE_NAME = "Neuropixels 2.0e Headstage";
-constexpr char* BREAKOUT_BOARD_NAME = "Breakout Board";
+constexpr const char* NEUROPIXELSV1F_HEADSTAGE_NAME = "Neuropixels 1.0f Headstage";
+constexpr const char* NEUROPIXELSV1E_HEADSTAGE_NAME = "Neuropixels 1.0e Headstage";
+constexpr const char* NEUROPIXELSV2E_HEADSTAGE_NAME = "Neuropixels 2.0e Headstage";
+constexpr const char* BREAKOUT_BOARD_NAME = "Breakout Board";
 
 class error_t : public std::exception
 {
@@ -75,11 +80,18 @@ using device_map_t = std::map<oni_dev_idx_t, oni_device_t>;
 class Onix1
 {
 public:
-    Onix1 (int hostIndex = -1);
+    /** Creates a context using the given ONI driver. Names are passed to OnixDriver::create, which loads the
+        hardware driver through liboni or selects the emulator. */
+    Onix1 (std::string driverName = getDefaultDriverName(), int hostIndex = -1);
 
     ~Onix1();
 
-    inline bool isInitialized() const { return ctx_ != nullptr; }
+    inline bool isInitialized() const { return driver != nullptr; }
+
+    /** Gets the driver selected with the ONIX_SOURCE_DRIVER environment variable, or "riffa" for the ONIX PCIe host if it is not set */
+    static std::string getDefaultDriverName();
+
+    std::string getDriverName() const { return driverName; }
 
     template <typename opt_t>
     int getOption (int option, opt_t* value)
@@ -94,7 +106,7 @@ public:
     {
         const ScopedLock lock (registerLock);
 
-        int rc = oni_set_opt (ctx_, option, &value, opt_size_<opt_t> (value));
+        int rc = driver->setOption (option, &value, opt_size_<opt_t> (value));
         if (rc != ONI_ESUCCESS)
             LOGE (oni_error_str (rc));
         return rc;
@@ -108,30 +120,74 @@ public:
 
     oni_frame_t* readFrame() const;
 
+    /** Releases a frame returned by readFrame or readFrames. Frames must not be passed to oni_destroy_frame,
+        since they may not have been allocated by liboni. */
+    void destroyFrame (oni_frame_t* frame) const;
+
+    /** Reads up to maxFrames frames into the given array under a single lock acquisition. The first read
+        blocks until a frame is available; subsequent reads stop before a frame could require a new block
+        read from the hardware, or once the timeout has elapsed. The timeout is only checked between reads, so
+        it cannot cut short a read that blocks; it only bounds how long frames already read are held back while
+        the rest of the block is read. Returns the number of frames read, or a negative ONI error code if no frame
+        could be read. Errors are not logged, since reads also fail when acquisition is stopped; the caller
+        decides whether to report them. */
+    int readFrames (oni_frame_t** frames, size_t maxFrames, std::chrono::microseconds timeout);
+
+    /** Resets the block tracking used by readFrames. Must be called before acquisition starts, after the
+        block read size has been set. */
+    int resetBlockReadState();
+
+    /** Size in bytes of the header that precedes the data of each frame in a block read */
+    static constexpr size_t FrameHeaderSize = sizeof (oni_fifo_time_t) + 2 * sizeof (oni_fifo_dat_t);
+
     int issueReset();
 
     static std::string getVersion();
 
     double convertTimestampToSeconds (uint64_t timestamp) const;
 
+    /** Returns the frequency in Hz of the acquisition clock, which convertTimestampToSeconds also applies to hub clocks */
+    uint32_t getAcquisitionClockHz() const { return ACQ_CLK_HZ; }
+
     /** Gets a map of all hubs connected, where the index of the map is the hub address, and the value is the hub ID */
     std::map<int, int> getHubIds (device_map_t) const;
 
     /** Gets a vector of device indices from a device_map_t object, optionally filtered by a specific hub */
     static std::vector<int> getDeviceIndices (device_map_t deviceMap, int hubIndex = -1);
 
-    /** Displays an AlertWindow::showMessageBoxAsync window using the message thread, with a warning icon */
+    /** Shows a warning through the current StatusReporter; the plugin displays it in a message box */
     static void showWarningMessageBoxAsync (std::string, std::string);
 
+    /** Returns the reporter that receives warnings, status messages, and progress. Defaults to a
+        LogStatusReporter until setStatusReporter is called. */
+    static std::shared_ptr<StatusReporter> getStatusReporter();
+
+    /** Replaces the reporter shared by every context, for instance with one that uses the GUI */
+    static void setStatusReporter (std::shared_ptr<StatusReporter> reporter);
+
 private:
-    /** The ONI ctx object */
-    oni_ctx ctx_;
+    static std::shared_ptr<StatusReporter> statusReporter;
+    static std::mutex statusReporterLock;
+
+    /** Backend that owns the ONI context, or the emulated hardware */
+    std::unique_ptr<OnixDriver> driver;
+
+    const std::string driverName;
 
     CriticalSection registerLock;
     CriticalSection frameLock;
 
     uint32_t ACQ_CLK_HZ;
 
+    // NB: Mirrors the read buffer in liboni, which is refilled with a full block whenever the next
+    //     header or payload does not fit in the bytes remaining. Guarded by frameLock. If the model drifts
+    //     from liboni, the only cost is an occasional batch that waits for the next block.
+    size_t blockReadSize = 0;
+    size_t maxReadFrameSize = 0;
+    size_t bytesRemainingInBlock = 0;
+
+    void consumeBlockBytes (size_t numBytes);
+
     template <typename opt_t>
     size_t opt_size_ (opt_t opt)
     {
@@ -39,7 +39,7 @@ const std::map<OnixDeviceType, std::string> OnixDevice::TypeString = {
 };
 
 OnixDevice::OnixDevice (std::string name_, std::string hubName, OnixDeviceType type_, const oni_dev_idx_t deviceIdx_, std::shared_ptr<Onix1> ctx, bool passthrough)
-    : type (type_), deviceIdx (deviceIdx_), frameQueue (32)
+    : deviceIdx (deviceIdx_), type (type_)
 {
     deviceContext = ctx;
     name = name_;
@@ -59,11 +59,11 @@ std::string OnixDevice::createStreamName (std::vector<std::string> names)
 {
     std::string streamName;
 
-    for (int i = 0; i < names.size(); i++)
+    for (int i = 0; i < (int) names.size(); i++)
     {
         streamName += names[i];
 
-        if (i != names.size() - 1)
+        if (i != (int) names.size() - 1)
             streamName += "-";
     }
 
@@ -281,21 +281,135 @@ Array<PortName> OnixDevice::getUniquePorts (std::vector<int> indices)
     return ports;
 }
 
-bool OnixDevice::compareIndex (uint32_t index)
+void OnixDevice::addFrames (oni_frame_t* const* frames, size_t count, int64_t readTime)
 {
-    return index == deviceIdx;
+    uint64_t numBytes = 0;
+
+    for (size_t i = 0; i < count; i++)
+        numBytes += Onix1::FrameHeaderSize + frames[i]->data_sz;
+
+    incrementCounter (framesReceived, count);
+    incrementCounter (bytesReceived, numBytes);
+
+    const size_t numQueued = frameQueue.enqueueBulk (frames, count, readTime);
+
+    for (size_t i = numQueued; i < count; i++)
+        deviceContext->destroyFrame (frames[i]);
+}
+
+bool OnixDevice::dequeueFrame (oni_frame_t*& frame)
+{
+    int64_t readTime;
+
+    if (! frameQueue.tryDequeue (frame, readTime))
+        return false;
+
+    latencyProbe.recordDequeue (readTime);
+
+    return true;
+}
+
+size_t OnixDevice::dequeueFrames (oni_frame_t** frames, size_t maxFrames)
+{
+    int64_t firstReadTime;
+
+    const size_t numFrames = frameQueue.dequeueBulk (frames, maxFrames, firstReadTime);
+
+    if (numFrames > 0)
+        latencyProbe.recordDequeue (firstReadTime);
+
+    return numFrames;
+}
+
+void OnixDevice::recordBufferWrite (size_t numSamples)
+{
+    incrementCounter (samplesDecoded, numSamples);
+
+    latencyProbe.recordBufferWrite();
+}
+
+double OnixDevice::getFramePeriodTicks (double framesPerSecond) const
+{
+    return deviceContext != nullptr && framesPerSecond > 0.0 ? deviceContext->getAcquisitionClockHz() / framesPerSecond : 0.0;
+}
+
+uint32_t OnixDevice::recordGap (uint32_t missingFrames)
+{
+    incrementCounter (gapCount, 1);
+    incrementCounter (missingFrameCount, missingFrames);
+
+    return advanceSampleNumbersOnGaps ? missingFrames : 0;
+}
+
+void OnixDevice::allocateFrameQueue (uint32_t blockReadSize)
+{
+    auto framesPerBlock = blockReadSize / MinimumFrameSize;
+    auto framesPerQueue = (size_t) std::ceil (getFramesPerSecond() * FrameQueueSeconds);
+
+    frameQueue.allocate (framesPerQueue + framesPerBlock);
+
+    latencyProbe.reset();
+
+    framesReceived.store (0, std::memory_order_relaxed);
+    bytesReceived.store (0, std::memory_order_relaxed);
+    samplesDecoded.store (0, std::memory_order_relaxed);
+    decodeNanoseconds.store (0, std::memory_order_relaxed);
+    gapCount.store (0, std::memory_order_relaxed);
+    missingFrameCount.store (0, std::memory_order_relaxed);
+
+    // NB: The hub name can change after the device is created, so the interned name is updated for each acquisition
+    internedName = TraceRecorder::intern (getInstanceName());
+}
+
+void OnixDevice::processQueuedFrames()
+{
+    const size_t queuedFrames = frameQueue.sizeApprox();
+
+    // NB: Acquisition threads poll every device on each wake, so empty calls are neither timed nor traced, which
+    //     keeps the per-thread trace buffers for calls that did work
+    if (queuedFrames == 0)
+    {
+        processFrames();
+        return;
+    }
+
+    TraceScope trace (internedName, "decode", "frames", (double) queuedFrames);
+
+    const int64_t start = LatencyProbe::now();
+    processFrames();
+    incrementCounter (decodeNanoseconds, (uint64_t) (LatencyProbe::now() - start));
+}
+
+void OnixDevice::registerMetrics (MetricsRegistry& registry)
+{
+    const auto prefix = getInstanceName() + ".";
+
+    registry.addCounter (prefix + "frames_received", [this]
+                         { return getFramesReceived(); });
+    registry.addCounter (prefix + "frames_dropped", [this]
+                         { return getFrameQueueOverflowCount(); });
+    registry.addGauge (prefix + "queue_depth", [this]
+                       { return (double) getFrameQueueDepth(); });
+    registry.addGauge (prefix + "queue_high_water", [this]
+                       { return (double) getFrameQueueHighWaterMark(); });
+    registry.addCounter (prefix + "decode_ns", [this]
+                         { return getDecodeNanoseconds(); });
+    registry.addCounter (prefix + "gaps", [this]
+                         { return getGapCount(); });
+    registry.addCounter (prefix + "missing_frames", [this]
+                         { return getMissingFrameCount(); });
 }
 
-void OnixDevice::addFrame (oni_frame_t* frame)
+std::string OnixDevice::getInstanceName()
 {
-    frameQueue.enqueue (frame);
+    return createStreamName ("", getPortName (getDeviceIdx()) != "");
 }
 
 void OnixDevice::stopAcquisition()
 {
     oni_frame_t* frame;
-    while (frameQueue.try_dequeue (frame))
+    while (frameQueue.tryDequeue (frame))
     {
-        oni_destroy_frame (frame);
+        deviceContext->destroyFrame (frame);
     }
 }
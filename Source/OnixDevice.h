@@ -27,11 +27,14 @@
 #include <ratio>
 #include <thread>
 
+#include "FrameGapDetector.h"
+#include "FrameRing.h"
+#include "LatencyProbe.h"
+#include "MetricsRegistry.h"
 #include "Onix1.h"
-#include "Queue/readerwriterqueue.h"
+#include "TraceRecorder.h"
 
 using namespace std::chrono;
-using namespace moodycamel;
 
 namespace OnixSourcePlugin
 {
@@ -88,7 +91,7 @@ public:
         m_channelIdentifierDataType = channelIdentifierDataType;
         m_channelIdentifierSubTypes = channelIdentifierSubTypes;
 
-        if (m_numChannels != m_channelNameSuffixes.size())
+        if (m_numChannels != (int) m_channelNameSuffixes.size())
         {
             if (m_channelNameSuffixes.size() != 0)
                 LOGE ("Difference between number of channels and channel name suffixes. Generating default suffixes instead.");
@@ -102,7 +105,7 @@ public:
             }
         }
 
-        if (m_channelIdentifierSubTypes.size() > 0 && m_numChannels != m_channelIdentifierSubTypes.size())
+        if (m_channelIdentifierSubTypes.size() > 0 && m_numChannels != (int) m_channelIdentifierSubTypes.size())
         {
             if (m_channelIdentifierSubTypes.size() == 1)
             {
@@ -169,14 +172,74 @@ public:
     /** Constructor */
     OnixDevice (std::string name_, std::string hubName, OnixDeviceType type_, const oni_dev_idx_t, std::shared_ptr<Onix1> oni_ctx, bool passthrough = false);
 
-    virtual void addFrame (oni_frame_t*);
+    /** Queues count frames for processing, in order. readTime is the host time at which the frames were read, from
+        LatencyProbe::now(). Frames that do not fit in the frame queue are destroyed. */
+    virtual void addFrames (oni_frame_t* const* frames, size_t count, int64_t readTime);
+
+    /** Queues a single frame for processing */
+    void addFrame (oni_frame_t* frame, int64_t readTime) { addFrames (&frame, 1, readTime); }
     virtual void processFrames() = 0;
+
+    /** Calls processFrames, recording a trace event if tracing is enabled and frames are waiting to be processed.
+        Used by the acquisition threads instead of calling processFrames directly. */
+    void processQueuedFrames();
+
+    /** Adds the counters and gauges of this device to the registry, named after getInstanceName(). Devices with
+        their own state to monitor extend this. The device must outlive the registry. */
+    virtual void registerMetrics (MetricsRegistry& registry);
+
     virtual int configureDevice() = 0;
     virtual bool updateSettings() = 0;
     virtual void startAcquisition() {};
     virtual void stopAcquisition();
     virtual void addSourceBuffers (OwnedArray<DataBuffer>& sourceBuffers) = 0;
-    virtual bool compareIndex (uint32_t index);
+
+    /** Allocates the frame queue so it can hold all frames expected during FrameQueueSeconds, plus one
+        full block read. Must be called before acquisition starts. */
+    void allocateFrameQueue (uint32_t blockReadSize);
+
+    /** Returns the largest number of frames that were waiting to be processed during this acquisition */
+    size_t getFrameQueueHighWaterMark() const { return frameQueue.getHighWaterMark(); }
+
+    /** Returns the number of frames dropped during this acquisition because the frame queue was full */
+    uint64_t getFrameQueueOverflowCount() const { return frameQueue.getOverflowCount(); }
+
+    size_t getFrameQueueCapacity() const { return frameQueue.getCapacity(); }
+
+    /** Returns the latencies of frames from this device through each stage of the acquisition pipeline. Can be
+        read during acquisition; reset when the frame queue is allocated. */
+    const LatencyProbe& getLatencyProbe() const { return latencyProbe; }
+
+    /** Returns the number of frames received from the FrameReader during this acquisition, including dropped frames */
+    uint64_t getFramesReceived() const { return framesReceived.load (std::memory_order_relaxed); }
+
+    /** Returns the number of bytes received during this acquisition, including frame headers */
+    uint64_t getBytesReceived() const { return bytesReceived.load (std::memory_order_relaxed); }
+
+    /** Returns the number of samples added to DataBuffers during this acquisition, summed over all buffers of this device */
+    uint64_t getSamplesDecoded() const { return samplesDecoded.load (std::memory_order_relaxed); }
+
+    /** Returns the time spent in processFrames during this acquisition, when called from processQueuedFrames */
+    uint64_t getDecodeNanoseconds() const { return decodeNanoseconds.load (std::memory_order_relaxed); }
+
+    /** Returns the number of gaps found in the clocks of the frames decoded during this acquisition */
+    uint64_t getGapCount() const { return gapCount.load (std::memory_order_relaxed); }
+
+    /** Returns the number of frames missing from the gaps found during this acquisition */
+    uint64_t getMissingFrameCount() const { return missingFrameCount.load (std::memory_order_relaxed); }
+
+    /** If enabled, sample numbers skip over the frames missing from each gap, so that they stay in step with the
+        clock instead of counting only the frames that arrived. Set before acquisition starts. */
+    void setAdvanceSampleNumbersOnGaps (bool enable) { advanceSampleNumbersOnGaps = enable; }
+
+    bool getAdvanceSampleNumbersOnGaps() const { return advanceSampleNumbersOnGaps; }
+
+    /** Returns the number of frames currently waiting to be processed */
+    size_t getFrameQueueDepth() const { return frameQueue.sizeApprox(); }
+
+    /** Returns the number of frames per second this device produces while acquiring, used to size the frame queue
+        and the block read size. Devices whose frames never reach the frame queue return zero. */
+    virtual double getFramesPerSecond() const = 0;
 
     const std::string getName() { return name; }
     virtual bool isEnabled() const { return enabled; }
@@ -192,11 +255,20 @@ public:
 
     const int bufferSizeInSeconds = 10;
 
+    /** Length of time that the frame queue can absorb if frames are not processed */
+    static constexpr double FrameQueueSeconds = 0.5;
+
+    /** Smallest size in bytes of a frame in a block read, used to estimate the number of frames per block */
+    static constexpr uint32_t MinimumFrameSize = 24;
+
     static constexpr int HubAddressBreakoutBoard = 0;
     static constexpr int HubAddressPortA = 256;
     static constexpr int HubAddressPortB = 512;
 
     std::string getHubName() { return m_hubName; }
+
+    /** Returns the port, hub and device name without spaces, which identifies this device in traces and metrics */
+    std::string getInstanceName();
     void setHubName (std::string hubName) { m_hubName = hubName; }
 
     static int getPortOffset (PortName port);
@@ -221,11 +293,61 @@ public:
 protected:
     oni_dev_idx_t getDeviceIndexFromPassthroughIndex (oni_dev_idx_t passthroughIndex) const;
 
-    ReaderWriterQueue<oni_frame_t*> frameQueue;
+    /** Removes the next frame from the frame queue and records how long it waited. Returns false if the queue is empty. */
+    bool dequeueFrame (oni_frame_t*& frame);
+
+    /** Removes up to maxFrames frames from the frame queue with a single update of the queue, and returns how many
+        were removed. Records how long the oldest of them waited, once for the whole run. */
+    size_t dequeueFrames (oni_frame_t** frames, size_t maxFrames);
+
+    /** Number of frames that decoders claim from the frame queue at once with dequeueFrames */
+    static constexpr size_t MaxFramesPerDequeue = 64;
+
+    /** Records that numSamples samples were added to a DataBuffer, and the latency of the most recently dequeued frame */
+    void recordBufferWrite (size_t numSamples);
+
+    /** Returns the number of clock ticks between frames of a stream that produces framesPerSecond frames, for
+        resetting a FrameGapDetector when acquisition starts */
+    double getFramePeriodTicks (double framesPerSecond) const;
+
+    /** Checks the clock of a frame against the previous frame of the same stream, and counts any frames missing in
+        between. Returns the number of sample numbers to skip before this frame, which is zero unless sample
+        numbers advance on gaps. */
+    uint32_t checkForGap (FrameGapDetector& detector, uint64_t clock)
+    {
+        const uint32_t missingFrames = detector.checkFrame (clock);
+
+        return missingFrames == 0 ? 0 : recordGap (missingFrames);
+    }
+
+    /** Returns getInstanceName() as a string that stays valid for the lifetime of the process, for naming this
+        device in traces and in AsyncLogger messages from the acquisition threads */
+    const char* getInternedName() const { return internedName; }
+
+    FrameRing frameQueue;
+    LatencyProbe latencyProbe;
     const oni_dev_idx_t deviceIdx;
     std::shared_ptr<Onix1> deviceContext;
 
 private:
+    // NB: Each counter has a single writer, so it is updated with a relaxed load and store instead of a
+    //     read-modify-write. Readers on other threads see a recent value without slowing down the writer.
+    std::atomic<uint64_t> framesReceived = 0;
+    std::atomic<uint64_t> bytesReceived = 0;
+    std::atomic<uint64_t> samplesDecoded = 0;
+    std::atomic<uint64_t> decodeNanoseconds = 0;
+    std::atomic<uint64_t> gapCount = 0;
+    std::atomic<uint64_t> missingFrameCount = 0;
+
+    bool advanceSampleNumbersOnGaps = false;
+
+    uint32_t recordGap (uint32_t missingFrames);
+
+    static void incrementCounter (std::atomic<uint64_t>& counter, uint64_t amount)
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
     std::string name;
 
     bool enabled = true;
@@ -233,6 +355,9 @@ private:
 
     std::string m_hubName;
 
+    /** Interned instance name, set when the frame queue is allocated */
+    const char* internedName = "OnixDevice";
+
     const OnixDeviceType type;
 
     enum class PassthroughIndex : uint32_t
@@ -22,8 +22,12 @@
 
 #include "OnixSource.h"
 
+#include "AsyncLogger.h"
+#include "DeviceDiscovery.h"
 #include "Devices/DeviceList.h"
 #include "OnixSourceCanvas.h"
+#include "TraceRecorder.h"
+#include "UI/GuiStatusReporter.h"
 
 using namespace OnixSourcePlugin;
 
@@ -32,6 +36,8 @@ OnixSource::OnixSource (SourceNode* sn)
       devicesFound (false),
       editor (NULL)
 {
+    Onix1::setStatusReporter (std::make_shared<GuiStatusReporter>());
+
     try
     {
         context = std::make_shared<Onix1>();
@@ -48,6 +54,12 @@ OnixSource::OnixSource (SourceNode* sn)
             "Failed to Initialize Context",
             e.what());
     }
+    catch (const error_str& e)
+    {
+        Onix1::showWarningMessageBoxAsync (
+            "Invalid Driver",
+            e.what());
+    }
 
     portA = std::make_shared<PortController> (PortName::PortA, context);
     portB = std::make_shared<PortController> (PortName::PortB, context);
@@ -57,6 +69,8 @@ OnixSource::OnixSource (SourceNode* sn)
         LOGE ("Failed to initialize context.");
         return;
     }
+
+    LOGC ("Using ONI driver ", context->getDriverName());
 }
 
 OnixSource::~OnixSource()
@@ -111,17 +125,15 @@ bool OnixSource::disconnectDevices (bool updateStreamInfo)
     return true;
 }
 
-template <class Device>
-bool OnixSource::configureDevice (OnixDeviceVector& sources,
-                                  OnixSourceEditor* editor,
-                                  std::string deviceName,
-                                  std::string hubName,
-                                  OnixDeviceType deviceType,
-                                  const oni_dev_idx_t deviceIdx,
-                                  std::shared_ptr<Onix1> ctx)
+std::shared_ptr<OnixDevice> OnixSource::getConfigurableDevice (OnixSourceEditor* editor,
+                                                              OnixDeviceType deviceType,
+                                                              std::string deviceName,
+                                                              std::string hubName,
+                                                              const oni_dev_idx_t deviceIdx,
+                                                              std::shared_ptr<Onix1> ctx)
 {
     auto canvas = editor->getCanvas();
-    std::shared_ptr<Device> device = std::static_pointer_cast<Device> (canvas->getDevicePtr (Device::getDeviceType(), deviceIdx));
+    std::shared_ptr<OnixDevice> device = canvas->getDevicePtr (deviceType, deviceIdx);
 
     if (device != nullptr)
     {
@@ -130,10 +142,10 @@ bool OnixSource::configureDevice (OnixDeviceVector& sources,
             LOGD ("Difference in names found for device at address ", deviceIdx, ". Found ", deviceName, " on ", hubName, ", but was expecting ", device->getName(), " on ", device->getHubName());
         }
     }
-    else if (device->getDeviceType() == OnixDeviceType::MEMORYMONITOR)
+    else if (deviceType == OnixDeviceType::MEMORYMONITOR)
     { // NB: These are devices with no equivalent settings tab that still need to be created and added to the vector of devices
         LOGD ("Creating new device ", deviceName, " on ", hubName);
-        device = std::make_shared<Device> (deviceName, hubName, deviceIdx, ctx);
+        device = DeviceDiscovery::createDevice (deviceType, deviceName, hubName, deviceIdx, ctx);
     }
 
     if (device == nullptr)
@@ -150,62 +162,9 @@ bool OnixSource::configureDevice (OnixDeviceVector& sources,
                 "Invalid Headstage Selection",
                 "Expected to find " + editor->getHeadstageSelected (OnixDevice::getOffset (deviceIdx)) + " on " + OnixDevice::getPortName (deviceIdx) + ", but found " + hubName + " instead. Confirm that the correct headstage is selected, and try to connect again.");
         }
-
-        return false;
-    }
-
-    int res = 1;
-
-    try
-    {
-        res = device->configureDevice();
-    }
-    catch (const error_str& e)
-    {
-        Onix1::showWarningMessageBoxAsync ("Configuration Error", e.what());
-
-        return false;
-    }
-
-    sources.emplace_back (device);
-
-    return res == ONI_ESUCCESS;
-}
-
-bool OnixSource::getHubFirmwareVersion (std::shared_ptr<Onix1> ctx, uint32_t hubIndex, uint32_t* firmwareVersion)
-{
-    if (ctx->readRegister (hubIndex + ONIX_HUB_DEV_IDX, ONIX_HUB_FIRMWAREVER, firmwareVersion) != ONI_ESUCCESS)
-    {
-        LOGE ("Unable to read the hub firmware version at index ", hubIndex);
-        return false;
-    }
-
-    return true;
-}
-
-bool OnixSource::enablePassthroughMode (std::shared_ptr<Onix1> ctx, bool passthroughA, bool passthroughB)
-{
-    if (ctx == nullptr || ! ctx->isInitialized())
-    {
-        Onix1::showWarningMessageBoxAsync ("Invalid Context", "Cannot enable passthrough mode, context is not initialized correctly.");
-        return false;
-    }
-
-    int val = 0;
-
-    if (passthroughA)
-    {
-        LOGD ("Passthrough mode enabled for Port A");
-        val |= 1 << 0;
-    }
-
-    if (passthroughB)
-    {
-        LOGD ("Passthrough mode enabled for Port B");
-        val |= 1 << 2;
     }
 
-    return ctx->setOption (ONIX_OPT_PASSTHROUGH, val) == ONI_ESUCCESS;
+    return device;
 }
 
 bool OnixSource::configurePort (PortName port)
@@ -263,48 +222,6 @@ bool OnixSource::resetPortLinkFlags (PortName port)
     return true;
 }
 
-bool OnixSource::checkHubFirmwareCompatibility (std::shared_ptr<Onix1> context, device_map_t deviceTable)
-{
-    auto hubIds = context->getHubIds (deviceTable);
-
-    if (hubIds.size() == 0)
-    {
-        LOGE ("No hub IDs found.");
-        return false;
-    }
-
-    for (const auto& [hubIndex, hubId] : hubIds)
-    {
-        if (hubId == ONIX_HUB_FMCHOST)
-        {
-            static constexpr int RequiredMajorVersion = 2;
-            uint32_t firmwareVersion = 0;
-            if (! getHubFirmwareVersion (context, hubIndex, &firmwareVersion))
-            {
-                return false;
-            }
-
-            auto majorVersion = (firmwareVersion & 0xFF00) >> 8;
-            auto minorVersion = firmwareVersion & 0xFF;
-
-            LOGC ("PCIe Host firmware version: v", majorVersion, ".", minorVersion);
-
-            if (majorVersion != RequiredMajorVersion)
-            {
-                Onix1::showWarningMessageBoxAsync (
-                    "Invalid Firmware Version",
-                    "The PCIe Host firmware major version is v"
-                        + std::to_string (majorVersion) + ", but this plugin is only compatible with v"
-                        + std::to_string (RequiredMajorVersion) + ". To use this plugin, modify the firmware"
-                        + " to version v" + std::to_string (majorVersion));
-                return false;
-            }
-        }
-    }
-
-    return true;
-}
-
 bool OnixSource::initializeDevices (device_map_t deviceTable, bool updateStreamInfo)
 {
     if (context == nullptr || ! context->isInitialized())
@@ -333,173 +250,26 @@ bool OnixSource::initializeDevices (device_map_t deviceTable, bool updateStreamI
 
     devicesFound = false;
 
-    // NB: Search through all hubs, and initialize devices
-    for (const auto& [hubIndex, hubId] : hubIds)
-    {
-        if (hubId == ONIX_HUB_FMCHOST)
-        {
-            hubNames.insert ({ hubIndex, BREAKOUT_BOARD_NAME });
-
-            static constexpr int OutputClockOffset = 5, AnalogIOOffset = 6, DigitalIOOffset = 7, MemoryMonitorOffset = 10, HarpSyncInputOffset = 12;
-
-            devicesFound = configureDevice<OutputClock> (sources, editor, OnixDevice::TypeString.at (OutputClock::getDeviceType()), BREAKOUT_BOARD_NAME, OutputClock::getDeviceType(), hubIndex + OutputClockOffset, context);
-            if (! devicesFound)
-            {
-                sources.clear();
-                return false;
-            }
-
-            devicesFound = configureDevice<DigitalIO> (sources, editor, OnixDevice::TypeString.at (DigitalIO::getDeviceType()), BREAKOUT_BOARD_NAME, DigitalIO::getDeviceType(), hubIndex + DigitalIOOffset, context);
-            if (! devicesFound)
-            {
-                sources.clear();
-                return false;
-            }
-
-            devicesFound = configureDevice<AnalogIO> (sources, editor, OnixDevice::TypeString.at (AnalogIO::getDeviceType()), BREAKOUT_BOARD_NAME, AnalogIO::getDeviceType(), hubIndex + AnalogIOOffset, context);
-            if (! devicesFound)
-            {
-                sources.clear();
-                return false;
-            }
+    deviceReadSizes.clear();
 
-            devicesFound = configureDevice<MemoryMonitor> (sources, editor, OnixDevice::TypeString.at (MemoryMonitor::getDeviceType()), BREAKOUT_BOARD_NAME, MemoryMonitor::getDeviceType(), hubIndex + MemoryMonitorOffset, context);
-            if (! devicesFound)
-            {
-                sources.clear();
-                return false;
-            }
-
-            devicesFound = configureDevice<HarpSyncInput> (sources, editor, OnixDevice::TypeString.at (HarpSyncInput::getDeviceType()), BREAKOUT_BOARD_NAME, HarpSyncInput::getDeviceType(), hubIndex + HarpSyncInputOffset, context);
-            if (! devicesFound)
-            {
-                sources.clear();
-                return false;
-            }
-        }
-        else if (hubId == ONIX_HUB_HSNP)
-        {
-            hubNames.insert ({ hubIndex, NEUROPIXELSV1F_HEADSTAGE_NAME });
+    for (const auto& [index, device] : deviceTable)
+        deviceReadSizes[index] = device.read_size;
 
-            for (int i = 0; i < 2; i++)
-            {
-                devicesFound = configureDevice<Neuropixels1f> (sources, editor, ProbeString + std::to_string (i), NEUROPIXELSV1F_HEADSTAGE_NAME, Neuropixels1f::getDeviceType(), hubIndex + i, context);
-                if (! devicesFound)
-                {
-                    sources.clear();
-                    return false;
-                }
-            }
+    connectedDeviceTable = deviceTable;
 
-            devicesFound = configureDevice<Bno055> (sources, editor, OnixDevice::TypeString.at (Bno055::getDeviceType()), NEUROPIXELSV1F_HEADSTAGE_NAME, Bno055::getDeviceType(), hubIndex + 2, context);
-            if (! devicesFound)
-            {
-                sources.clear();
-                return false;
-            }
-        }
-        else
-        {
-            Onix1::showWarningMessageBoxAsync (
-                "Unknown Hub ID",
-                "Discovered hub ID " + std::to_string (hubId) + " (" + onix_hub_str (hubId) + ") on " + OnixDevice::getPortName (hubIndex) + " which does not match any currently implemented hubs.");
-            devicesFound = false;
-            sources.clear();
-            return false;
-        }
-    }
+    blockReadSizeCalibrated = false;
 
-    // NB: Search for passthrough devices, and initialize any headstages found in passthrough mode
-    for (const auto& [index, device] : deviceTable)
+    auto factory = [this] (OnixDeviceType type, std::string name, std::string hubName, oni_dev_idx_t deviceIndex)
     {
-        if (device.id == ONIX_DS90UB9RAW)
-        {
-            LOGD ("Passthrough device detected");
+        return getConfigurableDevice (editor, type, name, hubName, deviceIndex, context);
+    };
 
-            auto serializer = std::make_unique<I2CRegisterContext> (DS90UB9x::SER_ADDR, index, context);
-            serializer->WriteByte ((uint32_t) DS90UB9x::DS90UB9xSerializerI2CRegister::SCLHIGH, 20);
-            serializer->WriteByte ((uint32_t) DS90UB9x::DS90UB9xSerializerI2CRegister::SCLLOW, 20);
+    devicesFound = DeviceDiscovery::discoverDevices (context, deviceTable, factory, sources, hubNames);
 
-            auto EEPROM = std::make_unique<HeadStageEEPROM> (index, context);
-            uint32_t hsid = EEPROM->GetHeadStageID();
-            LOGC ("Detected headstage ", onix_hub_str (hsid));
-
-            if (hsid == ONIX_HUB_HSNP2E)
-            {
-                auto hubIndex = OnixDevice::getHubIndexFromPassthroughIndex (index);
-
-                devicesFound = configureDevice<Neuropixels2e> (sources, editor, ProbeString, NEUROPIXELSV2E_HEADSTAGE_NAME, Neuropixels2e::getDeviceType(), hubIndex, context);
-                if (! devicesFound)
-                {
-                    sources.clear();
-                    return false;
-                }
-
-                devicesFound = configureDevice<PolledBno055> (sources, editor, OnixDevice::TypeString.at (PolledBno055::getDeviceType()), NEUROPIXELSV2E_HEADSTAGE_NAME, PolledBno055::getDeviceType(), hubIndex + 1, context);
-                if (! devicesFound)
-                {
-                    sources.clear();
-                    return false;
-                }
-
-                if (sources.back()->getDeviceType() != OnixDeviceType::POLLEDBNO)
-                {
-                    LOGE ("Unknown device encountered when configuring headstage ", NEUROPIXELSV2E_HEADSTAGE_NAME);
-                    devicesFound = false;
-                    sources.clear();
-                    return false;
-                }
-
-                const auto& polledBno = std::static_pointer_cast<PolledBno055> (sources.back());
-
-                polledBno->setBnoAxisMap (PolledBno055::Bno055AxisMap::YZX);
-                polledBno->setBnoAxisSign ((uint32_t) (PolledBno055::Bno055AxisSign::MirrorX) | (uint32_t) (PolledBno055::Bno055AxisSign::MirrorY));
-
-                hubNames.insert ({ OnixDevice::getOffset (polledBno->getDeviceIdx()), NEUROPIXELSV2E_HEADSTAGE_NAME });
-            }
-            else if (hsid == ONIX_HUB_HSNP1ET || hsid == ONIX_HUB_HSNP1EH)
-            {
-                auto hubIndex = OnixDevice::getHubIndexFromPassthroughIndex (index);
-
-                devicesFound = configureDevice<Neuropixels1e> (sources, editor, ProbeString, NEUROPIXELSV1E_HEADSTAGE_NAME, Neuropixels1e::getDeviceType(), hubIndex, context);
-                if (! devicesFound)
-                {
-                    sources.clear();
-                    return false;
-                }
-
-                devicesFound = configureDevice<PolledBno055> (sources, editor, OnixDevice::TypeString.at (PolledBno055::getDeviceType()), NEUROPIXELSV1E_HEADSTAGE_NAME, PolledBno055::getDeviceType(), hubIndex + 1, context);
-                if (! devicesFound)
-                {
-                    sources.clear();
-                    return false;
-                }
-
-                if (sources.back()->getDeviceType() != OnixDeviceType::POLLEDBNO)
-                {
-                    LOGE ("Unknown device encountered when setting headstage.");
-                    devicesFound = false;
-                    sources.clear();
-                    return false;
-                }
-
-                const auto& polledBno = std::static_pointer_cast<PolledBno055> (sources.back());
-
-                polledBno->setBnoAxisMap (PolledBno055::Bno055AxisMap::YZX);
-                polledBno->setBnoAxisSign ((uint32_t) (PolledBno055::Bno055AxisSign::MirrorX) | (uint32_t) (PolledBno055::Bno055AxisSign::MirrorZ));
-
-                hubNames.insert ({ OnixDevice::getOffset (polledBno->getDeviceIdx()), NEUROPIXELSV1E_HEADSTAGE_NAME });
-            }
-            else
-            {
-                Onix1::showWarningMessageBoxAsync (
-                    "Unknown Hub ID",
-                    "Discovered hub ID " + std::to_string (hsid) + " (" + onix_hub_str (hsid) + ") on " + OnixDevice::getPortName (OnixDevice::getHubIndexFromPassthroughIndex (index)) + " which does not match any currently implemented hubs.");
-                devicesFound = false;
-                sources.clear();
-                return false;
-            }
-        }
+    if (! devicesFound)
+    {
+        sources.clear();
+        return false;
     }
 
     context->issueReset();
@@ -561,6 +331,195 @@ void OnixSource::setBlockReadSize (uint32_t newReadSize)
     blockReadSize = newReadSize;
 }
 
+bool OnixSource::getAutoBlockReadSize() const
+{
+    return autoBlockReadSize;
+}
+
+void OnixSource::setAutoBlockReadSize (bool enable)
+{
+    if (enable != autoBlockReadSize)
+        blockReadSizeCalibrated = false;
+
+    autoBlockReadSize = enable;
+}
+
+double OnixSource::getTargetReadLatency() const
+{
+    return targetReadLatency;
+}
+
+void OnixSource::setTargetReadLatency (double latencyMilliseconds)
+{
+    latencyMilliseconds = std::clamp (latencyMilliseconds, 0.1, 100.0);
+
+    if (latencyMilliseconds != targetReadLatency)
+        blockReadSizeCalibrated = false;
+
+    targetReadLatency = latencyMilliseconds;
+}
+
+std::string OnixSource::getBlockReadSizeRationale() const
+{
+    return blockReadSizeRationale;
+}
+
+double OnixSource::estimateBytesPerSecond (uint32_t maxReadFrameSize) const
+{
+    double bytesPerSecond = 0.0;
+
+    for (const auto& source : sources)
+    {
+        if (! source->isEnabled())
+            continue;
+
+        auto it = deviceReadSizes.find (source->getDeviceIdx (true));
+        oni_size_t readSize = it != deviceReadSizes.end() ? it->second : maxReadFrameSize;
+
+        bytesPerSecond += source->getFramesPerSecond() * (Onix1::FrameHeaderSize + readSize);
+    }
+
+    return bytesPerSecond;
+}
+
+std::vector<std::pair<oni_dev_idx_t, double>> OnixSource::getEnabledDeviceRates() const
+{
+    std::vector<std::pair<oni_dev_idx_t, double>> rates;
+
+    for (const auto& source : sources)
+    {
+        if (source->isEnabled())
+            rates.emplace_back (source->getDeviceIdx (true), source->getFramesPerSecond());
+    }
+
+    return rates;
+}
+
+void OnixSource::updateAutoBlockReadSize()
+{
+    // NB: A calibration only holds for the devices and frame rates it was measured with
+    if (blockReadSizeCalibrated && getEnabledDeviceRates() != calibratedDeviceRates)
+        blockReadSizeCalibrated = false;
+
+    if (! autoBlockReadSize || blockReadSizeCalibrated || context == nullptr || ! context->isInitialized())
+        return;
+
+    oni_size_t maxReadFrameSize = 0;
+    if (context->getOption<oni_size_t> (ONI_OPT_MAXREADFRAMESIZE, &maxReadFrameSize) != ONI_ESUCCESS)
+    {
+        LOGE ("Unable to get read frame size. Keeping block read size of ", blockReadSize, " bytes.");
+        return;
+    }
+
+    blockReadSize = BlockReadSizeTuner::estimate (estimateBytesPerSecond (maxReadFrameSize), targetReadLatency * 1e-3, maxReadFrameSize, blockReadSizeRationale);
+
+    LOGC ("Automatic block read size: ", blockReadSize, " bytes. ", blockReadSizeRationale);
+}
+
+int OnixSource::getDecodeThreadCount() const
+{
+    return decodeThreadCount;
+}
+
+void OnixSource::setDecodeThreadCount (int count)
+{
+    decodeThreadCount = std::clamp (count, 0, DecodePool::MaxWorkers);
+}
+
+bool OnixSource::getDecodeInReaderThread() const
+{
+    return decodeInReaderThread;
+}
+
+void OnixSource::setDecodeInReaderThread (bool enable)
+{
+    decodeInReaderThread = enable;
+}
+
+bool OnixSource::getCaptureFrames() const
+{
+    return captureFrames;
+}
+
+void OnixSource::setCaptureFrames (bool enable)
+{
+    captureFrames = enable;
+}
+
+File OnixSource::getCaptureDirectory() const
+{
+    return captureDirectory;
+}
+
+void OnixSource::setCaptureDirectory (File directory)
+{
+    captureDirectory = directory;
+}
+
+bool OnixSource::getAdvanceSampleNumbersOnGaps() const
+{
+    return advanceSampleNumbersOnGaps;
+}
+
+void OnixSource::setAdvanceSampleNumbersOnGaps (bool enable)
+{
+    advanceSampleNumbersOnGaps = enable;
+}
+
+bool OnixSource::getTrackOffsetDrift() const
+{
+    return trackOffsetDrift;
+}
+
+void OnixSource::setTrackOffsetDrift (bool track)
+{
+    trackOffsetDrift = track;
+}
+
+bool OnixSource::getRecordTrace() const
+{
+    return recordTrace;
+}
+
+void OnixSource::setRecordTrace (bool enable)
+{
+    recordTrace = enable;
+
+    // NB: Recording starts immediately, so that port voltage discovery and probe configuration before
+    //     acquisition are part of the next trace
+    TraceRecorder::setEnabled (enable);
+}
+
+int OnixSource::getMetricsInterval() const
+{
+    return metricsInterval;
+}
+
+void OnixSource::setMetricsInterval (int seconds)
+{
+    metricsInterval = std::max (0, seconds);
+}
+
+MetricsLogger::Format OnixSource::getMetricsFormat() const
+{
+    return metricsFormat;
+}
+
+void OnixSource::setMetricsFormat (MetricsLogger::Format format)
+{
+    metricsFormat = format;
+}
+
+ThreadPolicy OnixSource::getThreadPolicy (AcquisitionThread thread) const
+{
+    return threadPolicies[(size_t) thread];
+}
+
+void OnixSource::setThreadPolicy (AcquisitionThread thread, ThreadPolicy policy)
+{
+    threadPolicies[(size_t) thread] = policy;
+}
+
 bool OnixSource::writeBlockReadSize (std::shared_ptr<Onix1> context, uint32_t blockReadSize, uint32_t readFrameSize)
 {
     if (context == nullptr || ! context->isInitialized())
@@ -1151,6 +1110,16 @@ bool OnixSource::isReady()
             return false;
     }
 
+    if (autoBlockReadSize)
+    {
+        // NB: Devices may have been enabled or disabled since connecting, and the block read size can only
+        //     be changed before acquisition starts
+        updateAutoBlockReadSize();
+
+        if (! configureBlockReadSize (context, blockReadSize))
+            return false;
+    }
+
     uint32_t val = 2;
     int rc = context->setOption (ONI_OPT_RESETACQCOUNTER, val);
     if (rc != ONI_ESUCCESS)
@@ -1161,7 +1130,10 @@ bool OnixSource::isReady()
 
 bool OnixSource::startAcquisition()
 {
+    AsyncLogger::start();
+
     frameReader.reset();
+    frameCapture.reset();
 
     enabledSources = getEnabledDataSources();
 
@@ -1170,17 +1142,167 @@ bool OnixSource::startAcquisition()
 
     for (const auto& source : enabledSources)
     {
+        source->allocateFrameQueue (blockReadSize);
+        source->setAdvanceSampleNumbersOnGaps (advanceSampleNumbersOnGaps);
+
+        if (source->getDeviceType() == OnixDeviceType::POLLEDBNO)
+            std::static_pointer_cast<PolledBno055> (source)->setThreadPolicy (getThreadPolicy (AcquisitionThread::PolledBno055));
+        else if (source->getDeviceType() == OnixDeviceType::NEUROPIXELSV1E || source->getDeviceType() == OnixDeviceType::NEUROPIXELSV1F)
+            std::static_pointer_cast<Neuropixels1> (source)->setTrackOffsetDrift (trackOffsetDrift);
+
         source->startAcquisition();
     }
 
-    frameReader = std::make_unique<FrameReader> (enabledSources, context);
+    decodePool.reset();
+
+    if (decodeInReaderThread)
+    {
+        LOGD ("Decoding frames in the frame reader thread");
+    }
+    else if (decodeThreadCount > 0)
+    {
+        decodePool = std::make_unique<DecodePool> (enabledSources, connectedDeviceTable, decodeThreadCount);
+        decodePool->setThreadPolicy (getThreadPolicy (AcquisitionThread::DecodeWorkers));
+        decodePool->startWorkers();
+
+        LOGD ("Decoding frames with ", decodePool->getNumWorkers(), " worker threads");
+    }
+
+    frameReader = std::make_unique<FrameReader> (enabledSources, FrameReader::createDispatchTable (enabledSources), context, decodeInReaderThread);
+    frameReader->setThreadPolicy (getThreadPolicy (AcquisitionThread::FrameReader));
+
+    if (autoBlockReadSize && ! blockReadSizeCalibrated)
+    {
+        // NB: Only devices that stream data are sampled, since the port controllers and the polled BNO055 queue
+        //     few or no frames, and a backlog in them says nothing about the block read size
+        OnixDeviceVector streamingSources;
+
+        for (const auto& source : enabledSources)
+        {
+            if (source->getFramesPerSecond() > 0.0)
+                streamingSources.emplace_back (source);
+        }
+
+        auto samplePeakQueueFraction = [streamingSources]
+        {
+            double peakQueueFraction = 0.0;
+
+            for (const auto& source : streamingSources)
+            {
+                if (source->getFrameQueueCapacity() > 0)
+                    peakQueueFraction = std::max (peakQueueFraction, (double) source->getFrameQueueHighWaterMark() / source->getFrameQueueCapacity());
+            }
+
+            return peakQueueFraction;
+        };
+
+        blockReadSizeTuner.startCalibration (blockReadSize, samplePeakQueueFraction);
+        frameReader->setBlockReadSizeTuner (&blockReadSizeTuner);
+    }
+
+    if (captureFrames)
+        startFrameCapture();
+
+    if (metricsInterval > 0)
+        startMetricsLog();
+
     frameReader->startThread();
 
+    dataThreadPolicyApplied = false;
+
     startThread();
 
     return true;
 }
 
+void OnixSource::startFrameCapture()
+{
+    auto file = captureDirectory.getChildFile ("onix_" + Time::getCurrentTime().formatted ("%Y-%m-%d_%H-%M-%S") + FrameCapture::FileExtension);
+
+    FrameCapture::HubInfo hubs;
+
+    for (const auto& [hubIndex, hubId] : context->getHubIds (connectedDeviceTable))
+    {
+        uint32_t firmwareVersion = 0;
+        DeviceDiscovery::getHubFirmwareVersion (context, hubIndex, &firmwareVersion);
+
+        hubs[hubIndex] = { (uint32_t) hubId, firmwareVersion };
+    }
+
+    oni_size_t acquisitionClockHz = 0;
+    context->getOption (ONI_OPT_ACQCLKHZ, &acquisitionClockHz);
+
+    frameCapture = std::make_unique<FrameCapture> (file);
+
+    if (! frameCapture->open (connectedDeviceTable, hubs, acquisitionClockHz))
+    {
+        Onix1::showWarningMessageBoxAsync ("Frame Capture Failed", "Unable to create the capture file " + file.getFullPathName().toStdString() + ". Acquisition will continue without capturing frames.");
+        frameCapture.reset();
+        return;
+    }
+
+    frameCapture->setThreadPolicy (getThreadPolicy (AcquisitionThread::FrameCapture));
+    frameCapture->startThread();
+
+    frameReader->setFrameCapture (frameCapture.get());
+
+    LOGC ("Capturing frames to ", file.getFullPathName());
+}
+
+void OnixSource::stopFrameCapture()
+{
+    frameCapture->close();
+
+    LOGC ("Captured ", frameCapture->getCapturedFrameCount(), " frames (", frameCapture->getBytesWritten(), " bytes) to ", frameCapture->getFile().getFullPathName());
+
+    if (frameCapture->hasFailed())
+        LOGE ("Capturing stopped early because the capture file could not be written. Dropped ", frameCapture->getDroppedFrameCount(), " frames from the capture.");
+    else if (frameCapture->getDroppedFrameCount() > 0)
+        LOGE ("Dropped ", frameCapture->getDroppedFrameCount(), " frames from the capture because the disk could not keep up.");
+}
+
+void OnixSource::startMetricsLog()
+{
+    metricsRegistry = std::make_unique<MetricsRegistry>();
+
+    frameReader->registerMetrics (*metricsRegistry);
+
+    for (const auto& source : enabledSources)
+        source->registerMetrics (*metricsRegistry);
+
+    auto extension = metricsFormat == MetricsLogger::Format::NdJson ? MetricsLogger::NdJsonFileExtension : MetricsLogger::CsvFileExtension;
+    auto file = CoreServices::getRecordingParentDirectory().getChildFile ("onix_metrics_" + Time::getCurrentTime().formatted ("%Y-%m-%d_%H-%M-%S") + extension);
+
+    metricsLogger = std::make_unique<MetricsLogger> (file, *metricsRegistry, std::chrono::seconds (metricsInterval));
+
+    if (! metricsLogger->open())
+    {
+        Onix1::showWarningMessageBoxAsync ("Metrics Log Failed", "Unable to create the metrics file " + file.getFullPathName().toStdString() + ". Acquisition will continue without a metrics log.");
+        metricsLogger.reset();
+        return;
+    }
+
+    metricsLogger->startThread (Thread::Priority::low);
+}
+
+void OnixSource::stopMetricsLog()
+{
+    metricsLogger->close();
+
+    LOGC ("Wrote ", metricsLogger->getSnapshotCount(), " metrics snapshots to ", metricsLogger->getFile().getFullPathName());
+
+    metricsLogger.reset();
+    metricsRegistry.reset();
+}
+
+void OnixSource::writeTrace()
+{
+    auto file = captureDirectory.getChildFile ("onix_trace_" + Time::getCurrentTime().formatted ("%Y-%m-%d_%H-%M-%S") + TraceRecorder::FileExtension);
+
+    if (! TraceRecorder::writeTrace (file))
+        Onix1::showWarningMessageBoxAsync ("Trace Failed", "Unable to write the trace file " + file.getFullPathName().toStdString() + ".");
+}
+
 void OnixSource::disconnectDevicesAfterAcquisition (OnixSourceEditor* editor)
 {
     while (CoreServices::getAcquisitionStatus())
@@ -1201,17 +1323,75 @@ bool OnixSource::stopAcquisition()
     if (frameReader->isThreadRunning())
         frameReader->signalThreadShouldExit();
 
+    frameReader->wakeWaitingThread();
+
     if (! portA->getErrorFlag() && ! portB->getErrorFlag())
         waitForThreadToExit (2000);
 
+    // NB: Stopping the hardware makes a blocked read return, so the frame reader is joined without a timeout.
+    //     In low-latency mode it also decodes into the DataBuffers, and it copies frames into the capture, so
+    //     it must have exited before the frame queues are drained and the buffers are cleared below.
     oni_size_t reg = 0;
     context->setOption (ONI_OPT_RUNNING, reg);
 
+    frameReader->waitForThreadToExit (-1);
+
+    if (decodePool != nullptr)
+        decodePool->stopWorkers();
+
+    if (frameCapture != nullptr)
+        stopFrameCapture();
+
+    // NB: Closed before the devices stop, so that the last snapshot has the final counts of this acquisition
+    if (metricsLogger != nullptr)
+        stopMetricsLog();
+
+    // NB: Stopped once the acquisition threads have exited, so that their messages are written before the summary below
+    AsyncLogger::stop();
+
+    if (frameReader->getUnknownFrameCount() > 0)
+    {
+        LOGE ("Dropped ", frameReader->getUnknownFrameCount(), " frames with no matching device. Last unknown device index was ", frameReader->getLastUnknownIndex(), ".");
+    }
+
     for (const auto& source : enabledSources)
     {
         source->stopAcquisition();
+
+        LOGD (source->getName(), " frame queue high-water mark: ", source->getFrameQueueHighWaterMark(), " of ", source->getFrameQueueCapacity(), " frames");
+
+        if (source->getFrameQueueOverflowCount() > 0)
+            LOGE ("Dropped ", source->getFrameQueueOverflowCount(), " frames from ", source->getName(), " because its frame queue was full.");
+
+        if (source->getGapCount() > 0)
+            LOGE ("Found ", source->getGapCount(), " gaps in the clock of ", source->getName(), ", with ", source->getMissingFrameCount(), " frames missing.");
+
+        const auto& latencyProbe = source->getLatencyProbe();
+
+        for (int i = 0; i < (int) LatencyProbe::Stage::Count; i++)
+        {
+            auto stage = (LatencyProbe::Stage) i;
+
+            if (latencyProbe.getHistogram (stage).getCount() > 0)
+                LOGC (source->getName(), " latency from ", LatencyProbe::getStageName (stage), ": ", latencyProbe.getHistogram (stage).getSummary());
+        }
+    }
+
+    if (autoBlockReadSize && ! blockReadSizeCalibrated && blockReadSizeTuner.isCalibrationComplete())
+    {
+        oni_size_t maxReadFrameSize = 0;
+        context->getOption<oni_size_t> (ONI_OPT_MAXREADFRAMESIZE, &maxReadFrameSize);
+
+        blockReadSize = blockReadSizeTuner.refine (targetReadLatency * 1e-3, maxReadFrameSize, blockReadSizeRationale);
+        blockReadSizeCalibrated = true;
+        calibratedDeviceRates = getEnabledDeviceRates();
+
+        LOGC ("Calibrated block read size: ", blockReadSize, " bytes, applied from the next acquisition. ", blockReadSizeRationale);
     }
 
+    if (recordTrace)
+        writeTrace();
+
     for (auto buffers : sourceBuffers)
         buffers->clear();
 
@@ -1339,9 +1519,32 @@ void OnixSource::startRecording()
 
 bool OnixSource::updateBuffer()
 {
+    if (! dataThreadPolicyApplied)
+    {
+        LOGC (ThreadPolicy::getThreadName (AcquisitionThread::DataThread), " thread policy: ", getThreadPolicy (AcquisitionThread::DataThread).applyToCurrentThread());
+        dataThreadPolicyApplied = true;
+    }
+
+    // NB: Ask the reader, since the decodeInReaderThread setting can be changed from the editor during acquisition
+    if (frameReader->isDecodingInReaderThread())
+    {
+        // NB: Devices are decoded by the FrameReader; this thread only monitors the port controllers
+        std::this_thread::sleep_for (FrameWaitTimeout);
+        return ! portA->getErrorFlag() && ! portB->getErrorFlag();
+    }
+
+    if (! frameReader->waitForFrames (FrameWaitTimeout))
+        return ! portA->getErrorFlag() && ! portB->getErrorFlag();
+
+    if (decodePool != nullptr)
+    {
+        decodePool->notify();
+        return ! portA->getErrorFlag() && ! portB->getErrorFlag();
+    }
+
     for (const auto& source : enabledSources)
     {
-        source->processFrames();
+        source->processQueuedFrames();
 
         if (threadShouldExit())
             return true;
@@ -24,12 +24,17 @@
 
 #include <DataThreadHeaders.h>
 
+#include "BlockReadSizeTuner.h"
+#include "DecodePool.h"
 #include "Devices/PortController.h"
 #include "Formats/ProbeInterface.h"
+#include "FrameCapture.h"
 #include "FrameReader.h"
+#include "MetricsLogger.h"
 #include "Onix1.h"
 #include "OnixDevice.h"
 #include "OnixSourceEditor.h"
+#include "ThreadPolicy.h"
 
 #define PLUGIN_NAME "ONIX Source"
 
@@ -95,14 +100,10 @@ public:
 
     bool getDeviceTable (device_map_t*);
 
-    static bool enablePassthroughMode (std::shared_ptr<Onix1>, bool, bool);
-
     bool configurePort (PortName);
     bool resetPortLinkFlags();
     bool resetPortLinkFlags (PortName);
 
-    static bool checkHubFirmwareCompatibility (std::shared_ptr<Onix1>, device_map_t);
-
     bool initializeDevices (device_map_t, bool updateStreamInfo = false);
 
     static bool configureBlockReadSize (std::shared_ptr<Onix1>, uint32_t);
@@ -136,6 +137,76 @@ public:
 
     void setBlockReadSize (uint32_t);
 
+    /** Returns true if the block read size is chosen automatically from the enabled devices and the target latency */
+    bool getAutoBlockReadSize() const;
+
+    void setAutoBlockReadSize (bool);
+
+    /** Returns the target read latency, in milliseconds, used when the block read size is chosen automatically */
+    double getTargetReadLatency() const;
+
+    void setTargetReadLatency (double);
+
+    /** Returns a description of how the current automatic block read size was chosen */
+    std::string getBlockReadSizeRationale() const;
+
+    /** Recomputes the automatic block read size from the enabled devices, unless it has already been refined by
+        a calibration run with the same devices and frame rates. Does nothing if the block read size is not
+        automatic. */
+    void updateAutoBlockReadSize();
+
+    /** Returns the number of decode worker threads. Zero means all devices are decoded on the DataThread. */
+    int getDecodeThreadCount() const;
+
+    void setDecodeThreadCount (int);
+
+    /** Returns true if frames are decoded by the FrameReader as soon as they are read (low-latency mode),
+        bypassing the DataThread and any decode workers */
+    bool getDecodeInReaderThread() const;
+
+    void setDecodeInReaderThread (bool);
+
+    /** Returns true if every frame read during acquisition is copied to a capture file */
+    bool getCaptureFrames() const;
+
+    void setCaptureFrames (bool);
+
+    /** Returns the directory where a new capture file is created each time acquisition starts */
+    File getCaptureDirectory() const;
+
+    void setCaptureDirectory (File);
+
+    /** Returns true if trace events from the acquisition pipeline are recorded, and written to a trace file in
+        the capture directory each time acquisition stops */
+    bool getRecordTrace() const;
+
+    void setRecordTrace (bool);
+
+    /** Returns true if sample numbers skip over frames found missing from the device clocks during acquisition */
+    bool getAdvanceSampleNumbersOnGaps() const;
+
+    void setAdvanceSampleNumbersOnGaps (bool);
+
+    /** Returns true if the channel offsets of Neuropixels 1.0 probes keep following slow drift after they are
+        first calculated */
+    bool getTrackOffsetDrift() const;
+
+    void setTrackOffsetDrift (bool);
+
+    /** Returns the number of seconds between metrics snapshots written during acquisition. Zero disables the
+        metrics log. */
+    int getMetricsInterval() const;
+
+    void setMetricsInterval (int);
+
+    MetricsLogger::Format getMetricsFormat() const;
+
+    void setMetricsFormat (MetricsLogger::Format);
+
+    ThreadPolicy getThreadPolicy (AcquisitionThread) const;
+
+    void setThreadPolicy (AcquisitionThread, ThreadPolicy);
+
     static bool checkPortControllerStatus (OnixSourceEditor* editor, std::shared_ptr<PortController> port);
 
 private:
@@ -152,6 +223,9 @@ private:
     /** Thread that reads frames */
     std::unique_ptr<FrameReader> frameReader;
 
+    /** Optional worker threads that decode frames in parallel */
+    std::unique_ptr<DecodePool> decodePool;
+
     std::shared_ptr<Onix1> context = nullptr;
 
     std::shared_ptr<PortController> portA;
@@ -159,21 +233,97 @@ private:
 
     uint32_t blockReadSize = 4096;
 
+    bool autoBlockReadSize = false;
+
+    double targetReadLatency = BlockReadSizeTuner::DefaultTargetLatencyMilliseconds;
+
+    std::string blockReadSizeRationale;
+
+    BlockReadSizeTuner blockReadSizeTuner;
+
+    /** Set once the automatic block read size has been refined from a calibration run */
+    bool blockReadSizeCalibrated = false;
+
+    /** Device index and frame rate of each device that was enabled during the calibration run */
+    std::vector<std::pair<oni_dev_idx_t, double>> calibratedDeviceRates;
+
+    /** Size in bytes of the frames read from each device, from the device table */
+    std::map<oni_dev_idx_t, oni_size_t> deviceReadSizes;
+
+    /** Returns the number of bytes per second that the enabled devices are expected to produce */
+    double estimateBytesPerSecond (uint32_t maxReadFrameSize) const;
+
+    /** Returns the device index and frame rate of each enabled device */
+    std::vector<std::pair<oni_dev_idx_t, double>> getEnabledDeviceRates() const;
+
+    int decodeThreadCount = 0;
+
+    bool decodeInReaderThread = false;
+
+    std::array<ThreadPolicy, (size_t) AcquisitionThread::Count> threadPolicies;
+
+    bool captureFrames = false;
+
+    File captureDirectory = File::getSpecialLocation (File::userDocumentsDirectory).getChildFile ("ONIX Captures");
+
+    /** Writes a copy of every frame read to disk, if frame capture is enabled */
+    std::unique_ptr<FrameCapture> frameCapture;
+
+    /** Device table of the connected hardware, written to the header of each capture file */
+    device_map_t connectedDeviceTable;
+
+    /** Creates a capture file for this acquisition and attaches it to the frame reader. Acquisition
+        continues without a capture if the file cannot be created. */
+    void startFrameCapture();
+
+    /** Closes the capture file and logs a summary. Must be called after the frame reader has stopped. */
+    void stopFrameCapture();
+
+    bool recordTrace = false;
+
+    /** Writes the trace events recorded since the last trace file to a new file in the capture directory */
+    void writeTrace();
+
+    bool advanceSampleNumbersOnGaps = false;
+
+    bool trackOffsetDrift = false;
+
+    int metricsInterval = 0;
+
+    MetricsLogger::Format metricsFormat = MetricsLogger::Format::Csv;
+
+    /** Counters and gauges of the frame reader and every enabled device, rebuilt for each acquisition */
+    std::unique_ptr<MetricsRegistry> metricsRegistry;
+
+    /** Writes periodic snapshots of metricsRegistry, if the metrics log is enabled */
+    std::unique_ptr<MetricsLogger> metricsLogger;
+
+    /** Creates a metrics file next to the recording directory and starts writing snapshots to it. Acquisition
+        continues without a metrics log if the file cannot be created. */
+    void startMetricsLog();
+
+    /** Writes a final snapshot and closes the metrics file */
+    void stopMetricsLog();
+
+    /** Set once the DataThread policy has been applied from within updateBuffer */
+    bool dataThreadPolicyApplied = false;
+
     bool devicesFound = false;
 
     static constexpr int BREAKOUT_BOARD_OFFSET = 0;
 
+    /** Maximum time that updateBuffer waits for new frames before returning, so thread exit requests are seen */
+    static constexpr std::chrono::microseconds FrameWaitTimeout { 10000 };
+
     void addIndividualStreams (Array<StreamInfo>, OwnedArray<DataStream>*, OwnedArray<DeviceInfo>*, OwnedArray<ContinuousChannel>*);
 
     void addCombinedStreams (DataStream::Settings, Array<StreamInfo>, OwnedArray<DataStream>*, OwnedArray<DeviceInfo>*, OwnedArray<ContinuousChannel>*);
 
     std::string createContinuousChannelIdentifier (StreamInfo streamInfo, int channelNumber);
 
-    /** Template method to initialize an OnixDevice and add it to the currently active OnixDeviceVector variable */
-    template <class Device>
-    static bool configureDevice (OnixDeviceVector&, OnixSourceEditor*, std::string, std::string, OnixDeviceType, const oni_dev_idx_t, std::shared_ptr<Onix1>);
-
-    static bool getHubFirmwareVersion (std::shared_ptr<Onix1>, uint32_t, uint32_t*);
+    /** Returns the device from the settings tab at the given index, to be configured by DeviceDiscovery, or
+        nullptr after telling the user why it could not be found */
+    static std::shared_ptr<OnixDevice> getConfigurableDevice (OnixSourceEditor*, OnixDeviceType, std::string, std::string, const oni_dev_idx_t, std::shared_ptr<Onix1>);
 
     static bool writeBlockReadSize (std::shared_ptr<Onix1>, uint32_t, uint32_t);
 
@@ -33,10 +33,27 @@ OnixSourceCanvas::OnixSourceCanvas (GenericProcessor* processor_, OnixSourceEdit
       editor (editor_),
       source (onixSource_)
 {
+    performancePanel = std::make_unique<PerformancePanel> (source);
+
     topLevelTabComponent = std::make_unique<CustomTabComponent> (true);
     addAndMakeVisible (topLevelTabComponent.get());
 
     addHub (BREAKOUT_BOARD_NAME, 0);
+    updatePerformanceTab();
+}
+
+void OnixSourceCanvas::updatePerformanceTab()
+{
+    for (int i = 0; i < topLevelTabComponent->getNumTabs(); i++)
+    {
+        if (topLevelTabComponent->getTabContentComponent (i) == performancePanel.get())
+        {
+            topLevelTabComponent->moveTab (i, topLevelTabComponent->getNumTabs() - 1);
+            return;
+        }
+    }
+
+    topLevelTabComponent->addTab ("Performance", Colours::grey, performancePanel.get(), false);
 }
 
 CustomTabComponent* OnixSourceCanvas::addTopLevelTab (std::string tabName, int index)
@@ -48,6 +65,8 @@ CustomTabComponent* OnixSourceCanvas::addTopLevelTab (std::string tabName, int i
 
     hubTabs.add (tab);
 
+    updatePerformanceTab();
+
     return tab;
 }
 
@@ -263,6 +282,8 @@ void OnixSourceCanvas::removeAllTabs()
     settingsInterfaces.clear();
 
     topLevelTabComponent->clearTabs();
+
+    updatePerformanceTab();
 }
 
 OnixDeviceMap OnixSourceCanvas::getSelectedDevices (std::vector<std::shared_ptr<SettingsInterface>> interfaces)
@@ -366,6 +387,8 @@ void OnixSourceCanvas::startAcquisition()
     {
         settingsInterface->startAcquisition();
     }
+
+    performancePanel->startAcquisition();
 }
 
 void OnixSourceCanvas::stopAcquisition()
@@ -374,6 +397,8 @@ void OnixSourceCanvas::stopAcquisition()
     {
         settingsInterface->stopAcquisition();
     }
+
+    performancePanel->stopAcquisition();
 }
 
 void OnixSourceCanvas::saveCustomParametersToXml (XmlElement* xml)
@@ -26,6 +26,7 @@
 
 #include "UI/CustomTabComponent.h"
 #include "UI/InterfaceList.h"
+#include "UI/PerformancePanel.h"
 
 namespace OnixSourcePlugin
 {
@@ -103,11 +104,17 @@ private:
     OnixSourceEditor* editor;
     OnixSource* source;
 
+    /** Shown in the last top-level tab, and owned here so it survives clearing the hub tabs */
+    std::unique_ptr<PerformancePanel> performancePanel;
+
     std::unique_ptr<CustomTabComponent> topLevelTabComponent;
     OwnedArray<CustomTabComponent> hubTabs;
 
     CustomTabComponent* addTopLevelTab (std::string tabName, int index = -1);
 
+    /** Adds the performance tab if needed, and keeps it after all hub tabs so hub tab indices match their port */
+    void updatePerformanceTab();
+
     void addInterfaceToTab (std::string tabName, CustomTabComponent* tab, std::shared_ptr<SettingsInterface> interface_);
 
     std::string getTopLevelTabName (PortName port, std::string headstage);
@@ -22,9 +22,11 @@
 
 #include "OnixSourceEditor.h"
 
+#include "DeviceDiscovery.h"
 #include "Devices/MemoryMonitor.h"
 #include "OnixSource.h"
 #include "OnixSourceCanvas.h"
+#include "UI/AcquisitionSettingsComponent.h"
 
 using namespace OnixSourcePlugin;
 
@@ -45,7 +47,7 @@ OnixSourceEditor::OnixSourceEditor (GenericProcessor* parentNode, OnixSource* so
     blockReadSizeValue->setFont (fontOptionRegular);
     blockReadSizeValue->setEditable (true);
     blockReadSizeValue->setColour (Label::textColourId, Colours::black);
-    blockReadSizeValue->setTooltip ("Number of bytes read per cycle of the acquisition thread. Smaller values provide lower latency, but can cause the memory monitor to fill up. Larger values may improve processing performance for high-bandwidth data sources.");
+    blockReadSizeValue->setTooltip (BlockReadSizeTooltip);
     blockReadSizeValue->addListener (this);
     blockReadSizeValue->setBorderSize (BorderSize<int> (1));
     blockReadSizeValue->setJustificationType (Justification::centred);
@@ -146,6 +148,14 @@ OnixSourceEditor::OnixSourceEditor (GenericProcessor* parentNode, OnixSource* so
     connectButton->addListener (this);
     addAndMakeVisible (connectButton.get());
 
+    acquisitionSettingsButton = std::make_unique<UtilityButton> ("OPTIONS");
+    acquisitionSettingsButton->setFont (fontOptionRegular);
+    acquisitionSettingsButton->setBounds (connectButton->getRight() + 4, connectButton->getY(), 48, connectButton->getHeight());
+    acquisitionSettingsButton->setRadius (3.0f);
+    acquisitionSettingsButton->setTooltip ("Press to change acquisition settings, such as the number of decode threads");
+    acquisitionSettingsButton->addListener (this);
+    addAndMakeVisible (acquisitionSettingsButton.get());
+
     const int liboniWidth = 90;
 
     liboniVersionLabel = std::make_unique<Label> ("liboniVersion", "liboni: v" + Onix1::getVersion());
@@ -223,8 +233,8 @@ void OnixSourceEditor::labelTextChanged (Label* l)
     {
         auto readSize = l->getText().getIntValue();
 
-        const int32_t minReadSize = 512;
-        const int32_t maxReadSize = 20e3;
+        const int32_t minReadSize = BlockReadSizeTuner::MinBlockReadSize;
+        const int32_t maxReadSize = BlockReadSizeTuner::MaxBlockReadSize;
 
         if (readSize < minReadSize)
         {
@@ -250,6 +260,10 @@ void OnixSourceEditor::buttonClicked (Button* b)
     {
         setConnectedStatus (connectButton->getToggleState());
     }
+    else if (b == acquisitionSettingsButton.get())
+    {
+        CallOutBox::launchAsynchronously (std::make_unique<AcquisitionSettingsComponent> (source, this), acquisitionSettingsButton->getScreenBounds(), nullptr);
+    }
 }
 
 void OnixSourceEditor::setConnectedStatus (bool connected)
@@ -365,7 +379,7 @@ bool OnixSourceEditor::configureAllDevices()
     if (source->foundInputSource() && ! source->disconnectDevices (false))
         return false;
 
-    if (! OnixSource::enablePassthroughMode (source->getContext(), source->getParameter ("passthroughA")->getValue(), source->getParameter ("passthroughB")->getValue()))
+    if (! DeviceDiscovery::enablePassthroughMode (source->getContext(), source->getParameter ("passthroughA")->getValue(), source->getParameter ("passthroughB")->getValue()))
     {
         Onix1::showWarningMessageBoxAsync ("Passthrough Configuration Error", "Unable to set passthrough mode. Check logs for more details.");
         return false;
@@ -378,7 +392,7 @@ bool OnixSourceEditor::configureAllDevices()
         return false;
     }
 
-    if (! OnixSource::checkHubFirmwareCompatibility (source->getContext(), deviceTable))
+    if (! DeviceDiscovery::checkHubFirmwareCompatibility (source->getContext(), deviceTable))
         return false;
 
     if (! source->initializeDevices (deviceTable, false) || ! canvas->verifyHeadstageSelection())
@@ -387,6 +401,9 @@ bool OnixSourceEditor::configureAllDevices()
         return false;
     }
 
+    source->updateAutoBlockReadSize();
+    updateBlockReadSizeValue();
+
     if (! source->configureBlockReadSize (source->getContext(), blockReadSizeValue->getText().getIntValue()))
     {
         connectButton->setToggleState (false, sendNotification);
@@ -405,6 +422,19 @@ void OnixSourceEditor::enableEditorElements (bool enable)
     blockReadSizeValue->setEnabled (enable);
 }
 
+void OnixSourceEditor::updateBlockReadSizeValue()
+{
+    const bool isAutomatic = source->getAutoBlockReadSize();
+
+    blockReadSizeValue->setText (String (source->getBlockReadSize()), dontSendNotification);
+    blockReadSizeValue->setEditable (! isAutomatic);
+
+    if (isAutomatic && ! source->getBlockReadSizeRationale().empty())
+        blockReadSizeValue->setTooltip ("Automatic block read size. " + source->getBlockReadSizeRationale() + ".");
+    else
+        blockReadSizeValue->setTooltip (BlockReadSizeTooltip);
+}
+
 void OnixSourceEditor::comboBoxChanged (ComboBox* cb)
 {
     if (cb == headstageComboBoxA.get())
@@ -502,6 +532,7 @@ void OnixSourceEditor::updateSettings()
 void OnixSourceEditor::setInterfaceEnabledState (bool newState)
 {
     connectButton->setEnabled (newState);
+    acquisitionSettingsButton->setEnabled (newState);
 
     portVoltageValueA->setEnabled (newState);
     portVoltageValueB->setEnabled (newState);
@@ -510,6 +541,7 @@ void OnixSourceEditor::setInterfaceEnabledState (bool newState)
 void OnixSourceEditor::startAcquisition()
 {
     setInterfaceEnabledState (false);
+    updateBlockReadSizeValue();
 
     for (const auto& source : source->getDataSources())
     {
@@ -528,6 +560,7 @@ void OnixSourceEditor::startAcquisition()
 void OnixSourceEditor::stopAcquisition()
 {
     setInterfaceEnabledState (true);
+    updateBlockReadSizeValue();
 
     for (const auto& source : source->getDataSources())
     {
@@ -694,6 +727,28 @@ void OnixSourceEditor::saveVisualizerEditorParameters (XmlElement* xml)
     xml->setAttribute ("portVoltageB", portVoltageValueB->getText());
 
     xml->setAttribute ("blockReadSize", String (source->getBlockReadSize()));
+    xml->setAttribute ("autoBlockReadSize", source->getAutoBlockReadSize());
+    xml->setAttribute ("targetReadLatency", source->getTargetReadLatency());
+    xml->setAttribute ("decodeThreads", source->getDecodeThreadCount());
+    xml->setAttribute ("decodeInReaderThread", source->getDecodeInReaderThread());
+    xml->setAttribute ("captureFrames", source->getCaptureFrames());
+    xml->setAttribute ("captureDirectory", source->getCaptureDirectory().getFullPathName());
+    xml->setAttribute ("recordTrace", source->getRecordTrace());
+    xml->setAttribute ("advanceSampleNumbersOnGaps", source->getAdvanceSampleNumbersOnGaps());
+    xml->setAttribute ("trackOffsetDrift", source->getTrackOffsetDrift());
+    xml->setAttribute ("metricsInterval", source->getMetricsInterval());
+    xml->setAttribute ("metricsFormat", (int) source->getMetricsFormat());
+
+    for (int i = 0; i < (int) AcquisitionThread::Count; i++)
+    {
+        auto policy = source->getThreadPolicy ((AcquisitionThread) i);
+
+        auto threadXml = xml->createNewChildElement ("THREAD_POLICY");
+        threadXml->setAttribute ("thread", i);
+        threadXml->setAttribute ("core", policy.core);
+        threadXml->setAttribute ("scheduling", (int) policy.scheduling);
+        threadXml->setAttribute ("priority", policy.priority);
+    }
 }
 
 void OnixSourceEditor::loadVisualizerEditorParameters (XmlElement* xml)
@@ -722,4 +777,57 @@ void OnixSourceEditor::loadVisualizerEditorParameters (XmlElement* xml)
 
     if (xml->hasAttribute ("blockReadSize"))
         blockReadSizeValue->setText (xml->getStringAttribute ("blockReadSize"), sendNotification);
+
+    if (xml->hasAttribute ("autoBlockReadSize"))
+        source->setAutoBlockReadSize (xml->getBoolAttribute ("autoBlockReadSize"));
+
+    if (xml->hasAttribute ("targetReadLatency"))
+        source->setTargetReadLatency (xml->getDoubleAttribute ("targetReadLatency"));
+
+    updateBlockReadSizeValue();
+
+    if (xml->hasAttribute ("decodeThreads"))
+        source->setDecodeThreadCount (xml->getIntAttribute ("decodeThreads"));
+
+    if (xml->hasAttribute ("decodeInReaderThread"))
+        source->setDecodeInReaderThread (xml->getBoolAttribute ("decodeInReaderThread"));
+
+    if (xml->hasAttribute ("captureFrames"))
+        source->setCaptureFrames (xml->getBoolAttribute ("captureFrames"));
+
+    if (xml->hasAttribute ("captureDirectory"))
+        source->setCaptureDirectory (File (xml->getStringAttribute ("captureDirectory")));
+
+    if (xml->hasAttribute ("recordTrace"))
+        source->setRecordTrace (xml->getBoolAttribute ("recordTrace"));
+
+    if (xml->hasAttribute ("advanceSampleNumbersOnGaps"))
+        source->setAdvanceSampleNumbersOnGaps (xml->getBoolAttribute ("advanceSampleNumbersOnGaps"));
+
+    if (xml->hasAttribute ("trackOffsetDrift"))
+        source->setTrackOffsetDrift (xml->getBoolAttribute ("trackOffsetDrift"));
+
+    if (xml->hasAttribute ("metricsInterval"))
+        source->setMetricsInterval (xml->getIntAttribute ("metricsInterval"));
+
+    if (xml->hasAttribute ("metricsFormat"))
+        source->setMetricsFormat ((MetricsLogger::Format) xml->getIntAttribute ("metricsFormat"));
+
+    for (auto* threadXml : xml->getChildIterator())
+    {
+        if (! threadXml->hasTagName ("THREAD_POLICY"))
+            continue;
+
+        int thread = threadXml->getIntAttribute ("thread", -1);
+
+        if (thread < 0 || thread >= (int) AcquisitionThread::Count)
+            continue;
+
+        ThreadPolicy policy;
+        policy.core = threadXml->getIntAttribute ("core", -1);
+        policy.scheduling = (ThreadScheduling) std::clamp (threadXml->getIntAttribute ("scheduling", 0), (int) ThreadScheduling::Default, (int) ThreadScheduling::RoundRobin);
+        policy.priority = std::clamp (threadXml->getIntAttribute ("priority", ThreadPolicy::DefaultPriority), ThreadPolicy::MinPriority, ThreadPolicy::MaxPriority);
+
+        source->setThreadPolicy ((AcquisitionThread) thread, policy);
+    }
 }
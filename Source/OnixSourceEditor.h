@@ -74,6 +74,9 @@ public:
 
     void setConnectedStatus (bool);
 
+    /** Shows the current block read size, and whether it can be edited, based on the automatic block read size setting */
+    void updateBlockReadSizeValue();
+
 private:
     OnixSourceCanvas* canvas;
     OnixSource* source;
@@ -106,6 +109,8 @@ private:
 
     std::unique_ptr<UtilityButton> connectButton;
 
+    std::unique_ptr<UtilityButton> acquisitionSettingsButton;
+
     std::unique_ptr<Label> liboniVersionLabel;
 
     std::unique_ptr<Label> blankEditor;
@@ -123,7 +128,9 @@ private:
 
     static constexpr int DefaultBlockReadSize = 4096;
 
-    static constexpr char* missingCanvasErrorMessage = "The canvas for this plugin could not be found. Some functionality may not work as expected, and you may not be able to acquire or record data. Try removing and replacing the plugin.";
+    static constexpr auto BlockReadSizeTooltip = "Number of bytes read per cycle of the acquisition thread. Smaller values provide lower latency, but can cause the memory monitor to fill up. Larger values may improve processing performance for high-bandwidth data sources.";
+
+    static constexpr const char* missingCanvasErrorMessage = "The canvas for this plugin could not be found. Some functionality may not work as expected, and you may not be able to acquire or record data. Try removing and replacing the plugin.";
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OnixSourceEditor);
 };
@@ -0,0 +1,122 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SampleTile.h"
+#include "CpuFeatures.h"
+
+#if ONIX_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+void transposeChannels (const float* tile, int numChannels, int numColumns, int firstChannel, float* destination, int stride)
+{
+    for (int channel = firstChannel; channel < numChannels; channel++)
+    {
+        for (int column = 0; column < numColumns; column++)
+            destination[channel * stride + column] = tile[column * numChannels + channel];
+    }
+}
+
+void transposeScalar (const float* tile, int numChannels, int numColumns, float* destination, int stride)
+{
+    const int blockChannels = numChannels & ~3;
+
+    for (int channel = 0; channel < blockChannels; channel += 4)
+    {
+        float* rows = destination + channel * stride;
+
+        for (int column = 0; column < numColumns; column++)
+        {
+            // NB: All four samples are loaded before any is stored, so that the compiler need not reload them in
+            //     case the stores alias the tile
+            const float* source = tile + column * numChannels + channel;
+            const float sample0 = source[0], sample1 = source[1], sample2 = source[2], sample3 = source[3];
+
+            rows[column] = sample0;
+            rows[stride + column] = sample1;
+            rows[2 * stride + column] = sample2;
+            rows[3 * stride + column] = sample3;
+        }
+    }
+
+    transposeChannels (tile, numChannels, numColumns, blockChannels, destination, stride);
+}
+
+#if ONIX_X86
+
+ONIX_TARGET ("sse4.1")
+void transposeSse41 (const float* tile, int numChannels, int numColumns, float* destination, int stride)
+{
+    const int blockChannels = numChannels & ~3;
+    const int blockColumns = numColumns & ~3;
+
+    for (int channel = 0; channel < blockChannels; channel += 4)
+    {
+        float* rows = destination + channel * stride;
+
+        for (int column = 0; column < blockColumns; column += 4)
+        {
+            const float* source = tile + column * numChannels + channel;
+
+            __m128 row0 = _mm_loadu_ps (source);
+            __m128 row1 = _mm_loadu_ps (source + numChannels);
+            __m128 row2 = _mm_loadu_ps (source + 2 * numChannels);
+            __m128 row3 = _mm_loadu_ps (source + 3 * numChannels);
+
+            _MM_TRANSPOSE4_PS (row0, row1, row2, row3);
+
+            _mm_storeu_ps (rows + column, row0);
+            _mm_storeu_ps (rows + stride + column, row1);
+            _mm_storeu_ps (rows + 2 * stride + column, row2);
+            _mm_storeu_ps (rows + 3 * stride + column, row3);
+        }
+
+        for (int column = blockColumns; column < numColumns; column++)
+        {
+            alignas (16) float samples[4];
+            _mm_store_ps (samples, _mm_loadu_ps (tile + column * numChannels + channel));
+
+            for (int i = 0; i < 4; i++)
+                rows[i * stride + column] = samples[i];
+        }
+    }
+
+    transposeChannels (tile, numChannels, numColumns, blockChannels, destination, stride);
+}
+
+#endif
+} // namespace
+
+void OnixSourcePlugin::transposeSamples (const float* tile, int numChannels, int numColumns, float* destination, int stride)
+{
+#if ONIX_X86
+    if (CpuFeatures::getInstructionSet() >= InstructionSet::Sse41)
+    {
+        transposeSse41 (tile, numChannels, numColumns, destination, stride);
+        return;
+    }
+#endif
+
+    transposeScalar (tile, numChannels, numColumns, destination, stride);
+}
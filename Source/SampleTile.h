@@ -0,0 +1,62 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <array>
+
+namespace OnixSourcePlugin
+{
+/** Copies numColumns rows of numChannels samples from tile into destination, where the row of channel c starts
+    at c * stride */
+void transposeSamples (const float* tile, int numChannels, int numColumns, float* destination, int stride);
+
+/**
+
+    Sample-major staging for the channel-major sample arrays that DataBuffer::addToBuffer expects.
+
+    Decoders scatter the samples of one time point across every channel. Written straight into a channel-major
+    array, each sample lands on a different cache line. Written into a column of the tile instead, they fill a
+    few contiguous cache lines. When the tile is full, transposeInto() moves it into the channel-major array in
+    blocks of four channels by four columns, using SSE where the CPU supports it. The transpose still writes every
+    row of the channel-major array, so a tile only pays off where that array stays in cache, as the ten
+    superframes of a Neuropixels 2.0e probe do.
+
+*/
+template <int NumChannels, int NumColumns>
+class SampleTile
+{
+public:
+    /** Returns the samples of a column, in which channel c is at index c */
+    float* getColumn (int column) { return samples.data() + column * NumChannels; }
+
+    /** Copies every column into destination, where the row of channel c starts at c * stride, and each column
+        follows the one before it */
+    void transposeInto (float* destination, int stride) const
+    {
+        transposeSamples (samples.data(), NumChannels, NumColumns, destination, stride);
+    }
+
+private:
+    std::array<float, NumChannels * NumColumns> samples {};
+};
+} // namespace OnixSourcePlugin
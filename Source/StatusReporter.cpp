@@ -0,0 +1,59 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "StatusReporter.h"
+
+#include <DataThreadHeaders.h>
+
+using namespace OnixSourcePlugin;
+
+void ProgressTask::setProgress (double newProgress)
+{
+    progress = newProgress;
+
+    if (progressListener)
+        progressListener (newProgress);
+}
+
+void LogStatusReporter::showWarning (std::string title, std::string message)
+{
+    LOGE (title, ": ", message);
+}
+
+void LogStatusReporter::showStatus (std::string message)
+{
+    LOGC (message);
+}
+
+void LogStatusReporter::requestStopAcquisition()
+{
+    stopRequested = true;
+}
+
+void LogStatusReporter::runTask (ProgressTask& task)
+{
+    LOGC (task.getTitle(), "...");
+
+    task.run();
+
+    LOGD (task.getTitle(), " finished with progress ", task.getProgress());
+}
@@ -0,0 +1,109 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace OnixSourcePlugin
+{
+/**
+
+    A long-running step, such as writing probe settings or searching for a port voltage, that reports its
+    progress while it runs. How the progress is shown depends on the StatusReporter that runs it.
+
+*/
+class ProgressTask
+{
+public:
+    explicit ProgressTask (std::string title_) : title (title_) {}
+
+    virtual ~ProgressTask() = default;
+
+    /** Performs the task. Called by StatusReporter::runTask, possibly on a different thread than the caller */
+    virtual void run() = 0;
+
+    std::string getTitle() const { return title; }
+
+    double getProgress() const { return progress.load(); }
+
+    /** Sets a function that is called each time the progress changes, or clears it if the function is empty */
+    void setProgressListener (std::function<void (double)> listener) { progressListener = listener; }
+
+protected:
+    /** Updates the progress of the task, from 0.0 to 1.0 */
+    void setProgress (double newProgress);
+
+private:
+    const std::string title;
+
+    std::atomic<double> progress = 0.0;
+
+    std::function<void (double)> progressListener;
+};
+
+/**
+
+    Receives the warnings, status messages, and progress produced by the devices and the acquisition threads.
+    The plugin shows them in the GUI, while headless tools log them, so nothing below OnixSource depends on
+    how they are presented.
+
+*/
+class StatusReporter
+{
+public:
+    virtual ~StatusReporter() = default;
+
+    /** Reports a problem that the user needs to see, such as a missing calibration file */
+    virtual void showWarning (std::string title, std::string message) = 0;
+
+    /** Reports a short message about the state of acquisition */
+    virtual void showStatus (std::string message) = 0;
+
+    /** Called from an acquisition thread when acquisition cannot continue, such as after a failed read */
+    virtual void requestStopAcquisition() = 0;
+
+    /** Runs the task, and returns once it has finished */
+    virtual void runTask (ProgressTask& task) = 0;
+};
+
+/** Writes everything to the log, and runs tasks on the calling thread. Used when there is no GUI. */
+class LogStatusReporter : public StatusReporter
+{
+public:
+    void showWarning (std::string title, std::string message) override;
+    void showStatus (std::string message) override;
+    void requestStopAcquisition() override;
+    void runTask (ProgressTask& task) override;
+
+    /** Returns true once requestStopAcquisition has been called, until clearStopRequest is called */
+    bool isStopRequested() const { return stopRequested.load(); }
+
+    void clearStopRequest() { stopRequested = false; }
+
+private:
+    std::atomic<bool> stopRequested = false;
+};
+} // namespace OnixSourcePlugin
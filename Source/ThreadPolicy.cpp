@@ -0,0 +1,146 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ThreadPolicy.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include <DataThreadHeaders.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace OnixSourcePlugin;
+
+std::string ThreadPolicy::getThreadName (AcquisitionThread thread)
+{
+    switch (thread)
+    {
+        case AcquisitionThread::FrameReader:
+            return "Frame reader";
+        case AcquisitionThread::DataThread:
+            return "Data thread";
+        case AcquisitionThread::PolledBno055:
+            return "Polled BNO055";
+        case AcquisitionThread::FrameCapture:
+            return "Frame capture";
+        case AcquisitionThread::DecodeWorkers:
+            return "Decode workers";
+        default:
+            return "Unknown thread";
+    }
+}
+
+std::string ThreadPolicy::getSchedulingName (ThreadScheduling scheduling)
+{
+    switch (scheduling)
+    {
+        case ThreadScheduling::Fifo:
+            return "SCHED_FIFO";
+        case ThreadScheduling::RoundRobin:
+            return "SCHED_RR";
+        default:
+            return "default";
+    }
+}
+
+ThreadPolicy ThreadPolicy::forGroupMember (int index) const
+{
+    ThreadPolicy policy = *this;
+
+    if (core >= 0)
+        policy.core = core + index;
+
+    return policy;
+}
+
+std::string ThreadPolicy::applyToCurrentThread() const
+{
+    std::string applied;
+
+    const int numCores = (int) std::thread::hardware_concurrency();
+
+    if (core < 0)
+    {
+        applied += "any core";
+    }
+    else if (numCores > 0 && core >= numCores)
+    {
+        applied += "any core (core " + std::to_string (core) + " does not exist)";
+    }
+    else
+    {
+#ifdef __linux__
+        cpu_set_t cpuSet;
+        CPU_ZERO (&cpuSet);
+        CPU_SET (core, &cpuSet);
+
+        int rc = pthread_setaffinity_np (pthread_self(), sizeof (cpuSet), &cpuSet);
+
+        if (rc == 0)
+            applied += "core " + std::to_string (core);
+        else
+            applied += "any core (pinning to core " + std::to_string (core) + " was refused: " + std::strerror (rc) + ")";
+#else
+        if (core < 32)
+        {
+            Thread::setCurrentThreadAffinityMask (1u << core);
+            applied += "core " + std::to_string (core);
+        }
+        else
+        {
+            applied += "any core (core " + std::to_string (core) + " cannot be set on this platform)";
+        }
+#endif
+    }
+
+    applied += ", ";
+
+    if (scheduling == ThreadScheduling::Default)
+    {
+        applied += "default scheduling";
+    }
+    else
+    {
+#ifdef __linux__
+        const int policy = scheduling == ThreadScheduling::Fifo ? SCHED_FIFO : SCHED_RR;
+
+        sched_param param;
+        param.sched_priority = std::clamp (priority, sched_get_priority_min (policy), sched_get_priority_max (policy));
+
+        int rc = pthread_setschedparam (pthread_self(), policy, &param);
+
+        if (rc == 0)
+            applied += getSchedulingName (scheduling) + " priority " + std::to_string (param.sched_priority);
+        else
+            applied += "default scheduling (" + getSchedulingName (scheduling) + " was refused: " + std::strerror (rc) + ")";
+#else
+        applied += "default scheduling (" + getSchedulingName (scheduling) + " is only available on Linux)";
+#endif
+    }
+
+    return applied;
+}
@@ -0,0 +1,78 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <string>
+
+namespace OnixSourcePlugin
+{
+/** Threads that take part in acquisition, and whose placement can be configured */
+enum class AcquisitionThread : int
+{
+    FrameReader = 0,
+    DataThread,
+    PolledBno055,
+    FrameCapture,
+    DecodeWorkers,
+    Count
+};
+
+enum class ThreadScheduling : int
+{
+    Default = 0,
+    Fifo,
+    RoundRobin
+};
+
+/**
+
+    CPU affinity and scheduling policy for one of the acquisition threads
+
+*/
+struct ThreadPolicy
+{
+    /** Core that the thread is pinned to, or -1 to let the OS schedule it on any core */
+    int core = -1;
+
+    /** Real-time scheduling policy. Only honoured on Linux, and only if the process is allowed to use it. */
+    ThreadScheduling scheduling = ThreadScheduling::Default;
+
+    /** Real-time priority used with ThreadScheduling::Fifo or ThreadScheduling::RoundRobin */
+    int priority = DefaultPriority;
+
+    /** Applies this policy to the calling thread. Requests refused by the OS are skipped, and the
+        returned string describes what was actually applied. */
+    std::string applyToCurrentThread() const;
+
+    /** Returns the policy for one thread of a group that shares this policy. If a core is set, the thread
+        at the given index is pinned to the core that many places after it, so each thread has its own core. */
+    ThreadPolicy forGroupMember (int index) const;
+
+    static std::string getThreadName (AcquisitionThread thread);
+    static std::string getSchedulingName (ThreadScheduling scheduling);
+
+    static constexpr int DefaultPriority = 50;
+    static constexpr int MinPriority = 1;
+    static constexpr int MaxPriority = 99;
+};
+} // namespace OnixSourcePlugin
@@ -0,0 +1,275 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+using namespace OnixSourcePlugin;
+
+namespace
+{
+/** Single-producer ring of events, written by its thread and read by writeTrace */
+struct ThreadBuffer
+{
+    std::unique_ptr<TraceEvent[]> events { new TraceEvent[TraceRecorder::EventsPerThread] };
+
+    std::atomic<uint64_t> written = 0;
+    std::atomic<uint64_t> consumed = 0;
+    std::atomic<uint64_t> dropped = 0;
+
+    /** Cleared when the owning thread exits, so that the buffer can be reused by a new thread */
+    std::atomic<bool> inUse = true;
+
+    /** Only changed while the registry lock is held */
+    uint64_t threadId = 0;
+    std::string threadName;
+};
+
+struct Registry
+{
+    std::mutex lock;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::set<std::string> strings;
+    uint64_t nextThreadId = 1;
+};
+
+Registry& getRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+ThreadBuffer* claimBuffer()
+{
+    auto thread = Thread::getCurrentThread();
+    auto threadName = thread != nullptr ? thread->getThreadName().toStdString() : std::string ("Message thread");
+
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock (registry.lock);
+
+    ThreadBuffer* buffer = nullptr;
+
+    // NB: Threads are recreated for each acquisition, so buffers from threads that have exited are reused once
+    //     all of their events have been written
+    for (const auto& candidate : registry.buffers)
+    {
+        if (! candidate->inUse.load (std::memory_order_acquire) && candidate->consumed.load() == candidate->written.load())
+        {
+            buffer = candidate.get();
+            buffer->inUse.store (true);
+            break;
+        }
+    }
+
+    if (buffer == nullptr)
+        buffer = registry.buffers.emplace_back (std::make_unique<ThreadBuffer>()).get();
+
+    buffer->threadId = registry.nextThreadId++;
+    buffer->threadName = threadName;
+
+    return buffer;
+}
+
+struct ThreadBufferHandle
+{
+    ThreadBuffer* buffer = nullptr;
+
+    ~ThreadBufferHandle()
+    {
+        if (buffer != nullptr)
+            buffer->inUse.store (false, std::memory_order_release);
+    }
+};
+
+thread_local ThreadBufferHandle currentBuffer;
+
+std::string escape (const std::string& text)
+{
+    std::string escaped;
+
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+
+        escaped += (unsigned char) c < 0x20 ? ' ' : c;
+    }
+
+    return escaped;
+}
+
+struct ThreadEvents
+{
+    uint64_t threadId;
+    std::string threadName;
+    std::vector<TraceEvent> events;
+};
+} // namespace
+
+void TraceRecorder::setEnabled (bool enable)
+{
+    enabled.store (enable, std::memory_order_relaxed);
+}
+
+void TraceRecorder::record (const TraceEvent& event)
+{
+    auto buffer = currentBuffer.buffer;
+
+    if (buffer == nullptr)
+        buffer = currentBuffer.buffer = claimBuffer();
+
+    const uint64_t index = buffer->written.load (std::memory_order_relaxed);
+
+    if (index - buffer->consumed.load (std::memory_order_acquire) >= EventsPerThread)
+    {
+        buffer->dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[index % EventsPerThread] = event;
+    buffer->written.store (index + 1, std::memory_order_release);
+}
+
+bool TraceRecorder::writeTrace (const File& file)
+{
+    std::vector<ThreadEvents> threads;
+    uint64_t droppedEvents = 0;
+
+    {
+        auto& registry = getRegistry();
+        std::lock_guard<std::mutex> lock (registry.lock);
+
+        for (const auto& buffer : registry.buffers)
+        {
+            const uint64_t begin = buffer->consumed.load (std::memory_order_relaxed);
+            const uint64_t end = buffer->written.load (std::memory_order_acquire);
+
+            droppedEvents += buffer->dropped.exchange (0, std::memory_order_relaxed);
+
+            if (begin == end)
+                continue;
+
+            ThreadEvents thread { buffer->threadId, buffer->threadName, {} };
+            thread.events.reserve (end - begin);
+
+            for (uint64_t i = begin; i < end; i++)
+                thread.events.push_back (buffer->events[i % EventsPerThread]);
+
+            buffer->consumed.store (end, std::memory_order_release);
+
+            threads.push_back (std::move (thread));
+        }
+    }
+
+    if (file.getParentDirectory().createDirectory().failed())
+    {
+        LOGE ("Unable to create the trace directory ", file.getParentDirectory().getFullPathName());
+        return false;
+    }
+
+    FileOutputStream stream (file);
+
+    if (stream.failedToOpen() || ! stream.setPosition (0) || ! stream.truncate().wasOk())
+    {
+        LOGE ("Unable to open the trace file ", file.getFullPathName(), ": ", stream.getStatus().getErrorMessage());
+        return false;
+    }
+
+    // NB: Times are written in microseconds relative to the first event, which is the unit of the trace-event format
+    int64_t origin = std::numeric_limits<int64_t>::max();
+    size_t numEvents = 0;
+
+    for (const auto& thread : threads)
+    {
+        for (const auto& event : thread.events)
+            origin = std::min (origin, event.start);
+
+        numEvents += thread.events.size();
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+                       "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"ONIX Source\"}}";
+
+    char numbers[64];
+
+    for (const auto& thread : threads)
+    {
+        const auto threadId = std::to_string (thread.threadId);
+
+        json += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + threadId
+                + ",\"args\":{\"name\":\"" + escape (thread.threadName) + "\"}}";
+
+        for (const auto& event : thread.events)
+        {
+            json += ",\n{\"name\":\"" + escape (event.name) + "\",\"cat\":\"" + event.category + "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + threadId;
+
+            std::snprintf (numbers, sizeof (numbers), ",\"ts\":%.3f,\"dur\":%.3f", (event.start - origin) * 1e-3, event.duration * 1e-3);
+            json += numbers;
+
+            if (event.argumentName != nullptr)
+            {
+                std::snprintf (numbers, sizeof (numbers), "%.17g", event.argumentValue);
+                json += ",\"args\":{\"" + std::string (event.argumentName) + "\":" + numbers + "}";
+            }
+
+            json += "}";
+        }
+
+        if (json.size() > (1 << 20))
+        {
+            stream.write (json.data(), json.size());
+            json.clear();
+        }
+    }
+
+    json += "\n]}\n";
+    stream.write (json.data(), json.size());
+    stream.flush();
+
+    if (stream.getStatus().failed())
+    {
+        LOGE ("Unable to write the trace file ", file.getFullPathName(), ": ", stream.getStatus().getErrorMessage());
+        return false;
+    }
+
+    LOGC ("Wrote ", numEvents, " trace events from ", threads.size(), " threads to ", file.getFullPathName());
+
+    if (droppedEvents > 0)
+        LOGE ("Dropped ", droppedEvents, " trace events because a thread recorded more than ", EventsPerThread, " events before the trace was written.");
+
+    return true;
+}
+
+const char* TraceRecorder::intern (const std::string& text)
+{
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock (registry.lock);
+
+    return registry.strings.insert (text).first->c_str();
+}
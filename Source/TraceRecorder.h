@@ -0,0 +1,128 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <DataThreadHeaders.h>
+
+#include "LatencyProbe.h"
+
+namespace OnixSourcePlugin
+{
+/** A span of time on one thread, with an optional numeric argument */
+struct TraceEvent
+{
+    const char* name;
+    const char* category;
+
+    /** Host monotonic time at which the span began, from LatencyProbe::now() */
+    int64_t start;
+    int64_t duration;
+
+    /** Name of the argument, or nullptr if the event has none */
+    const char* argumentName;
+    double argumentValue;
+};
+
+/**
+
+    Records spans of time from the acquisition pipeline, and writes them as a Chrome trace-event JSON file that
+    can be opened in ui.perfetto.dev or chrome://tracing.
+
+    Each thread records to its own fixed-size buffer without taking a lock; a lock is only taken the first time a
+    thread records an event, to register its buffer. If a thread fills its buffer before the trace is written,
+    later events from that thread are dropped and counted.
+
+    Recording is process-wide and disabled by default. While disabled, a TraceScope only costs a relaxed atomic
+    load. Event names, categories and argument names are stored as pointers, so they must be string literals or
+    come from intern().
+
+*/
+class TraceRecorder
+{
+public:
+    static bool isEnabled() { return enabled.load (std::memory_order_relaxed); }
+
+    static void setEnabled (bool);
+
+    /** Adds an event to the buffer of the calling thread */
+    static void record (const TraceEvent& event);
+
+    /** Writes every event recorded since the last call to the given file, and removes them from the buffers.
+        Can be called while other threads are recording. Returns false if the file could not be written. */
+    static bool writeTrace (const File& file);
+
+    /** Returns a copy of the string that remains valid for the lifetime of the process */
+    static const char* intern (const std::string& text);
+
+    static constexpr size_t EventsPerThread = 1 << 18;
+
+    static constexpr auto FileExtension = ".json";
+
+private:
+    static inline std::atomic<bool> enabled = false;
+};
+
+/**
+
+    Records a TraceEvent covering its own lifetime, if the TraceRecorder was enabled when it was created
+
+*/
+class TraceScope
+{
+public:
+    TraceScope (const char* name_, const char* category_, const char* argumentName_ = nullptr, double argumentValue_ = 0.0)
+        : name (name_), category (category_), argumentName (argumentName_), argumentValue (argumentValue_), active (TraceRecorder::isEnabled())
+    {
+        if (active)
+            start = LatencyProbe::now();
+    }
+
+    ~TraceScope()
+    {
+        if (active)
+            TraceRecorder::record ({ name, category, start, LatencyProbe::now() - start, argumentName, argumentValue });
+    }
+
+    /** Sets the argument once it is known, such as the number of frames that were read */
+    void setArgument (const char* argumentName_, double argumentValue_)
+    {
+        argumentName = argumentName_;
+        argumentValue = argumentValue_;
+    }
+
+private:
+    const char* name;
+    const char* category;
+    const char* argumentName;
+    double argumentValue;
+
+    const bool active;
+    int64_t start = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (TraceScope);
+};
+} // namespace OnixSourcePlugin
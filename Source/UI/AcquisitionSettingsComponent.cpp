@@ -0,0 +1,353 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "AcquisitionSettingsComponent.h"
+
+#include <thread>
+
+#include "../DecodePool.h"
+#include "../OnixSource.h"
+#include "../OnixSourceEditor.h"
+
+using namespace OnixSourcePlugin;
+
+AcquisitionSettingsComponent::AcquisitionSettingsComponent (OnixSource* source_, OnixSourceEditor* editor_)
+    : source (source_), editor (editor_)
+{
+    FontOptions fontOptionRegular = FontOptions ("Fira Code", 12.0f, Font::plain);
+
+    autoBlockReadSizeButton = std::make_unique<ToggleButton> ("Automatic block read size");
+    autoBlockReadSizeButton->setBounds (5, 5, LabelWidth + ValueWidth, RowHeight);
+    autoBlockReadSizeButton->setClickingTogglesState (true);
+    autoBlockReadSizeButton->setToggleState (source->getAutoBlockReadSize(), dontSendNotification);
+    autoBlockReadSizeButton->setTooltip ("If checked, the block read size is estimated from the data rate of the enabled devices so that a block is filled once per target latency. The estimate is refined during the first " + String (BlockReadSizeTuner::CalibrationSeconds) + " seconds of acquisition, and the refined size is used from the next acquisition onwards.");
+    autoBlockReadSizeButton->addListener (this);
+    addAndMakeVisible (autoBlockReadSizeButton.get());
+
+    targetLatencyLabel = std::make_unique<Label> ("targetLatencyLabel", "Target latency [ms]");
+    targetLatencyLabel->setBounds (autoBlockReadSizeButton->getX(), autoBlockReadSizeButton->getBottom() + RowSpacing, LabelWidth, RowHeight);
+    targetLatencyLabel->setFont (fontOptionRegular);
+    addAndMakeVisible (targetLatencyLabel.get());
+
+    targetLatencyValue = std::make_unique<Label> ("targetLatencyValue", String (source->getTargetReadLatency()));
+    targetLatencyValue->setBounds (targetLatencyLabel->getRight() + 3, targetLatencyLabel->getY(), ValueWidth, RowHeight);
+    targetLatencyValue->setFont (fontOptionRegular);
+    targetLatencyValue->setEditable (true);
+    targetLatencyValue->setColour (Label::textColourId, Colours::black);
+    targetLatencyValue->setColour (Label::backgroundColourId, Colours::lightgrey);
+    targetLatencyValue->setJustificationType (Justification::centred);
+    targetLatencyValue->setTooltip ("Time to fill one block with data from the enabled devices. Lower values reduce latency, higher values reduce the number of reads per second.");
+    targetLatencyValue->setEnabled (source->getAutoBlockReadSize());
+    targetLatencyValue->addListener (this);
+    addAndMakeVisible (targetLatencyValue.get());
+
+    blockReadSizeRationaleLabel = std::make_unique<Label> ("blockReadSizeRationaleLabel", "");
+    blockReadSizeRationaleLabel->setBounds (targetLatencyLabel->getX(), targetLatencyLabel->getBottom() + RowSpacing, LabelWidth + ValueWidth * 2, RowHeight * 2);
+    blockReadSizeRationaleLabel->setFont (FontOptions ("Fira Code", 10.0f, Font::plain));
+    blockReadSizeRationaleLabel->setJustificationType (Justification::topLeft);
+    addAndMakeVisible (blockReadSizeRationaleLabel.get());
+
+    decodeThreadsLabel = std::make_unique<Label> ("decodeThreadsLabel", "Decode threads");
+    decodeThreadsLabel->setBounds (5, blockReadSizeRationaleLabel->getBottom() + RowSpacing * 2, LabelWidth, RowHeight);
+    decodeThreadsLabel->setFont (fontOptionRegular);
+    addAndMakeVisible (decodeThreadsLabel.get());
+
+    decodeThreadsComboBox = std::make_unique<ComboBox> ("decodeThreadsComboBox");
+    decodeThreadsComboBox->setBounds (decodeThreadsLabel->getRight() + 3, decodeThreadsLabel->getY(), ValueWidth, RowHeight);
+    decodeThreadsComboBox->addItem ("Off", 1);
+
+    for (int i = 1; i <= DecodePool::MaxWorkers; i++)
+        decodeThreadsComboBox->addItem (String (i), i + 1);
+
+    decodeThreadsComboBox->setSelectedId (source->getDecodeThreadCount() + 1, dontSendNotification);
+    decodeThreadsComboBox->setTooltip ("Number of worker threads used to decode frames. When off, all devices are decoded sequentially on the acquisition thread. Each device is always decoded by a single worker, so frame order is preserved.");
+    decodeThreadsComboBox->addListener (this);
+    addAndMakeVisible (decodeThreadsComboBox.get());
+
+    lowLatencyButton = std::make_unique<ToggleButton> ("Decode in reader thread (low latency)");
+    lowLatencyButton->setBounds (decodeThreadsLabel->getX(), decodeThreadsLabel->getBottom() + RowSpacing, LabelWidth + ValueWidth, RowHeight);
+    lowLatencyButton->setClickingTogglesState (true);
+    lowLatencyButton->setToggleState (source->getDecodeInReaderThread(), dontSendNotification);
+    lowLatencyButton->setTooltip ("If checked, frames are decoded on the thread that reads them from hardware, as soon as they are read. This removes a thread hand-off for closed-loop experiments, at the cost of total throughput. Decode threads are not used in this mode.");
+    lowLatencyButton->addListener (this);
+    addAndMakeVisible (lowLatencyButton.get());
+
+    decodeThreadsComboBox->setEnabled (! source->getDecodeInReaderThread());
+
+    captureFramesButton = std::make_unique<ToggleButton> ("Capture raw frames to disk");
+    captureFramesButton->setBounds (decodeThreadsLabel->getX(), lowLatencyButton->getBottom() + RowSpacing * 2, LabelWidth + ValueWidth, RowHeight);
+    captureFramesButton->setClickingTogglesState (true);
+    captureFramesButton->setToggleState (source->getCaptureFrames(), dontSendNotification);
+    captureFramesButton->setTooltip ("If checked, every frame read from the hardware is written to a new capture file each time acquisition starts, along with the device table and hub firmware versions. Frames are written by a separate thread, so a slow disk drops frames from the capture instead of stalling acquisition.");
+    captureFramesButton->addListener (this);
+    addAndMakeVisible (captureFramesButton.get());
+
+    captureDirectoryValue = std::make_unique<Label> ("captureDirectoryValue", source->getCaptureDirectory().getFullPathName());
+    captureDirectoryValue->setBounds (captureFramesButton->getX(), captureFramesButton->getBottom() + RowSpacing, LabelWidth + ValueWidth * 2 - 29, RowHeight);
+    captureDirectoryValue->setFont (FontOptions ("Fira Code", 10.0f, Font::plain));
+    captureDirectoryValue->setColour (Label::textColourId, Colours::black);
+    captureDirectoryValue->setColour (Label::backgroundColourId, Colours::lightgrey);
+    captureDirectoryValue->setMinimumHorizontalScale (1.0f);
+    captureDirectoryValue->setTooltip ("Directory where capture and trace files are created");
+    addAndMakeVisible (captureDirectoryValue.get());
+
+    captureDirectoryButton = std::make_unique<UtilityButton> ("...");
+    captureDirectoryButton->setBounds (captureDirectoryValue->getRight() + 3, captureDirectoryValue->getY(), 26, RowHeight);
+    captureDirectoryButton->setRadius (1.0f);
+    captureDirectoryButton->setTooltip ("Open a file dialog to choose the directory where capture files are created.");
+    captureDirectoryButton->addListener (this);
+    addAndMakeVisible (captureDirectoryButton.get());
+
+    captureDirectoryChooser = std::make_unique<FileChooser> ("Select Capture Directory.", source->getCaptureDirectory());
+
+    recordTraceButton = std::make_unique<ToggleButton> ("Record a trace of the acquisition threads");
+    recordTraceButton->setBounds (decodeThreadsLabel->getX(), captureDirectoryValue->getBottom() + RowSpacing, LabelWidth + ValueWidth * 2, RowHeight);
+    recordTraceButton->setClickingTogglesState (true);
+    recordTraceButton->setToggleState (source->getRecordTrace(), dontSendNotification);
+    recordTraceButton->setTooltip ("If checked, reads, decoding, buffer writes, probe configuration and port voltage discovery are timed on each thread, and written to a trace file in the capture directory each time acquisition stops. Open the file in ui.perfetto.dev or chrome://tracing to see the timeline.");
+    recordTraceButton->addListener (this);
+    addAndMakeVisible (recordTraceButton.get());
+
+    metricsIntervalLabel = std::make_unique<Label> ("metricsIntervalLabel", "Metrics interval [s]");
+    metricsIntervalLabel->setBounds (decodeThreadsLabel->getX(), recordTraceButton->getBottom() + RowSpacing * 2, LabelWidth, RowHeight);
+    metricsIntervalLabel->setFont (fontOptionRegular);
+    addAndMakeVisible (metricsIntervalLabel.get());
+
+    metricsIntervalValue = std::make_unique<Label> ("metricsIntervalValue", String (source->getMetricsInterval()));
+    metricsIntervalValue->setBounds (metricsIntervalLabel->getRight() + 3, metricsIntervalLabel->getY(), ValueWidth, RowHeight);
+    metricsIntervalValue->setFont (fontOptionRegular);
+    metricsIntervalValue->setEditable (true);
+    metricsIntervalValue->setColour (Label::textColourId, Colours::black);
+    metricsIntervalValue->setColour (Label::backgroundColourId, Colours::lightgrey);
+    metricsIntervalValue->setJustificationType (Justification::centred);
+    metricsIntervalValue->setTooltip ("Seconds between snapshots of frame counts, dropped frames, queue depths, decode time, memory use and port link flags, which are appended to a metrics file next to the recording directory during acquisition. Set to 0 to disable the metrics log.");
+    metricsIntervalValue->addListener (this);
+    addAndMakeVisible (metricsIntervalValue.get());
+
+    metricsFormatComboBox = std::make_unique<ComboBox> ("metricsFormatComboBox");
+    metricsFormatComboBox->setBounds (metricsIntervalValue->getRight() + 3, metricsIntervalLabel->getY(), ValueWidth, RowHeight);
+    metricsFormatComboBox->addItem ("CSV", (int) MetricsLogger::Format::Csv + 1);
+    metricsFormatComboBox->addItem ("NDJSON", (int) MetricsLogger::Format::NdJson + 1);
+    metricsFormatComboBox->setSelectedId ((int) source->getMetricsFormat() + 1, dontSendNotification);
+    metricsFormatComboBox->setTooltip ("Format of the metrics file: one CSV row, or one JSON object per line, for each snapshot.");
+    metricsFormatComboBox->addListener (this);
+    addAndMakeVisible (metricsFormatComboBox.get());
+
+    advanceSampleNumbersButton = std::make_unique<ToggleButton> ("Advance sample numbers over missing frames");
+    advanceSampleNumbersButton->setBounds (decodeThreadsLabel->getX(), metricsIntervalLabel->getBottom() + RowSpacing, LabelWidth + ValueWidth * 2, RowHeight);
+    advanceSampleNumbersButton->setClickingTogglesState (true);
+    advanceSampleNumbersButton->setToggleState (source->getAdvanceSampleNumbersOnGaps(), dontSendNotification);
+    advanceSampleNumbersButton->setTooltip ("Gaps in the clocks of Neuropixels, analog and digital IO frames are always counted and logged when acquisition stops. If checked, sample numbers also skip over the missing frames, so that they stay in step with the timestamps.");
+    advanceSampleNumbersButton->addListener (this);
+    addAndMakeVisible (advanceSampleNumbersButton.get());
+
+    trackOffsetDriftButton = std::make_unique<ToggleButton> ("Track Neuropixels 1.0 offset drift");
+    trackOffsetDriftButton->setBounds (decodeThreadsLabel->getX(), advanceSampleNumbersButton->getBottom() + RowSpacing, LabelWidth + ValueWidth * 2, RowHeight);
+    trackOffsetDriftButton->setClickingTogglesState (true);
+    trackOffsetDriftButton->setToggleState (source->getTrackOffsetDrift(), dontSendNotification);
+    trackOffsetDriftButton->setTooltip ("The offset of each Neuropixels 1.0 channel is averaged once the probe has settled, and subtracted from its samples. If checked, the offsets then keep following slow drift with a one minute time constant, for long sessions.");
+    trackOffsetDriftButton->addListener (this);
+    addAndMakeVisible (trackOffsetDriftButton.get());
+
+    threadPolicyLabel = std::make_unique<Label> ("threadPolicyLabel", "Thread core / scheduling / priority");
+    threadPolicyLabel->setBounds (decodeThreadsLabel->getX(), trackOffsetDriftButton->getBottom() + RowSpacing * 2, LabelWidth + ValueWidth * 2, RowHeight);
+    threadPolicyLabel->setFont (fontOptionRegular);
+    addAndMakeVisible (threadPolicyLabel.get());
+
+    const int numCores = (int) std::thread::hardware_concurrency();
+
+    int rowY = threadPolicyLabel->getBottom() + RowSpacing;
+
+    for (int i = 0; i < (int) AcquisitionThread::Count; i++)
+    {
+        auto thread = (AcquisitionThread) i;
+        auto policy = source->getThreadPolicy (thread);
+        auto& controls = threadPolicyControls[i];
+
+        controls.nameLabel = std::make_unique<Label> ("threadName" + String (i), ThreadPolicy::getThreadName (thread));
+        controls.nameLabel->setBounds (decodeThreadsLabel->getX(), rowY, LabelWidth, RowHeight);
+        controls.nameLabel->setFont (fontOptionRegular);
+        addAndMakeVisible (controls.nameLabel.get());
+
+        controls.coreComboBox = std::make_unique<ComboBox> ("threadCore" + String (i));
+        controls.coreComboBox->setBounds (controls.nameLabel->getRight() + 3, rowY, ValueWidth, RowHeight);
+        controls.coreComboBox->addItem ("Any core", 1);
+
+        for (int core = 0; core < numCores; core++)
+            controls.coreComboBox->addItem ("Core " + String (core), core + 2);
+
+        controls.coreComboBox->setSelectedId (policy.core + 2, dontSendNotification);
+        controls.coreComboBox->setTooltip ("Pins this thread to a single CPU core. Pick cores that are not used by the user interface or recording threads.");
+
+        if (thread == AcquisitionThread::DecodeWorkers)
+            controls.coreComboBox->setTooltip ("Pins the first decode worker to this core, and each further worker to the next core, so every worker has a core of its own.");
+        controls.coreComboBox->addListener (this);
+        addAndMakeVisible (controls.coreComboBox.get());
+
+        controls.schedulingComboBox = std::make_unique<ComboBox> ("threadScheduling" + String (i));
+        controls.schedulingComboBox->setBounds (controls.coreComboBox->getRight() + 3, rowY, ValueWidth, RowHeight);
+        controls.schedulingComboBox->addItem ("Default", (int) ThreadScheduling::Default + 1);
+        controls.schedulingComboBox->addItem ("FIFO", (int) ThreadScheduling::Fifo + 1);
+        controls.schedulingComboBox->addItem ("Round robin", (int) ThreadScheduling::RoundRobin + 1);
+        controls.schedulingComboBox->setSelectedId ((int) policy.scheduling + 1, dontSendNotification);
+        controls.schedulingComboBox->setTooltip ("Requests SCHED_FIFO or SCHED_RR real-time scheduling on Linux. If the request is refused, the thread keeps the default scheduling and the reason is logged when acquisition starts.");
+        controls.schedulingComboBox->addListener (this);
+        addAndMakeVisible (controls.schedulingComboBox.get());
+
+        controls.priorityValue = std::make_unique<Label> ("threadPriority" + String (i), String (policy.priority));
+        controls.priorityValue->setBounds (controls.schedulingComboBox->getRight() + 3, rowY, PriorityWidth, RowHeight);
+        controls.priorityValue->setFont (fontOptionRegular);
+        controls.priorityValue->setEditable (true);
+        controls.priorityValue->setColour (Label::textColourId, Colours::black);
+        controls.priorityValue->setColour (Label::backgroundColourId, Colours::lightgrey);
+        controls.priorityValue->setJustificationType (Justification::centred);
+        controls.priorityValue->setTooltip ("Real-time priority, from " + String (ThreadPolicy::MinPriority) + " to " + String (ThreadPolicy::MaxPriority) + ". Only used with FIFO or round robin scheduling.");
+        controls.priorityValue->addListener (this);
+        addAndMakeVisible (controls.priorityValue.get());
+
+        rowY = controls.nameLabel->getBottom() + RowSpacing;
+    }
+
+    auto& lastControls = threadPolicyControls.back();
+
+    setSize (lastControls.priorityValue->getRight() + 5, lastControls.priorityValue->getBottom() + 5);
+
+    updateBlockReadSize();
+}
+
+void AcquisitionSettingsComponent::updateBlockReadSize()
+{
+    source->setAutoBlockReadSize (autoBlockReadSizeButton->getToggleState());
+    source->setTargetReadLatency (targetLatencyValue->getText().getDoubleValue());
+    source->updateAutoBlockReadSize();
+
+    targetLatencyValue->setEnabled (source->getAutoBlockReadSize());
+    targetLatencyValue->setText (String (source->getTargetReadLatency()), dontSendNotification);
+
+    if (source->getAutoBlockReadSize())
+        blockReadSizeRationaleLabel->setText (String (source->getBlockReadSize()) + " bytes. " + source->getBlockReadSizeRationale(), dontSendNotification);
+    else
+        blockReadSizeRationaleLabel->setText ("Block read size is set manually in the editor", dontSendNotification);
+
+    editor->updateBlockReadSizeValue();
+}
+
+void AcquisitionSettingsComponent::updateThreadPolicy (AcquisitionThread thread)
+{
+    auto& controls = threadPolicyControls[(size_t) thread];
+
+    ThreadPolicy policy;
+    policy.core = controls.coreComboBox->getSelectedId() - 2;
+    policy.scheduling = (ThreadScheduling) (controls.schedulingComboBox->getSelectedId() - 1);
+    policy.priority = controls.priorityValue->getText().getIntValue();
+
+    source->setThreadPolicy (thread, policy);
+}
+
+void AcquisitionSettingsComponent::labelTextChanged (Label* l)
+{
+    if (l == targetLatencyValue.get())
+    {
+        updateBlockReadSize();
+        return;
+    }
+
+    if (l == metricsIntervalValue.get())
+    {
+        source->setMetricsInterval (l->getText().getIntValue());
+        l->setText (String (source->getMetricsInterval()), dontSendNotification);
+        return;
+    }
+
+    for (int i = 0; i < (int) AcquisitionThread::Count; i++)
+    {
+        if (l == threadPolicyControls[i].priorityValue.get())
+        {
+            auto priority = std::clamp (l->getText().getIntValue(), ThreadPolicy::MinPriority, ThreadPolicy::MaxPriority);
+            l->setText (String (priority), dontSendNotification);
+
+            updateThreadPolicy ((AcquisitionThread) i);
+            return;
+        }
+    }
+}
+
+void AcquisitionSettingsComponent::buttonClicked (Button* b)
+{
+    if (b == autoBlockReadSizeButton.get())
+    {
+        updateBlockReadSize();
+    }
+    else if (b == lowLatencyButton.get())
+    {
+        source->setDecodeInReaderThread (b->getToggleState());
+        decodeThreadsComboBox->setEnabled (! b->getToggleState());
+    }
+    else if (b == captureFramesButton.get())
+    {
+        source->setCaptureFrames (b->getToggleState());
+    }
+    else if (b == recordTraceButton.get())
+    {
+        source->setRecordTrace (b->getToggleState());
+    }
+    else if (b == advanceSampleNumbersButton.get())
+    {
+        source->setAdvanceSampleNumbersOnGaps (b->getToggleState());
+    }
+    else if (b == trackOffsetDriftButton.get())
+    {
+        source->setTrackOffsetDrift (b->getToggleState());
+    }
+    else if (b == captureDirectoryButton.get())
+    {
+        if (captureDirectoryChooser->browseForDirectory())
+        {
+            source->setCaptureDirectory (captureDirectoryChooser->getResult());
+            captureDirectoryValue->setText (source->getCaptureDirectory().getFullPathName(), dontSendNotification);
+        }
+    }
+}
+
+void AcquisitionSettingsComponent::comboBoxChanged (ComboBox* cb)
+{
+    if (cb == decodeThreadsComboBox.get())
+    {
+        source->setDecodeThreadCount (cb->getSelectedId() - 1);
+        return;
+    }
+
+    if (cb == metricsFormatComboBox.get())
+    {
+        source->setMetricsFormat ((MetricsLogger::Format) (cb->getSelectedId() - 1));
+        return;
+    }
+
+    for (int i = 0; i < (int) AcquisitionThread::Count; i++)
+    {
+        if (cb == threadPolicyControls[i].coreComboBox.get() || cb == threadPolicyControls[i].schedulingComboBox.get())
+        {
+            updateThreadPolicy ((AcquisitionThread) i);
+            return;
+        }
+    }
+}
@@ -0,0 +1,107 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <VisualizerEditorHeaders.h>
+
+#include "../ThreadPolicy.h"
+
+namespace OnixSourcePlugin
+{
+class OnixSource;
+class OnixSourceEditor;
+
+/**
+
+    Plugin-level acquisition settings, shown in a call-out box from the editor
+
+*/
+class AcquisitionSettingsComponent : public Component,
+                                     public ComboBox::Listener,
+                                     public Button::Listener,
+                                     public Label::Listener
+{
+public:
+    AcquisitionSettingsComponent (OnixSource* source, OnixSourceEditor* editor);
+
+    void comboBoxChanged (ComboBox* cb) override;
+    void buttonClicked (Button* b) override;
+    void labelTextChanged (Label* l) override;
+
+private:
+    OnixSource* source;
+    OnixSourceEditor* editor;
+
+    std::unique_ptr<ToggleButton> autoBlockReadSizeButton;
+
+    std::unique_ptr<Label> targetLatencyLabel;
+    std::unique_ptr<Label> targetLatencyValue;
+
+    std::unique_ptr<Label> blockReadSizeRationaleLabel;
+
+    std::unique_ptr<Label> decodeThreadsLabel;
+    std::unique_ptr<ComboBox> decodeThreadsComboBox;
+
+    std::unique_ptr<ToggleButton> lowLatencyButton;
+
+    std::unique_ptr<ToggleButton> captureFramesButton;
+    std::unique_ptr<Label> captureDirectoryValue;
+    std::unique_ptr<UtilityButton> captureDirectoryButton;
+    std::unique_ptr<FileChooser> captureDirectoryChooser;
+
+    std::unique_ptr<ToggleButton> recordTraceButton;
+
+    std::unique_ptr<Label> metricsIntervalLabel;
+    std::unique_ptr<Label> metricsIntervalValue;
+    std::unique_ptr<ComboBox> metricsFormatComboBox;
+
+    std::unique_ptr<ToggleButton> advanceSampleNumbersButton;
+
+    std::unique_ptr<ToggleButton> trackOffsetDriftButton;
+
+    std::unique_ptr<Label> threadPolicyLabel;
+
+    struct ThreadPolicyControls
+    {
+        std::unique_ptr<Label> nameLabel;
+        std::unique_ptr<ComboBox> coreComboBox;
+        std::unique_ptr<ComboBox> schedulingComboBox;
+        std::unique_ptr<Label> priorityValue;
+    };
+
+    std::array<ThreadPolicyControls, (size_t) AcquisitionThread::Count> threadPolicyControls;
+
+    void updateThreadPolicy (AcquisitionThread thread);
+
+    /** Applies a change to the automatic block read size settings, and shows the resulting block read size */
+    void updateBlockReadSize();
+
+    static constexpr int LabelWidth = 130;
+    static constexpr int ValueWidth = 100;
+    static constexpr int RowHeight = 20;
+    static constexpr int RowSpacing = 5;
+    static constexpr int PriorityWidth = 40;
+
+    JUCE_LEAK_DETECTOR (AcquisitionSettingsComponent);
+};
+} // namespace OnixSourcePlugin
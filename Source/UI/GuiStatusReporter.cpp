@@ -0,0 +1,67 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "GuiStatusReporter.h"
+
+using namespace OnixSourcePlugin;
+
+GuiStatusReporter::ProgressTaskWindow::ProgressTaskWindow (ProgressTask& task_)
+    : ThreadWithProgressWindow (task_.getTitle(), true, false),
+      task (task_)
+{
+}
+
+void GuiStatusReporter::ProgressTaskWindow::run()
+{
+    task.setProgressListener ([this] (double progress)
+                              { setProgress (progress); });
+
+    task.run();
+
+    task.setProgressListener (nullptr);
+}
+
+void GuiStatusReporter::showWarning (std::string title, std::string message)
+{
+    LOGD (message);
+    MessageManager::callAsync ([title, message]
+                               { AlertWindow::showMessageBoxAsync (
+                                     MessageBoxIconType::WarningIcon,
+                                     title,
+                                     message); });
+}
+
+void GuiStatusReporter::showStatus (std::string message)
+{
+    CoreServices::sendStatusMessage (message);
+}
+
+void GuiStatusReporter::requestStopAcquisition()
+{
+    CoreServices::setAcquisitionStatus (false);
+}
+
+void GuiStatusReporter::runTask (ProgressTask& task)
+{
+    ProgressTaskWindow window (task);
+    window.runThread();
+}
@@ -0,0 +1,60 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <VisualizerEditorHeaders.h>
+
+#include "../StatusReporter.h"
+
+namespace OnixSourcePlugin
+{
+/**
+
+    Shows warnings in message boxes, status messages in the GUI status bar, and runs tasks on a background
+    thread behind a modal progress window.
+
+*/
+class GuiStatusReporter : public StatusReporter
+{
+public:
+    void showWarning (std::string title, std::string message) override;
+    void showStatus (std::string message) override;
+    void requestStopAcquisition() override;
+    void runTask (ProgressTask& task) override;
+
+private:
+    /** Runs a ProgressTask on the thread of a ThreadWithProgressWindow, forwarding its progress to the window */
+    class ProgressTaskWindow : public ThreadWithProgressWindow
+    {
+    public:
+        ProgressTaskWindow (ProgressTask& task);
+
+        void run() override;
+
+    private:
+        ProgressTask& task;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProgressTaskWindow);
+    };
+};
+} // namespace OnixSourcePlugin
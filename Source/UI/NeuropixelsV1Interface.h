@@ -70,8 +70,8 @@ private:
 
     bool acquisitionIsActive = false;
 
-    static constexpr char* GainCalibrationFilename = "_gainCalValues.csv";
-    static constexpr char* AdcCalibrationFilename = "_ADCCalibration.csv";
+    static constexpr const char* GainCalibrationFilename = "_gainCalValues.csv";
+    static constexpr const char* AdcCalibrationFilename = "_ADCCalibration.csv";
 
     std::unique_ptr<ComboBox> electrodeConfigurationComboBox;
     std::unique_ptr<ComboBox> lfpGainComboBox;
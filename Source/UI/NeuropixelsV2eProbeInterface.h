@@ -72,7 +72,7 @@ private:
 
     const int probeIndex;
 
-    static constexpr char* GainCalibrationFilename = "_gainCalValues.csv";
+    static constexpr const char* GainCalibrationFilename = "_gainCalValues.csv";
 
     std::unique_ptr<ComboBox> electrodeConfigurationComboBox;
     std::unique_ptr<ComboBox> probeTypeComboBox;
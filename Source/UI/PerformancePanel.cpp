@@ -0,0 +1,161 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PerformancePanel.h"
+
+#include "../OnixSource.h"
+
+using namespace OnixSourcePlugin;
+
+PerformancePanel::PerformancePanel (OnixSource* source_)
+    : source (source_)
+{
+    setSize (NameWidth + ColumnWidth * 8, RowHeight * 2);
+}
+
+void PerformancePanel::startAcquisition()
+{
+    rows.clear();
+    lastUpdate = std::chrono::steady_clock::now();
+
+    startTimerHz (TimerFrequencyHz);
+}
+
+void PerformancePanel::stopAcquisition()
+{
+    stopTimer();
+    updateRows();
+    repaint();
+}
+
+void PerformancePanel::timerCallback()
+{
+    updateRows();
+    repaint();
+}
+
+void PerformancePanel::updateRows()
+{
+    auto devices = source->getEnabledDataSources();
+
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsedSeconds = std::chrono::duration<double> (now - lastUpdate).count();
+    lastUpdate = now;
+
+    // NB: Devices only change while acquisition is stopped, so rates are reset whenever the device list changes
+    if (rows.size() != devices.size())
+        rows.assign (devices.size(), DeviceRow());
+
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        const auto& device = devices[i];
+        auto& row = rows[i];
+
+        const uint64_t framesReceived = device->getFramesReceived();
+        const uint64_t bytesReceived = device->getBytesReceived();
+        const uint64_t samplesDecoded = device->getSamplesDecoded();
+
+        if (elapsedSeconds > 0.0 && row.name == device->getName())
+        {
+            row.framesPerSecond = (framesReceived - row.framesReceived) / elapsedSeconds;
+            row.bytesPerSecond = (bytesReceived - row.bytesReceived) / elapsedSeconds;
+            row.samplesPerSecond = (samplesDecoded - row.samplesDecoded) / elapsedSeconds;
+        }
+
+        row.name = device->getName();
+        row.framesReceived = framesReceived;
+        row.bytesReceived = bytesReceived;
+        row.samplesDecoded = samplesDecoded;
+
+        row.queueDepth = device->getFrameQueueDepth();
+        row.peakQueueDepth = device->getFrameQueueHighWaterMark();
+        row.queueCapacity = device->getFrameQueueCapacity();
+        row.droppedFrames = device->getFrameQueueOverflowCount();
+
+        row.readToBufferP99 = device->getLatencyProbe().getHistogram (LatencyProbe::Stage::ReadToBuffer).getPercentile (99.0);
+    }
+
+    const int height = RowHeight * ((int) rows.size() + 2);
+
+    if (getHeight() != height)
+        setSize (getWidth(), height);
+}
+
+void PerformancePanel::paint (Graphics& g)
+{
+    g.fillAll (findColour (ThemeColours::componentBackground));
+
+    const StringArray headers = { "Device", "Frames/s", "MB/s", "Samples/s", "Queue", "Peak queue", "Capacity", "Dropped", "p99 latency [us]" };
+
+    g.setFont (FontOptions ("Fira Code", 13.0f, Font::bold));
+    g.setColour (findColour (ThemeColours::defaultText));
+
+    int x = 5;
+
+    for (int i = 0; i < headers.size(); i++)
+    {
+        const int width = i == 0 ? NameWidth : ColumnWidth;
+        g.drawText (headers[i], x, 0, width - 5, RowHeight, i == 0 ? Justification::centredLeft : Justification::centredRight);
+        x += width;
+    }
+
+    g.setColour (findColour (ThemeColours::outline));
+    g.drawHorizontalLine (RowHeight, 0.0f, (float) getWidth());
+
+    g.setFont (FontOptions ("Fira Code", 13.0f, Font::plain));
+
+    constexpr int DroppedColumn = 7;
+
+    int y = RowHeight;
+
+    for (const auto& row : rows)
+    {
+        const StringArray values = {
+            row.name,
+            String (row.framesPerSecond, 0),
+            String (row.bytesPerSecond / 1e6, 2),
+            String (row.samplesPerSecond, 0),
+            String (row.queueDepth),
+            String (row.peakQueueDepth),
+            String (row.queueCapacity),
+            String (row.droppedFrames),
+            String (row.readToBufferP99 * 1e-3, 1)
+        };
+
+        x = 5;
+
+        for (int i = 0; i < values.size(); i++)
+        {
+            const int width = i == 0 ? NameWidth : ColumnWidth;
+
+            if (i == DroppedColumn && row.droppedFrames > 0)
+                g.setColour (Colours::red);
+            else
+                g.setColour (findColour (ThemeColours::defaultText));
+
+            g.drawText (values[i], x, y, width - 5, RowHeight, i == 0 ? Justification::centredLeft : Justification::centredRight);
+            x += width;
+        }
+
+        y += RowHeight;
+    }
+}
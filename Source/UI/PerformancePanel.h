@@ -0,0 +1,95 @@
+/*
+    ------------------------------------------------------------------
+
+    Copyright (C) Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#pragma once
+
+#include <VisualizerEditorHeaders.h>
+
+#include "../OnixDevice.h"
+
+namespace OnixSourcePlugin
+{
+class OnixSource;
+
+/**
+
+    Shows live throughput, frame queue depth, dropped frames, and latency for each enabled device.
+
+    All values are read from relaxed atomic counters that the acquisition threads update, so
+    showing this panel does not slow down acquisition.
+
+*/
+class PerformancePanel : public Component,
+                         public Timer
+{
+public:
+    PerformancePanel (OnixSource* source);
+
+    void paint (Graphics& g) override;
+
+    void timerCallback() override;
+
+    /** Starts updating the panel at TimerFrequencyHz */
+    void startAcquisition();
+
+    /** Stops updating the panel. The last values remain visible. */
+    void stopAcquisition();
+
+    static constexpr int TimerFrequencyHz = 4;
+
+private:
+    OnixSource* source;
+
+    struct DeviceRow
+    {
+        std::string name;
+
+        uint64_t framesReceived = 0;
+        uint64_t bytesReceived = 0;
+        uint64_t samplesDecoded = 0;
+
+        double framesPerSecond = 0.0;
+        double bytesPerSecond = 0.0;
+        double samplesPerSecond = 0.0;
+
+        size_t queueDepth = 0;
+        size_t peakQueueDepth = 0;
+        size_t queueCapacity = 0;
+        uint64_t droppedFrames = 0;
+
+        int64_t readToBufferP99 = 0;
+    };
+
+    std::vector<DeviceRow> rows;
+
+    std::chrono::steady_clock::time_point lastUpdate;
+
+    /** Reads the current counters from every enabled device, and computes rates since the last update */
+    void updateRows();
+
+    static constexpr int RowHeight = 20;
+    static constexpr int NameWidth = 240;
+    static constexpr int ColumnWidth = 110;
+
+    JUCE_LEAK_DETECTOR (PerformancePanel);
+};
+} // namespace OnixSourcePlugin